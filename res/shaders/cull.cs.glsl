@@ -0,0 +1,126 @@
+#version 460 core
+
+layout (local_size_x = 64) in;
+
+#include "include/draws.glsl"
+
+// mesh of a model instance, matches GpuCullObject
+struct CullObject
+{
+    vec4 center;
+    vec4 extents;
+
+    uint drawIndex;
+    uint materialId;
+    uint bucket;
+    uint firstCommand;
+
+    uint indicesCount;
+    uint firstIndex;
+    int baseVertex;
+    uint shadowBucket;
+
+    uint shadowIndicesCount;
+    uint shadowFirstIndex;
+    int shadowBaseVertex;
+    uint shadowFirstCommand;
+};
+
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 3) readonly buffer CullObjects
+{
+    CullObject objects[];
+};
+
+// planes of the camera frustum, followed by the planes of each cascade
+layout (std430, binding = 4) readonly buffer Frusta
+{
+    vec4 planes[];
+};
+
+layout (std430, binding = 5) writeonly buffer DrawCommands
+{
+    DrawCommand commands[];
+};
+
+// visible meshes of each bucket, G-pass buckets go first
+layout (std430, binding = 6) buffer DrawCounts
+{
+    uint counts[];
+};
+
+// MAX_CASCADES instances are reserved per mesh, one per cascade it is visible in
+layout (std430, binding = 7) writeonly buffer ShadowInstances
+{
+    DrawInstance shadowInstances[];
+};
+
+uniform int objectsCount;
+uniform int cascadesCount;
+
+const uint noBucket = 0xFFFFFFFFu;
+const uint noMaterial = 0xFFFFFFFFu;
+
+// false if the box is completely outside of the frustum
+bool IsVisible(vec3 center, vec3 extents, int frustum)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        vec4 plane = planes[frustum * 6 + i];
+        if (dot(plane.xyz, center) + plane.w < -dot(abs(plane.xyz), extents))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void main()
+{
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= uint(objectsCount))
+    {
+        return;
+    }
+
+    CullObject object = objects[id];
+    vec3 center = object.center.xyz;
+    vec3 extents = object.extents.xyz;
+
+    // G-pass instance of the mesh is written by the CPU at the index of the mesh
+    if (object.indicesCount > 0 && IsVisible(center, extents, 0))
+    {
+        uint slot = atomicAdd(counts[object.bucket], 1u);
+        commands[object.firstCommand + slot] = DrawCommand(object.indicesCount, 1u, object.firstIndex, object.baseVertex, id);
+    }
+
+    if (object.shadowBucket == noBucket || object.shadowIndicesCount == 0)
+    {
+        return;
+    }
+
+    uint firstInstance = id * uint(MAX_CASCADES);
+    uint layers = 0;
+    for (int cascade = 0; cascade < cascadesCount; cascade++)
+    {
+        if (IsVisible(center, extents, 1 + cascade))
+        {
+            shadowInstances[firstInstance + layers] = DrawInstance(object.drawIndex, noMaterial, uint(cascade));
+            layers++;
+        }
+    }
+
+    if (layers > 0)
+    {
+        uint slot = atomicAdd(counts[object.shadowBucket], 1u);
+        commands[object.shadowFirstCommand + slot] = DrawCommand(object.shadowIndicesCount, layers, object.shadowFirstIndex, object.shadowBaseVertex, firstInstance);
+    }
+}
\ No newline at end of file
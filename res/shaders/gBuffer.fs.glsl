@@ -1,4 +1,8 @@
-#version 330 core
+#version 460 core
+
+#ifdef BINDLESS_TEXTURES
+#extension GL_ARB_bindless_texture : require
+#endif
 
 layout (location = 0) out vec3 gPosition;
 layout (location = 1) out vec3 gNormal;
@@ -12,40 +16,28 @@ in mat3 TBN;
 in vec3 Normal;
 in vec3 FragPos;
 in vec2 TexCoords;
+flat in int TilingFactor;
+flat in int ShouldBeLit;
+flat in uint MaterialId;
 
-struct Material
-{
-    bool shouldBeLit;
-    bool hasNormalTexture;
-    bool hasDiffuseTexture;
-    bool hasSpecularTexture;
-    bool hasRoughnessTexture;
-    bool hasMetallicTexture;
-
-    int tilingFactor;
-
-    float specular;
-    float metallic;
-    float roughness;
+// variants per set of the resident material maps, the missing ones are replaced by the material parameters
+#pragma keywords DIFFUSE_MAP NORMAL_MAP SPECULAR_MAP METALLIC_MAP ROUGHNESS_MAP
 
-    sampler2D mapNormal_1;
-    sampler2D mapDiffuse_1;
-    sampler2D mapSpecular_1;
-    sampler2D mapMetallic_1;
-    sampler2D mapRoughness_1;
-
-    vec4 colorDiffuse;
-};
-
-uniform Material material;
+#include "include/material.glsl"
 
 void main()
 {
-    vec2 texCoords = TexCoords * material.tilingFactor;
-    vec4 diffuseColor = material.hasDiffuseTexture ? texture(material.mapDiffuse_1, texCoords) : material.colorDiffuse;
+    MaterialData material = materials[MaterialId];
+    vec2 texCoords = TexCoords * TilingFactor;
 
-    // support of masked textures
-    if(diffuseColor.a < 1.0)
+#ifdef DIFFUSE_MAP
+    vec4 diffuseColor = texture(MATERIAL_MAP(DIFFUSE), texCoords);
+#else
+    vec4 diffuseColor = material.colorDiffuse;
+#endif
+
+    // support of masked textures, alpha is interpolated by the block compression and mip filtering, so half is a cutoff
+    if(diffuseColor.a < 0.5)
     {
         discard;
     }
@@ -55,18 +47,38 @@ void main()
     gAlbedoSpec.rgb = diffuseColor.rgb;
 
     // also store the per-fragment normals into the gbuffer
-    gNormal = material.hasNormalTexture ? normalize((texture( material.mapNormal_1, texCoords).rgb * 2.0 - 1.0) * TBN) : normalize(Normal);
+    // normal maps are compressed to two channels, so Z is reconstructed
+#ifdef NORMAL_MAP
+    vec2 normalXY = texture(MATERIAL_MAP(NORMAL), texCoords).rg * 2.0 - 1.0;
+    vec3 normal = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
+    gNormal = normalize(normal * TBN);
+#else
+    gNormal = normalize(Normal);
+#endif
 
-    if (!material.shouldBeLit)
+    if (ShouldBeLit == 0)
     {
         gAlbedoSpec.a = -1.0;
     }
     else
     {
         //specular color is stored into alpha chanel
-        gAlbedoSpec.a = material.hasSpecularTexture ? texture(material.mapSpecular_1, texCoords).r : material.specular;
+#ifdef SPECULAR_MAP
+        gAlbedoSpec.a = texture(MATERIAL_MAP(SPECULAR), texCoords).r;
+#else
+        gAlbedoSpec.a = material.specular;
+#endif
     }
 
-    gMetallic = material.hasMetallicTexture ? texture(material.mapMetallic_1, texCoords).r : material.metallic;
-    gRoughness = material.hasRoughnessTexture ? texture(material.mapRoughness_1, texCoords).r : material.roughness;
+#ifdef METALLIC_MAP
+    gMetallic = texture(MATERIAL_MAP(METALLIC), texCoords).r;
+#else
+    gMetallic = material.metallic;
+#endif
+
+#ifdef ROUGHNESS_MAP
+    gRoughness = texture(MATERIAL_MAP(ROUGHNESS), texCoords).r;
+#else
+    gRoughness = material.roughness;
+#endif
 }
\ No newline at end of file
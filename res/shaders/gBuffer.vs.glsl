@@ -1,33 +1,44 @@
-#version 330 core
+#version 460 core
 layout (location = 0) in vec3 aPos;
+// normal and tangent are stored as 10-10-10-2 signed normalized, texture coordinates as half floats; all of them
+// are decoded by the vertex fetch. Tangent w stores the bitangent sign
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 3) in vec3 aTangent;
-layout (location = 4) in vec3 aBitangent;
+layout (location = 3) in vec4 aTangent;
 
 out mat3 TBN;
 out vec3 Normal;
 out vec3 FragPos;
 out vec2 TexCoords;
+flat out int TilingFactor;
+flat out int ShouldBeLit;
+flat out uint MaterialId;
+
+#include "include/draws.glsl"
 
 uniform mat4 view;
-uniform mat4 model;
 uniform mat4 projection;
-uniform mat3 normalMatrix;
 
 void main()
 {
-    vec4 worldPos = model * vec4(aPos, 1.0);
+    DrawInstance instance = instances[gl_BaseInstance + gl_InstanceID];
+    DrawData draw = draws[instance.drawIndex];
+    MaterialId = instance.materialId;
+    mat3 normalMatrix = mat3(draw.normalMatrix);
+    TilingFactor = draw.material.x;
+    ShouldBeLit = draw.material.y;
+
+    vec4 worldPos = draw.model * vec4(aPos, 1.0);
     FragPos = worldPos.xyz;
     TexCoords = aTexCoords;
 
 //    mat3 normalMatrix = transpose(inverse(mat3(model)));
     Normal = normalMatrix * aNormal;
 
-    vec3 T = normalize(normalMatrix * aTangent);
+    vec3 T = normalize(normalMatrix * aTangent.xyz);
     vec3 N = normalize(normalMatrix * aNormal);
     T = normalize(T - dot(T, N) * N);
-    vec3 B = cross(N, T);
+    vec3 B = cross(N, T) * aTangent.w;
     TBN = transpose(mat3(T, B, N));
 
     gl_Position = projection * view * worldPos;
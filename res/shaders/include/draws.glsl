@@ -0,0 +1,25 @@
+// mesh draw, indexed by the base instance of the draw command and the instance ID
+struct DrawInstance
+{
+    uint drawIndex;
+    uint materialId;
+    uint layer;
+};
+
+// per draw data of the model instance, shared by all of its meshes
+struct DrawData
+{
+    mat4 model;
+    mat4 normalMatrix;
+    ivec4 material;
+};
+
+layout (std430, binding = 0) readonly buffer DrawsData
+{
+    DrawData draws[];
+};
+
+layout (std430, binding = 1) readonly buffer DrawInstances
+{
+    DrawInstance instances[];
+};
@@ -0,0 +1,30 @@
+// texture types, indices of the handles and the material map keywords
+const uint DIFFUSE = 0;
+const uint NORMAL = 1;
+const uint SPECULAR = 2;
+const uint METALLIC = 3;
+const uint ROUGHNESS = 4;
+
+// interned material, indexed by the material ID of the draw
+struct MaterialData
+{
+    vec4 colorDiffuse;
+    float specular;
+    float metallic;
+    float roughness;
+    uint textureMask;
+    uvec2 handles[5];
+};
+
+layout (std430, binding = 2) readonly buffer Materials
+{
+    MaterialData materials[];
+};
+
+#ifdef BINDLESS_TEXTURES
+#define MATERIAL_MAP(type) sampler2D(material.handles[type])
+#else
+// bound to the texture units by the material ID, if bindless textures are not supported
+layout (binding = 0) uniform sampler2D materialMaps[5];
+#define MATERIAL_MAP(type) materialMaps[type]
+#endif
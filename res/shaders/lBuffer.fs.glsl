@@ -6,10 +6,11 @@ out vec4 FragColor;
 
 in vec2 TexCoords;
 
+// lighting of the scene and the debug views, Lit view is the one without the DEBUG_ keywords
+#pragma keywords DIRECTIONAL_LIGHT SHADOWS DEBUG_LIGHTING DEBUG_DIRECTIONAL_LIGHTING DEBUG_POINT_LIGHTING DEBUG_DIFFUSE DEBUG_NORMALS DEBUG_SPECULAR DEBUG_SHADOWS DEBUG_ROUGHNESS
+
 struct DirectionalLight
 {
-    bool isPresent;
-
     vec3 direction;
 
     vec3 ambient;
@@ -48,7 +49,6 @@ uniform PointLight pointLights[MaxPointLightAmount];
 
 uniform DirectionalLight dLight;
 
-uniform int drawMode;
 uniform int cascadeCount;
 
 uniform float farPlane;
@@ -79,9 +79,6 @@ float rand(vec2 co)
 
 void main()
 {
-    FragColor = vec4(texture(dLight.mapShadow, vec3(TexCoords, 0)).r, 1.0 - texture(dLight.mapShadow, vec3(TexCoords, 0)).r, 0.0, 1.0);
-//    return;
-
     // retrieve data from gbuffer
     vec3 fragPosition = texture(gPosition, TexCoords).rgb;
     vec3 normalVector = texture(gNormal, TexCoords).rgb;
@@ -92,6 +89,20 @@ void main()
     float metallicFactor = texture(gMetallic, TexCoords).r;
     float roughnessFactor = texture(gRoughness, TexCoords).r;
 
+#if defined(DEBUG_DIFFUSE)
+    FragColor = vec4(diffuseColor, 1.0);
+    return;
+#elif defined(DEBUG_NORMALS)
+    FragColor = vec4(normalVector, 1.0);
+    return;
+#elif defined(DEBUG_SPECULAR)
+    FragColor = vec4(vec3(specularFactor), 1.0);
+    return;
+#elif defined(DEBUG_ROUGHNESS)
+    FragColor = vec4(vec3(roughnessFactor), 1.0);
+    return;
+#endif
+
     if(specularFactor == -1.0)
     {
         FragColor = vec4(diffuseColor, 1.0);
@@ -103,42 +114,32 @@ void main()
     vec3 ambientLighting  = vec3(0.0, 0.0, 0.0);
     vec3 specularLighting = vec3(0.0, 0.0, 0.0);
 
-    if (dLight.isPresent)
-    {
-        shadowFactor = CalculateDirecionalShadowFactor(normalize(-dLight.direction), normalVector, viewDirection, fragPosition);
-        ambientLighting  += CalculateDirectionalAmbientLighting(dLight, normalVector, viewDirection);
-        diffuseLighting  += CalculateDirectionalDiffuseLighting(dLight, normalVector, viewDirection)  * clamp(1.0 - shadowFactor, 0.0, 1.0);
-        specularLighting += CalculateDirectionalSpecularLighting(dLight, normalVector, viewDirection) * clamp(1.0 - shadowFactor, 0.0, 1.0);
-    }
+#if defined(DIRECTIONAL_LIGHT) && !defined(DEBUG_POINT_LIGHTING)
+#ifdef SHADOWS
+    shadowFactor = CalculateDirecionalShadowFactor(normalize(-dLight.direction), normalVector, viewDirection, fragPosition);
+#endif
+    ambientLighting  += CalculateDirectionalAmbientLighting(dLight, normalVector, viewDirection);
+    diffuseLighting  += CalculateDirectionalDiffuseLighting(dLight, normalVector, viewDirection)  * clamp(1.0 - shadowFactor, 0.0, 1.0);
+    specularLighting += CalculateDirectionalSpecularLighting(dLight, normalVector, viewDirection) * clamp(1.0 - shadowFactor, 0.0, 1.0);
+#endif
 
+#ifndef DEBUG_DIRECTIONAL_LIGHTING
     for(int i = 0; i < (pointLightsCount > MaxPointLightAmount ? MaxPointLightAmount : pointLightsCount); i++)
     {
         diffuseLighting  += CalculatePointDiffuseLighting(pointLights[i], normalVector, viewDirection , fragPosition);
         ambientLighting  += CalculatePointAmbientLighting(pointLights[i], normalVector, viewDirection , fragPosition);
         specularLighting += CalculatePointSpecularLighting(pointLights[i], normalVector, viewDirection, fragPosition);
     }
-
-    vec3 finalColor = (diffuseLighting + ambientLighting + specularLighting * specularFactor) * diffuseColor;
-    if (drawMode == 1)
-    {
-        FragColor = vec4(finalColor, 1.0);
-    }
-    else if (drawMode == 2)
-    {
-        FragColor = vec4(normalVector, 1.0);
-    }
-    else if (drawMode == 3)
-    {
-        FragColor = vec4(diffuseColor, 1.0);
-    }
-    else if (drawMode == 3)
-    {
-        FragColor = vec4(viewDirection, 1.0);
-    }
-    else if (drawMode == 5)
-    {
-        FragColor = vec4(0.0 + shadowFactor, 1.0 - shadowFactor, 0.1, 1.0);
-    }
+#endif
+
+    vec3 lighting = diffuseLighting + ambientLighting + specularLighting * specularFactor;
+#if defined(DEBUG_SHADOWS)
+    FragColor = vec4(0.0 + shadowFactor, 1.0 - shadowFactor, 0.1, 1.0);
+#elif defined(DEBUG_LIGHTING) || defined(DEBUG_DIRECTIONAL_LIGHTING) || defined(DEBUG_POINT_LIGHTING)
+    FragColor = vec4(lighting, 1.0);
+#else
+    FragColor = vec4(lighting * diffuseColor, 1.0);
+#endif
 }
 
 vec3 CalculateDirectionalDiffuseLighting(DirectionalLight light, vec3 normal, vec3 viewDir)
@@ -1,12 +1,40 @@
-#version 330 core
+#version 460 core
+
+// variant without the vertex shader layer output, cascades are drawn one by one then
+#pragma keywords LAYER_PER_PASS
+
+#ifndef LAYER_PER_PASS
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+#endif
+
 layout (location = 0) in vec3 aPos;
+// normal is absent in the position only stream and reads as zero, its offset is baked into the positions there
 layout (location = 1) in vec3 aNormal;
 
-uniform mat4 model;
-uniform vec3 lightDir;
+#include "include/draws.glsl"
 
+layout (std140, binding = 0) uniform LightSpaceMatrices
+{
+    mat4 lightSpaceMatrices[16];
+};
+
+#ifdef LAYER_PER_PASS
+// cascade being drawn
+uniform int layer;
+#endif
 
 void main()
 {
-    gl_Position = model * vec4(aPos - 0.005 * aNormal, 1.0);
+    // instance per cascade the caster is visible in
+    DrawInstance instance = instances[gl_BaseInstance + gl_InstanceID];
+    vec4 worldPos = draws[instance.drawIndex].model * vec4(aPos - 0.005 * aNormal, 1.0);
+
+#ifdef LAYER_PER_PASS
+    // instances of the other cascades are collapsed into a point outside of the clip volume
+    gl_Position = int(instance.layer) == layer ? lightSpaceMatrices[instance.layer] * worldPos : vec4(2.0, 2.0, 2.0, 1.0);
+#else
+    gl_Position = lightSpaceMatrices[instance.layer] * worldPos;
+    gl_Layer = int(instance.layer);
+#endif
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 //
 
 #include "MainLoop.h"
+#include "ThreadPool.hpp"
 #include "ResourcesManager.h"
 #include "Application.h"
 #include "../Render/Renderer.h"
@@ -59,6 +60,7 @@ void Application::Destroy()
 
     Renderer::ShutDown();
     ResourcesManager::ShutDown();
+    ThreadPool::ShutDown();
 
     Window::Terminate();
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "CacheFile.h"
+
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+bool CacheFile::GetSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time)
+{
+    std::error_code error;
+    size = static_cast<uint64_t>(std::filesystem::file_size(sourcePath, error));
+    if (error)
+    {
+        return false;
+    }
+    time = static_cast<int64_t>(std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count());
+    return !error;
+}
+
+bool CacheFile::UpdateSourceTime(const std::string& cachePath, uint64_t offset, int64_t time)
+{
+    // patched in place, the rest of the file is kept as is
+    std::fstream fs(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+    if (!fs.is_open())
+    {
+        return false;
+    }
+
+    fs.seekp(static_cast<std::streamoff>(offset));
+    fs.write(reinterpret_cast<const char *>(&time), sizeof(time));
+    return fs.good();
+}
+
+void CacheFile::WriteAt(std::ostream& os, uint64_t position, const void * bytes, uint64_t size)
+{
+    const char padding[sectionAlignment] = {};
+    for (auto current = static_cast<uint64_t>(os.tellp()); current < position && os; current = static_cast<uint64_t>(os.tellp()))
+    {
+        os.write(padding, static_cast<std::streamsize>(std::min<uint64_t>(position - current, sizeof(padding))));
+    }
+    os.write(static_cast<const char *>(bytes), static_cast<std::streamsize>(size));
+}
+
+bool CacheFile::Write(const std::string& cachePath, const std::function<void(std::ostream&)>& write)
+{
+    const std::string tempPath = cachePath + ".tmp";
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+
+    std::ofstream os(tempPath, std::ios::binary | std::ios::trunc);
+    if (!os.is_open())
+    {
+        return false;
+    }
+
+    write(os);
+
+    bool isWritten = os.good();
+    os.close();
+
+    if (isWritten)
+    {
+        std::filesystem::rename(tempPath, cachePath, error);
+    }
+    if (!isWritten || error)
+    {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
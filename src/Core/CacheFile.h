@@ -0,0 +1,76 @@
+#ifndef GRAPHICS_CACHEFILE_H
+#define GRAPHICS_CACHEFILE_H
+
+#include <string>
+#include <cstdint>
+#include <ostream>
+#include <functional>
+
+/**
+ * Helpers shared by the binary caches: section layout, bounds checks of the mapped data, source file stamps and
+ * writing the cache files
+ */
+namespace CacheFile
+{
+    /* Alignment of every section of a cache file, in bytes */
+    constexpr uint64_t sectionAlignment = 16;
+
+    /**
+     * @param offset offset in the file
+     * @return offset rounded up to the section alignment
+     */
+    inline uint64_t Align(uint64_t offset)
+    {
+        return (offset + sectionAlignment - 1) & ~(sectionAlignment - 1);
+    }
+
+    /**
+     * @param offset offset of the block
+     * @param size size of the block
+     * @param fileSize size of the file
+     * @return true if the block lies entirely within the file
+     */
+    inline bool IsInRange(uint64_t offset, uint64_t size, uint64_t fileSize)
+    {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+
+    /**
+     * Reads source file size and modification time
+     * @param sourcePath path to the source file
+     * @param size source file size
+     * @param time source file modification time
+     * @return false if source file is not accessible
+     */
+    bool GetSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time);
+
+    /**
+     * Overwrites source modification time, stored in the header of the cache file. Used once the content hash proved
+     * the source unchanged, so the next launches pass the stamp check without hashing the source again
+     * @param cachePath path to the cache file
+     * @param offset offset of the time in the file
+     * @param time source file modification time
+     * @return true if the time was written
+     */
+    bool UpdateSourceTime(const std::string& cachePath, uint64_t offset, int64_t time);
+
+    /**
+     * Writes the block at the given position, zero-filling the gap after the current one
+     * @param os stream to write to
+     * @param position position of the block, not before the current one
+     * @param bytes block to write
+     * @param size block size, in bytes
+     */
+    void WriteAt(std::ostream& os, uint64_t position, const void * bytes, uint64_t size);
+
+    /**
+     * Writes the cache file, creating its directory if needed. The file is written into a temporary one first, which
+     * then replaces it, so an interrupted save never leaves a half written cache behind
+     * @param cachePath path to the cache file
+     * @param write writes the contents of the file
+     * @return true if the file was written
+     */
+    bool Write(const std::string& cachePath, const std::function<void(std::ostream&)>& write);
+}
+
+#endif //GRAPHICS_CACHEFILE_H
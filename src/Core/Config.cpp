@@ -6,10 +6,18 @@
 #include "Config.h"
 #include "ResourcesManager.h"
 #include "EngineException.h"
+#include "../Render/MeshCache.h"
+#include "../Render/ModelCache.h"
+#include "../Render/TextureCache.h"
+#include "../Render/ProgramCache.h"
+#include "../Render/TextureCompressor.h"
 #include "inipp.h"
 #include "json.hpp"
 #include "../Logging/easylogging++.h"
 
+#include <chrono>
+#include <algorithm>
+
 
 void Config::LoadIni(const std::string &configPath)
 {
@@ -21,6 +29,15 @@ void Config::LoadIni(const std::string &configPath)
     std::string windowName        = "OpenGL Drawer";
     std::string defaultScenePath  = "../res/scenes/defaultScene.json";
     std::string shadersConfigPath = "config.json";
+    bool useBindlessTextures = true;
+    std::string meshCacheDirectory = "../res/cache/meshes";
+    int modelCacheBudget = 256;
+    bool keepMeshCpuData = false;
+    std::string textureCacheDirectory = "../res/cache/textures";
+    bool compressTextures = true;
+    bool useBC7 = true;
+    std::string programCacheDirectory = "../res/cache/programs";
+    bool cacheShaderPrograms = true;
 
     std::ifstream is(configPath);
 
@@ -43,6 +60,31 @@ void Config::LoadIni(const std::string &configPath)
     windowHeight = windowHeight > 399 ? windowHeight : 400;
 
     inipp::get_value(ini.sections["SHADERS"], "shadersConfigPath", shadersConfigPath);
+    inipp::get_value(ini.sections["SHADERS"], "useBindlessTextures", useBindlessTextures);
+
+    inipp::get_value(ini.sections["CACHE"], "meshCacheDirectory", meshCacheDirectory);
+    MeshCache::SetCacheDirectory(meshCacheDirectory);
+
+    inipp::get_value(ini.sections["CACHE"], "modelCacheBudget", modelCacheBudget);
+    ModelCache::SetBudget(static_cast<size_t>(std::max(modelCacheBudget, 0)) * 1024 * 1024);
+
+    inipp::get_value(ini.sections["CACHE"], "keepMeshCpuData", keepMeshCpuData);
+    Model::SetKeepCpuData(keepMeshCpuData);
+
+    inipp::get_value(ini.sections["CACHE"], "textureCacheDirectory", textureCacheDirectory);
+    TextureCache::SetCacheDirectory(textureCacheDirectory);
+
+    inipp::get_value(ini.sections["CACHE"], "compressTextures", compressTextures);
+    TextureCompressor::SetEnabled(compressTextures);
+
+    inipp::get_value(ini.sections["CACHE"], "useBC7", useBC7);
+    TextureCompressor::SetUseBC7(useBC7);
+
+    inipp::get_value(ini.sections["CACHE"], "programCacheDirectory", programCacheDirectory);
+    ProgramCache::SetCacheDirectory(programCacheDirectory);
+
+    inipp::get_value(ini.sections["CACHE"], "cacheShaderPrograms", cacheShaderPrograms);
+    ProgramCache::SetEnabled(cacheShaderPrograms);
 
     is.close();
     LOG(INFO) << configPath << " successfully loaded";
@@ -50,6 +92,13 @@ void Config::LoadIni(const std::string &configPath)
     /* All the exceptions are handled in Global::Init method */
     Window::Initialize(windowWidth, windowHeight, windowName, windowFullScreen);
 
+    // support is known only once the context is created, and has to be known before the shaders are compiled
+    Texture::SetBindlessEnabled(useBindlessTextures);
+    if (Texture::IsBindlessEnabled())
+    {
+        Shader::AddGlobalDefine("BINDLESS_TEXTURES");
+    }
+
     Config::LoadJson(shadersConfigPath);
     ResourcesManager::RegisterPlayerScene(defaultScenePath);
 }
@@ -65,15 +114,25 @@ void Config::LoadJson(const std::string &jsonConfigPath)
 
     ASSERT(!data.empty(), "Json file is empty");
 
+    const auto start = std::chrono::steady_clock::now();
+    const size_t hits = ProgramCache::GetHitsCount(), misses = ProgramCache::GetMissesCount();
+    const bool isParallel = Shader::EnableParallelCompile();
+
+    // compilation of all the shaders is started first, results are only waited for once the driver has all of them
     for (const auto& shader : data["Shaders"].items())
     {
         if(!shader.value()[2].is_null())
         {
-            ResourcesManager::RegisterShader(shader.key(), shader.value()[0], shader.value()[1], shader.value()[2]);
+            ResourcesManager::RegisterShader(shader.key(), shader.value()[0], shader.value()[1], shader.value()[2], true);
         }
         else
         {
-            ResourcesManager::RegisterShader(shader.key(), shader.value()[0], shader.value()[1]);
+            ResourcesManager::RegisterShader(shader.key(), shader.value()[0], shader.value()[1], "", true);
         }
     }
+    ResourcesManager::LinkShaders();
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG(INFO) << "Shaders loaded in " << elapsed << " ms: " << ProgramCache::GetHitsCount() - hits << " cache hits, "
+              << ProgramCache::GetMissesCount() - misses << " cache misses" << (isParallel ? ", compiled in parallel" : "");
 }
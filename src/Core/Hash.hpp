@@ -0,0 +1,97 @@
+#ifndef GRAPHICS_HASH_HPP
+#define GRAPHICS_HASH_HPP
+
+#include <string>
+#include <cstdint>
+#include <fstream>
+#include <string_view>
+
+namespace Hash
+{
+    constexpr uint64_t fnvOffsetBasis = 14695981039346656037ULL;
+    constexpr uint64_t fnvPrime       = 1099511628211ULL;
+
+    /**
+     * 64-bit FNV-1a hash
+     * @param data data to hash
+     * @param size data size, in bytes
+     * @param seed previous hash value, to continue hashing
+     * @return hash value
+     */
+    inline uint64_t Fnv1a(const void * data, size_t size, uint64_t seed = fnvOffsetBasis)
+    {
+        const auto * bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            seed = (seed ^ bytes[i]) * fnvPrime;
+        }
+        return seed;
+    }
+
+    /**
+     * 64-bit FNV-1a hash of a string
+     * @param str string to hash
+     * @param seed previous hash value, to continue hashing
+     * @return hash value
+     */
+    inline uint64_t Fnv1a(const std::string& str, uint64_t seed = fnvOffsetBasis)
+    {
+        return Fnv1a(str.data(), str.size(), seed);
+    }
+
+    /**
+     * 64-bit FNV-1a hash, which can be evaluated at compile time. Matches the runtime one for the same characters
+     * @param str string to hash
+     * @param seed previous hash value, to continue hashing
+     * @return hash value
+     */
+    constexpr uint64_t Fnv1aConstexpr(std::string_view str, uint64_t seed = fnvOffsetBasis)
+    {
+        for (const char c : str)
+        {
+            seed = (seed ^ static_cast<unsigned char>(c)) * fnvPrime;
+        }
+        return seed;
+    }
+
+    /**
+     * Hashes the whole file content
+     * @param path path to the file
+     * @return hash value, or 0 if file can not be opened
+     */
+    inline uint64_t HashFile(const std::string& path)
+    {
+        std::ifstream is(path, std::ios::binary);
+        if (!is.is_open())
+        {
+            return 0;
+        }
+
+        char buffer[64 * 1024];
+        uint64_t hash = fnvOffsetBasis;
+        while (is.read(buffer, sizeof(buffer)) || is.gcount() > 0)
+        {
+            hash = Fnv1a(buffer, static_cast<size_t>(is.gcount()), hash);
+        }
+        return hash;
+    }
+
+    /**
+     * Formats hash as a fixed length hexadecimal string, useful for file names
+     * @param hash hash value
+     * @return hexadecimal string
+     */
+    inline std::string ToHex(uint64_t hash)
+    {
+        constexpr char digits[] = "0123456789abcdef";
+        std::string result(16, '0');
+        for (int i = 15; i >= 0; i--)
+        {
+            result[i] = digits[hash & 0xF];
+            hash >>= 4;
+        }
+        return result;
+    }
+}
+
+#endif //GRAPHICS_HASH_HPP
@@ -5,6 +5,7 @@
 #include "MainLoop.h"
 #include "Config.h"
 #include "Profiler.hpp"
+#include "ThreadPool.hpp"
 #include "../Entity/Entity.h"
 #include "../Render/Renderer.h"
 #include "../Editor/EditorLayer.h"
@@ -18,6 +19,8 @@ void MainLoop::Initialize()
 
     try
     {
+        // workers are needed before the scene is loaded
+        ThreadPool::Initialize();
         Config::LoadIni("config.ini");
         EventsHandler::Initialize();
         Renderer::Initialize();
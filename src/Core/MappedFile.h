@@ -0,0 +1,55 @@
+#ifndef GRAPHICS_MAPPEDFILE_H
+#define GRAPHICS_MAPPEDFILE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Read-only memory mapping of a whole file. The pages are loaded by the OS on first access,
+ * so opening even a large file costs next to nothing until the data is actually read
+ */
+class MappedFile
+{
+public:
+    MappedFile(MappedFile&&) = delete;
+    MappedFile(const MappedFile&) = delete;
+
+    /**
+     * Maps the file into the process address space. Check IsOpen() to know if mapping succeeded
+     * @param path path to the file
+     */
+    explicit MappedFile(const std::string& path);
+
+    /**
+     * Unmaps the file
+     */
+    ~MappedFile();
+
+    /**
+     * @return true if file was successfully mapped
+     */
+    [[nodiscard]] inline bool IsOpen() const { return data != nullptr; }
+
+    /**
+     * @return pointer to the first byte of the file
+     */
+    [[nodiscard]] inline const uint8_t * GetData() const { return data; }
+
+    /**
+     * @return size of the mapped file, in bytes
+     */
+    [[nodiscard]] inline size_t GetSize() const { return size; }
+
+private:
+    const uint8_t * data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    void * fileHandle = nullptr;
+    void * mappingHandle = nullptr;
+#endif
+};
+
+
+#endif //GRAPHICS_MAPPEDFILE_H
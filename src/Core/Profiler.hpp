@@ -5,6 +5,9 @@
 #ifndef GRAPHICS_PROFILER_HPP
 #define GRAPHICS_PROFILER_HPP
 
+#define GLEW_STATIC
+#include "glew.h"
+
 #include <chrono>
 
 // based on this: https://stackoverflow.com/a/21995693/14504988
@@ -34,11 +37,65 @@ public:
     }
 };
 
+/**
+ * Measures GPU time of the commands between tick() and tock() with the timer queries. Results are read a few frames
+ * later, so the CPU never waits for the GPU. Timers must not overlap, as GL_TIME_ELAPSED queries can not be nested
+ */
+class GpuTimer
+{
+    static constexpr int queriesCount = 3;
+
+    unsigned int queries[queriesCount] = {};
+    bool isPending[queriesCount] = {};
+    int current = 0;
+    double lastMilliseconds = 0.0;
+
+public:
+    void tick()
+    {
+        if (queries[0] == 0)
+        {
+            glGenQueries(queriesCount, queries);
+        }
+        glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+    }
+
+    void tock()
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        isPending[current] = true;
+        current = (current + 1) % queriesCount;
+
+        // the oldest query is reused on the next tick, collecting its result if it is ready
+        int available = 0;
+        if (isPending[current])
+        {
+            glGetQueryObjectiv(queries[current], GL_QUERY_RESULT_AVAILABLE, &available);
+        }
+        if (available != 0)
+        {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(queries[current], GL_QUERY_RESULT, &nanoseconds);
+            lastMilliseconds = static_cast<double>(nanoseconds) / 1000000.0;
+            isPending[current] = false;
+        }
+    }
+
+    /**
+     * @return last measured GPU time, in milliseconds
+     */
+    [[nodiscard]] double milliseconds() const { return lastMilliseconds; }
+};
+
 class Profiler
 {
 public:
     static void StartCpu()
     {
+        uniformRuntimeLookups = 0;
+        programBinds = vertexArrayBinds = materialBinds = variantSwitches = skippedBinds = 0;
+        instancedPackets = 0;
+        gpuCulledObjects = gpuCullingBytesUploaded = 0;
         cpuTimer.tick();
     }
 
@@ -49,31 +106,42 @@ public:
 
     static void StartGPass()
     {
+        gPassTriangles = 0;
+        visibleClusters = totalClusters = 0;
+        visibleMeshes = culledMeshes = 0;
         gTimer.tick();
+        gGpuTimer.tick();
     }
 
     static void EndGPass()
     {
+        gGpuTimer.tock();
         gTimer.tock();
     }
 
     static void StartSPass()
     {
+        shadowPassTriangles = 0;
+        shadowCasterInstances = culledShadowCasterInstances = 0;
         sTimer.tick();
+        sGpuTimer.tick();
     }
 
     static void EndSPass()
     {
+        sGpuTimer.tock();
         sTimer.tock();
     }
 
     static void StartLPass()
     {
         lTimer.tick();
+        lGpuTimer.tick();
     }
 
     static void EndLPass()
     {
+        lGpuTimer.tock();
         lTimer.tock();
     }
 
@@ -89,6 +157,46 @@ public:
 
     static unsigned int totalMeshes, totalVertices;
     static Timer<std::chrono::milliseconds, std::chrono::steady_clock> cpuTimer, prepTimer, gTimer, sTimer, lTimer;
+    inline static GpuTimer gGpuTimer, sGpuTimer, lGpuTimer;
+
+    /* Triangles submitted during the last frame, shadow ones are counted once per cascade they are drawn into */
+    inline static size_t gPassTriangles = 0, shadowPassTriangles = 0;
+
+    /* Draw calls issued during the last frame */
+    inline static size_t gPassDrawCalls = 0, shadowPassDrawCalls = 0;
+
+    /* Meshes culled by the compute shader, and their data uploaded during the last frame, in bytes */
+    inline static size_t gpuCulledObjects = 0, gpuCullingBytesUploaded = 0;
+
+    /* Draw packets merged into the instanced draws of the packets with the same mesh and material during the current frame */
+    inline static size_t instancedPackets = 0;
+
+    /* Geometry memory: GPU buffers, CPU copies kept after the upload and CPU copies dropped after the upload, in bytes */
+    inline static size_t meshGpuMemory = 0, meshCpuMemory = 0, meshCpuMemoryDropped = 0;
+
+    /* Textures still being decoded or uploaded, and texture bytes uploaded during the last frame */
+    inline static size_t texturesPending = 0, textureBytesUploaded = 0;
+
+    /* Interned materials, and material record bytes uploaded during the last frame */
+    inline static size_t materialsCount = 0, materialBytesUploaded = 0;
+
+    /* Uniforms set by the names built at runtime during the current frame, instead of the compile time hashed ones */
+    inline static size_t uniformRuntimeLookups = 0;
+
+    /* Programs used, vertex arrays and material textures bound, and shader variants switched during the current frame */
+    inline static size_t programBinds = 0, vertexArrayBinds = 0, materialBinds = 0, variantSwitches = 0;
+
+    /* Binds skipped during the current frame, as the state was bound already */
+    inline static size_t skippedBinds = 0;
+
+    /* G-pass meshes inside of the camera frustum, and the ones culled by their world bounds */
+    inline static size_t visibleMeshes = 0, culledMeshes = 0;
+
+    /* Shadow caster meshes drawn into the cascades, counted once per cascade, and the ones culled by the cascades */
+    inline static size_t shadowCasterInstances = 0, culledShadowCasterInstances = 0;
+
+    /* Clusters of the G-pass meshes, which passed the frustum and the normal cone tests, out of all tested ones */
+    inline static size_t visibleClusters = 0, totalClusters = 0;
 };
 
 inline unsigned int Profiler::totalMeshes, Profiler::totalVertices;
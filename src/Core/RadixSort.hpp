@@ -0,0 +1,74 @@
+#ifndef GRAPHICS_RADIXSORT_HPP
+#define GRAPHICS_RADIXSORT_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace RadixSort
+{
+    /**
+     * Sorted key with the index of the element it was built for
+     */
+    struct Entry
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    /**
+     * Stable least significant digit radix sort of the 64-bit keys, 8 bits per pass. Passes over the digits shared by
+     * all the keys are skipped, so keys using only a part of the bits are sorted in fewer passes
+     * @param entries entries to sort
+     * @param scratch temporary storage, resized to the entries count
+     */
+    inline void Sort(std::vector<Entry>& entries, std::vector<Entry>& scratch)
+    {
+        constexpr size_t digitBits = 8;
+        constexpr size_t bucketsCount = size_t(1) << digitBits;
+        constexpr size_t passesCount = 64 / digitBits;
+
+        const size_t count = entries.size();
+        if (count < 2)
+        {
+            return;
+        }
+
+        // histograms of all the digits are gathered in a single pass over the keys
+        size_t offsets[passesCount][bucketsCount] = {};
+        for (const auto& entry : entries)
+        {
+            for (size_t pass = 0; pass < passesCount; pass++)
+            {
+                offsets[pass][(entry.key >> (pass * digitBits)) & (bucketsCount - 1)]++;
+            }
+        }
+
+        scratch.resize(count);
+        for (size_t pass = 0; pass < passesCount; pass++)
+        {
+            const size_t shift = pass * digitBits;
+            auto& buckets = offsets[pass];
+            if (buckets[(entries.front().key >> shift) & (bucketsCount - 1)] == count)
+            {
+                continue;
+            }
+
+            size_t offset = 0;
+            for (auto& bucket : buckets)
+            {
+                const size_t bucketSize = bucket;
+                bucket = offset;
+                offset += bucketSize;
+            }
+
+            for (const auto& entry : entries)
+            {
+                scratch[buckets[(entry.key >> shift) & (bucketsCount - 1)]++] = entry;
+            }
+            entries.swap(scratch);
+        }
+    }
+}
+
+#endif //GRAPHICS_RADIXSORT_HPP
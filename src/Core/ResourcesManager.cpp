@@ -6,6 +6,7 @@
 #include <iostream>
 #include "ResourcesManager.h"
 #include "../Entity/Entity.h"
+#include "../Render/ModelCache.h"
 
 std::unique_ptr<Scene> ResourcesManager::pScene;
 std::vector<std::shared_ptr<Layer>> ResourcesManager::layers;
@@ -13,27 +14,49 @@ std::map<std::string, std::shared_ptr<Shader>> ResourcesManager::shaders;
 
 std::mutex ResourcesManager::m;
 
-void ResourcesManager::RegisterShader(const std::string &name, const std::string &vFile, const std::string &fFile, const std::string &gFile)
+void ResourcesManager::RegisterShader(const std::string &name, const std::string &vFile, const std::string &fFile, const std::string &gFile, bool deferLinking)
 {
     const std::lock_guard<std::mutex> lock(m);
     try
     {
-        if (!gFile.empty())
+        shaders[name] = std::make_shared<Shader>(vFile.c_str(), fFile.c_str(), gFile.empty() ? nullptr : gFile.c_str(), std::vector<std::string>{}, deferLinking);
+        if (!deferLinking)
         {
-            shaders[name] = std::make_shared<Shader>(vFile.c_str(), fFile.c_str(), gFile.c_str());
+            LOG(INFO) << "Shader " + name + " successfully registered";
         }
-        else
-        {
-            shaders[name] = std::make_shared<Shader>(vFile.c_str(), fFile.c_str());
-        }
-        LOG(INFO) << "Shader " + name + " successfully registered";
     }
     catch(EngineException& e)
     {
+        shaders.erase(name);
         LOG(WARNING) << "Failed to register shader" << name << ". Reason: " << e.what();
     }
 }
 
+void ResourcesManager::LinkShaders()
+{
+    const std::lock_guard<std::mutex> lock(m);
+    for (auto it = shaders.begin(); it != shaders.end();)
+    {
+        if (it->second->IsLinked())
+        {
+            ++it;
+            continue;
+        }
+
+        try
+        {
+            it->second->FinishLinking();
+            LOG(INFO) << "Shader " + it->first + " successfully registered";
+            ++it;
+        }
+        catch(EngineException& e)
+        {
+            LOG(WARNING) << "Failed to register shader" << it->first << ". Reason: " << e.what();
+            it = shaders.erase(it);
+        }
+    }
+}
+
 std::shared_ptr<Shader>& ResourcesManager::GetShader(const std::string& name)
 {
     return shaders.at(name);
@@ -44,10 +67,23 @@ void ResourcesManager::RegisterPlayerScene(const std::string &path)
     const std::lock_guard<std::mutex> lock(m);
     try
     {
-        pScene = std::make_unique<Scene>(path);
+        // previous scene stays alive until the new one is built: models shared by both are reused from the model cache,
+        // and the previous scene is kept if the new one fails to load
+        auto scene = std::make_unique<Scene>(path);
+        pScene = std::move(scene);
     }
     catch(std::exception& e)
     {
         std::cerr << e.what();
     }
+
+    // evicting models left unreferenced by the scene switch
+    ModelCache::Trim();
+    LOG(INFO) << "Model cache: " << ModelCache::GetModelsCount() << " models, " << ModelCache::GetMemoryUsage() << " bytes";
+
+    // evicted models leave holes in the shared geometry buffers
+    if (GeometryArena::GetFragmentation() > GeometryArena::defragmentationThreshold)
+    {
+        GeometryArena::Defragment();
+    }
 }
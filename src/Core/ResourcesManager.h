@@ -10,6 +10,10 @@
 #include <queue>
 #include <map>
 #include "../Render/Model.h"
+#include "../Render/ModelCache.h"
+#include "../Render/TextureStreamer.h"
+#include "../Render/TextureRegistry.h"
+#include "../Render/MaterialTable.h"
 #include "../Lighting/PointLight.h"
 #include "../Lighting/DirectionalLight.h"
 #include "Camera.h"
@@ -44,8 +48,16 @@ public:
      * @param vFile path to the vertex shader file
      * @param fFile path to the fragment shader file
      * @param gFile path to the geometry shader file (optional)
+     * @param deferLinking if true, shader is not checked until LinkShaders is called, so the driver can compile
+     * several shaders in parallel
      */
-    static void RegisterShader(const std::string &name, const std::string &vFile, const std::string &fFile, const std::string &gFile = "");
+    static void RegisterShader(const std::string &name, const std::string &vFile, const std::string &fFile, const std::string &gFile = "", bool deferLinking = false);
+
+    /**
+     * Finishes linking of the shaders, registered with deferred linking. Shaders, which failed to compile or link, are
+     * unregistered
+     */
+    static void LinkShaders();
 
     /**
      * Registers current scene
@@ -90,6 +102,9 @@ public:
         // destroying the opened scene
         pScene = nullptr;
 
+        // releasing shared models
+        ModelCache::Clear();
+
         // clearing layers
         for (const auto& layer : layers)
         {
@@ -97,6 +112,12 @@ public:
         }
         layers.clear();
 
+        // all meshes are gone by now
+        GeometryArena::ShutDown();
+        MaterialTable::ShutDown();
+        TextureStreamer::ShutDown();
+        TextureRegistry::ShutDown();
+
         // clearing shaders
         shaders.clear();
     }
@@ -0,0 +1,123 @@
+#ifndef GRAPHICS_THREADPOOL_HPP
+#define GRAPHICS_THREADPOOL_HPP
+
+#include <queue>
+#include <mutex>
+#include <thread>
+#include <future>
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+/**
+ * Global pool of worker threads for the CPU heavy work (model import, image decoding etc.).
+ * Tasks must never touch OpenGL, as the context is only current on the main thread
+ */
+class ThreadPool
+{
+public:
+    /* Restriction to create an instance of this class */
+    ThreadPool() = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool(const ThreadPool&) = delete;
+
+    /**
+     * Starts worker threads
+     * @param threadsCount number of workers, all hardware threads except the main one by default
+     */
+    static void Initialize(unsigned int threadsCount = 0)
+    {
+        if (threadsCount == 0)
+        {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            threadsCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+
+        isRunning = true;
+        for (unsigned int i = 0; i < threadsCount; i++)
+        {
+            workers.emplace_back(WorkerLoop);
+        }
+    }
+
+    /**
+     * Waits for the queued tasks to finish and stops all workers
+     */
+    static void ShutDown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            isRunning = false;
+        }
+        condition.notify_all();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    /**
+     * Queues new task. If pool is not running, task is executed immediately on the calling thread
+     * @param task callable to execute
+     * @return future of the task result, rethrows task exceptions on get()
+     */
+    template<typename F>
+    static std::future<std::invoke_result_t<F>> Submit(F&& task)
+    {
+        using ResultType = std::invoke_result_t<F>;
+        auto packagedTask = std::make_shared<std::packaged_task<ResultType()>>(std::forward<F>(task));
+        auto future = packagedTask->get_future();
+
+        {
+            std::unique_lock<std::mutex> lock(m);
+            if (!isRunning)
+            {
+                lock.unlock();
+                (* packagedTask)();
+                return future;
+            }
+            tasks.emplace([packagedTask]() { (* packagedTask)(); });
+        }
+        condition.notify_one();
+
+        return future;
+    }
+
+    /**
+     * @return number of worker threads
+     */
+    static unsigned int GetThreadsCount() { return static_cast<unsigned int>(workers.size()); }
+
+private:
+    static void WorkerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                condition.wait(lock, [] { return !isRunning || !tasks.empty(); });
+
+                if (tasks.empty())
+                {
+                    return;
+                }
+
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+    inline static bool isRunning = false;
+    inline static std::mutex m;
+    inline static std::condition_variable condition;
+    inline static std::vector<std::thread> workers;
+    inline static std::queue<std::function<void()>> tasks;
+};
+
+#endif //GRAPHICS_THREADPOOL_HPP
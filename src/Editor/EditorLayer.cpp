@@ -6,6 +6,7 @@
 #include "../Entity/Entity.h"
 #include "glfw3.h"
 #include <glm/gtc/type_ptr.hpp>
+#include <cstring>
 
 #include "imgui.h"
 #include "imgui_internal.h"
@@ -20,6 +21,7 @@
 #include "../Core/Utils.hpp"
 #include "../Core/Profiler.hpp"
 #include "../Render/Renderer.h"
+#include "../Render/TextureRegistry.h"
 
 void EditorLayer::OnCreate()
 {
@@ -27,8 +29,8 @@ void EditorLayer::OnCreate()
     curDirectory = std::filesystem::current_path();
     selectedOperation = ImGuizmo::OPERATION::TRANSLATE;
 
-    fileTexture = std::make_shared<Texture>("../res/editor/textures/file.png");
-    folderTexture = std::make_shared<Texture>("../res/editor/textures/folder.png");
+    fileTexture = Material::LoadTexture("../res/editor/textures/file.png");
+    folderTexture = Material::LoadTexture("../res/editor/textures/folder.png");
 
     ImGuiStyle& style = ImGui::GetStyle();
 
@@ -422,12 +424,57 @@ void EditorLayer::RenderSettingsPanel(bool& isOpen)
     ImGui::Text("Frame rate: %f FPS", 1.0f / MainLoop::GetWorldDeltaTime());
     ImGui::Text("Total meshes:               %u", Profiler::totalMeshes);
     ImGui::Text("Total vertices:             %u", Profiler::totalVertices);
+    ImGui::Text("G-pass triangles:           %zu", Profiler::gPassTriangles);
+    ImGui::Text("Shadow pass triangles:      %zu", Profiler::shadowPassTriangles);
+    ImGui::Text("Visible meshes:             %zu (%zu culled)", Profiler::visibleMeshes, Profiler::culledMeshes);
+    ImGui::Text("Shadow caster instances:    %zu (%zu culled)", Profiler::shadowCasterInstances, Profiler::culledShadowCasterInstances);
+    ImGui::Text("Visible clusters:           %zu / %zu", Profiler::visibleClusters, Profiler::totalClusters);
+    ImGui::Text("G-pass draw calls:          %zu", Profiler::gPassDrawCalls);
+    ImGui::Text("Shadow pass draw calls:     %zu", Profiler::shadowPassDrawCalls);
+    ImGui::Text("Instanced draw packets:     %zu", Profiler::instancedPackets);
+    ImGui::Text("GPU culled meshes:          %zu", Profiler::gpuCulledObjects);
+    ImGui::Text("GPU culling upload (bytes): %zu", Profiler::gpuCullingBytesUploaded);
+    ImGui::Text("Mesh GPU memory (MB):       %.2f", static_cast<float>(Profiler::meshGpuMemory) / (1024.0f * 1024.0f));
+    ImGui::Text("Mesh CPU memory (MB):       %.2f", static_cast<float>(Profiler::meshCpuMemory) / (1024.0f * 1024.0f));
+    ImGui::Text("Mesh CPU dropped (MB):      %.2f", static_cast<float>(Profiler::meshCpuMemoryDropped) / (1024.0f * 1024.0f));
+    ImGui::Text("Geometry arena (MB):        %.2f / %.2f", static_cast<float>(GeometryArena::GetMemoryUsage()) / (1024.0f * 1024.0f),
+                static_cast<float>(GeometryArena::GetCapacity()) / (1024.0f * 1024.0f));
+    ImGui::Text("Geometry fragmentation:     %.2f", GeometryArena::GetFragmentation());
+    ImGui::Text("Textures streaming:         %zu", Profiler::texturesPending);
+    ImGui::Text("Texture upload (KB):        %.1f", static_cast<float>(Profiler::textureBytesUploaded) / 1024.0f);
+    ImGui::Text("Materials:                  %zu", Profiler::materialsCount);
+    ImGui::Text("Material upload (bytes):    %zu", Profiler::materialBytesUploaded);
+    ImGui::Text("Uniform runtime lookups:    %zu", Profiler::uniformRuntimeLookups);
+    ImGui::Text("Program binds:              %zu (%zu variant switches)", Profiler::programBinds, Profiler::variantSwitches);
+    ImGui::Text("VAO / material binds:       %zu / %zu", Profiler::vertexArrayBinds, Profiler::materialBinds);
+    ImGui::Text("Redundant binds skipped:    %zu", Profiler::skippedBinds);
+    ImGui::Text("Texture memory (MB):        %.2f / %d", static_cast<float>(TextureRegistry::GetMemoryUsage()) / (1024.0f * 1024.0f),
+                Renderer::textureMemoryBudget);
+    if (ImGui::CollapsingHeader("Textures"))
+    {
+        for (const auto& [path, texture] : TextureRegistry::GetTextures())
+        {
+            const auto level = static_cast<int>(texture->GetResidentLevel());
+            const char * state = texture->IsStreaming() ? "streaming" : (texture->IsResident() ? "resident" : "evicted");
+            ImGui::Text("%s: %d x %d, level %d (desired %d), %.2f MB, %s", path.c_str(), std::max(texture->GetWidth() >> level, 1),
+                        std::max(texture->GetHeight() >> level, 1), level, static_cast<int>(texture->GetDesiredLevel()),
+                        static_cast<float>(texture->GetMemoryUsage()) / (1024.0f * 1024.0f), state);
+        }
+    }
+    if (ImGui::Button("Defragment geometry"))
+    {
+        GeometryArena::Defragment();
+    }
     ImGui::Text("Update time (ms):           %f", cTime);
     ImGui::Text("Prep time:                  %f", pTime);
     ImGui::Text("G-pass time (ms):           %f", gTime);
     ImGui::Text("Shadow rendering time (ms): %f", sTime);
     ImGui::Text("L-pass time (ms):           %f", lTime);
     ImGui::Separator();
+    ImGui::Text("G-pass GPU time (ms):       %f", Profiler::gGpuTimer.milliseconds());
+    ImGui::Text("Shadow GPU time (ms):       %f", Profiler::sGpuTimer.milliseconds());
+    ImGui::Text("L-pass GPU time (ms):       %f", Profiler::lGpuTimer.milliseconds());
+    ImGui::Separator();
     ImGui::Text("Total CPU time:             %f", ctTotal);
     ImGui::Separator();
     ImGui::Text("ImGui and SwapBuffers:      %f", MainLoop::GetWorldDeltaTime() * 1000 - ctTotal);
@@ -484,6 +531,19 @@ void EditorLayer::RenderSettingsPanel(bool& isOpen)
         LOG(DEBUG) << "Lighting baking requested";
     }
 
+    ImGui::Checkbox("Position only shadow casters stream", &Renderer::usePositionOnlyDepthStream);
+
+    ImGui::Checkbox("Levels of detail", &Renderer::isLodEnabled);
+    ImGui::SliderFloat("LOD error threshold (px)", &Renderer::lodPixelThreshold, 0.1f, 16.0f);
+    ImGui::SliderFloat("Shadow LOD bias", &Renderer::shadowLodBias, 1.0f, 16.0f);
+    ImGui::Checkbox("Shadows", &Renderer::areShadowsEnabled);
+    ImGui::Checkbox("Cluster culling", &Renderer::isClusterCullingEnabled);
+    ImGui::Checkbox("Multi draw indirect", &Renderer::useMultiDrawIndirect);
+    ImGui::Checkbox("Automatic instancing", &Renderer::isInstancingEnabled);
+    ImGui::Checkbox("GPU culling", &Renderer::isGpuCullingEnabled);
+    ImGui::SliderInt("Texture upload budget (KB)", &Renderer::textureUploadBudget, 64, 65536);
+    ImGui::SliderInt("Texture memory budget (MB)", &Renderer::textureMemoryBudget, 64, 8192);
+    ImGui::SliderFloat("Texture resolution scale", &Renderer::textureResolutionScale, 0.25f, 4.0f);
     ImGui::SliderFloat("Base offset", &Renderer::baseOffset, 0.0f, 100.0f);
     ImGui::SliderFloat("Delta offset", &Renderer::deltaOffset, 0.0f, 100.0f);
     ImGui::SliderFloat("Factor multiplier", &Renderer::factorMultiplier, 0.0f, 100.0f);
@@ -663,14 +723,14 @@ void EditorLayer::DrawEntityProperties(std::unique_ptr<Scene>& scene)
                 }
 
                 auto& modelComponent = selectedEntity->GetComponent<Model3DComponent>();
-                ImGui::Text("Path: %s", modelComponent.model.path.c_str());
+                ImGui::Text("Path: %s", modelComponent.path.c_str());
                 if(ImGui::BeginDragDropTarget())
                 {
                     if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("FILE_SELECTED"))
                     {
                         if(payload->Data)
                         {
-                            modelComponent.model.path = std::string((char *) payload->Data);
+                            modelComponent.path = std::string((char *) payload->Data);
                         }
                         else
                         {
@@ -684,7 +744,7 @@ void EditorLayer::DrawEntityProperties(std::unique_ptr<Scene>& scene)
                 {
                     try
                     {
-                        modelComponent.model = Model(modelComponent.model.path);
+                        modelComponent.model = ModelCache::Reload(modelComponent.path);
                     }
                     catch(const EngineException& e)
                     {
@@ -692,13 +752,59 @@ void EditorLayer::DrawEntityProperties(std::unique_ptr<Scene>& scene)
                     }
                 }
 
+                ImGui::Text("LOD: %d / %d, triangles: %zu", modelComponent.lod, modelComponent.model->GetLodsCount() - 1, modelComponent.model->GetTrianglesCount(modelComponent.lod));
+                ImGui::Text("Shadow LOD: %d, triangles: %zu", modelComponent.shadowLod, modelComponent.model->GetTrianglesCount(modelComponent.shadowLod));
+
                 ImGui::Checkbox("Casts shadow", &modelComponent.castsShadow);
                 ImGui::Checkbox("Should be lit", &modelComponent.shouldBeLit);
                 ImGui::SliderInt("Tiling factor", &modelComponent.tilingFactor, 1, 100);
 
+                ImGui::Text("CPU geometry: %.2f MB, %s", static_cast<float>(modelComponent.model->GetCpuDataSize()) / (1024.0f * 1024.0f),
+                            modelComponent.model->IsCpuDataResident() ? "resident" : "dropped after upload");
+
+                // CPU side geometry is only read back from disk while this header is open
+                if(ImGui::CollapsingHeader("Geometry: "))
+                {
+                    if (!inspectedGeometry || inspectedGeometry->path != modelComponent.model->path)
+                    {
+                        try
+                        {
+                            inspectedGeometry = modelComponent.model->GetCpuData();
+                        }
+                        catch(const EngineException& e)
+                        {
+                            LOG(WARNING) << "Failed to load model geometry. Reason: " << e.what();
+                        }
+                    }
+
+                    if (inspectedGeometry)
+                    {
+                        for (const auto& meshData : inspectedGeometry->meshes)
+                        {
+                            // positions are the leading vec3 of every vertex format
+                            BoundingBox bounds;
+                            const size_t stride = VertexLayout::GetSize(meshData.vertexFormat);
+                            for (size_t v = 0; v < meshData.verticesCount; v++)
+                            {
+                                glm::vec3 position;
+                                std::memcpy(&position, meshData.vertexData + v * stride, sizeof(glm::vec3));
+                                bounds.Extend(position);
+                            }
+
+                            ImGui::Text("%s: %zu vertices, %zu indices, %s", meshData.name.c_str(), meshData.verticesCount, meshData.indicesCount,
+                                        meshData.vertexFormat == VertexFormat::Skinned ? "skinned" : "static");
+                            ImGui::Text("  min (%.2f, %.2f, %.2f), max (%.2f, %.2f, %.2f)", bounds.min.x, bounds.min.y, bounds.min.z, bounds.max.x, bounds.max.y, bounds.max.z);
+                        }
+                    }
+                }
+                else
+                {
+                    inspectedGeometry = nullptr;
+                }
+
                 if(ImGui::CollapsingHeader("Materials: "))
                 {
-                    for (const auto& mesh : modelComponent.model.meshes)
+                    for (const auto& mesh : modelComponent.model->meshes)
                     {
                         if(ImGui::Button(mesh->name.c_str(), ImVec2(ImGui::GetContentRegionAvail().x, 16)))
                         {
@@ -861,25 +967,25 @@ void EditorLayer::DrawEntityProperties(std::unique_ptr<Scene>& scene)
         ImGui::ColorEdit3("Material color: ", (float *) &material.defaultColor);
 
         ImGui::Text("Diffuse texture");
-        RenderMaterialTextures(material.materialTextures.at(TextureType::Diffuse));
+        RenderMaterialTextures(material.materialTextures.at(TextureType::Diffuse), TextureType::Diffuse);
 
         ImGui::Text("Normal texture");
-        RenderMaterialTextures(material.materialTextures.at(TextureType::Normal));
+        RenderMaterialTextures(material.materialTextures.at(TextureType::Normal), TextureType::Normal);
 
         ImGui::Text("Specular texture");
-        RenderMaterialTextures(material.materialTextures.at(TextureType::Specular));
+        RenderMaterialTextures(material.materialTextures.at(TextureType::Specular), TextureType::Specular);
 
         ImGui::Text("Roughness texture");
-        RenderMaterialTextures(material.materialTextures.at(TextureType::Roughness));
+        RenderMaterialTextures(material.materialTextures.at(TextureType::Roughness), TextureType::Roughness);
 
         ImGui::Text("Metallic texture");
-        RenderMaterialTextures(material.materialTextures.at(TextureType::Metallic));
+        RenderMaterialTextures(material.materialTextures.at(TextureType::Metallic), TextureType::Metallic);
 
         ImGui::End();
     }
 }
 
-void EditorLayer::RenderMaterialTextures(TextureStack& stack)
+void EditorLayer::RenderMaterialTextures(TextureStack& stack, TextureType usage)
 {
     if(stack.empty())
     {
@@ -911,20 +1017,8 @@ void EditorLayer::RenderMaterialTextures(TextureStack& stack)
             {
                 if (payload->Data)
                 {
-                    bool loaded = false;
-                    for (const auto &tex: Texture::texturesLoaded)
-                    {
-                        if (*tex == ((char *) payload->Data))
-                        {
-                            loaded = true;
-                            texture = tex;
-                            break;
-                        }
-                    }
-                    if (!loaded)
-                    {
-                        texture = std::make_shared<Texture>((char *) payload->Data);
-                    }
+                    // already loaded texture is returned, if there is one
+                    texture = Material::LoadTexture((char *) payload->Data, usage);
                 }
                 else
                 {
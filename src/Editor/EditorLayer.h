@@ -53,12 +53,13 @@ private:
 
     void RenderEntitiesListPanel(bool& isOpen, std::unique_ptr<Scene>& scene);
 
-    static void RenderMaterialTextures(TextureStack& stack);
+    static void RenderMaterialTextures(TextureStack& stack, TextureType usage);
 
 private:
     std::filesystem::path curDirectory;
     std::shared_ptr<Mesh> selectedMaterial = nullptr;
     std::shared_ptr<Entity> selectedEntity = nullptr;
+    std::shared_ptr<const ModelData> inspectedGeometry = nullptr;
     std::shared_ptr<Texture> fileTexture = nullptr, folderTexture = nullptr;
 
     int selectedOperation;
@@ -13,6 +13,7 @@
 #include "../Core/Camera.h"
 #include "../Core/UniqueID.hpp"
 #include "../Render/Model.h"
+#include "../Render/ModelCache.h"
 
 struct TransformComponent
 {
@@ -67,15 +68,55 @@ struct CameraComponent
 
 struct Model3DComponent
 {
-    Model3DComponent() = default;
-    Model3DComponent(const std::string& modelPath) : model(modelPath) {};
+    Model3DComponent() : model(std::make_shared<Model>()) {};
+    Model3DComponent(const std::string& modelPath) : path(modelPath), model(ModelCache::Get(modelPath)) {};
+    Model3DComponent(std::shared_ptr<Model> sharedModel) : path(sharedModel->path), model(std::move(sharedModel)) {};
 
     int tilingFactor = 1;
 
     bool castsShadow = true;
     bool shouldBeLit = true;
 
-    Model model;
+    /* Path to the model file, may differ from the loaded model path until the model is reloaded */
+    std::string path;
+
+    /* Model, shared by all components with the same path */
+    std::shared_ptr<Model> model;
+
+    /* Levels of detail, selected by the renderer during the last frame */
+    int lod = 0;
+    int shadowLod = 0;
+
+    /* World space bounds of the model meshes and the transform they were computed with */
+    std::vector<BoundingBox> worldBoxes;
+    std::vector<BoundingSphere> worldSpheres;
+    glm::mat4 worldTransform { 0.0f };
+
+    /**
+     * Recomputes world space bounds of the meshes, if the transform or the model meshes have changed since the last call
+     * @param transform model transform
+     */
+    void UpdateWorldBounds(const glm::mat4& transform)
+    {
+        if (transform == worldTransform && model.get() == boundsModel && worldBoxes.size() == model->meshes.size())
+        {
+            return;
+        }
+
+        worldTransform = transform;
+        boundsModel = model.get();
+        worldBoxes.resize(model->meshes.size());
+        worldSpheres.resize(model->meshes.size());
+        for (size_t i = 0; i < model->meshes.size(); i++)
+        {
+            worldBoxes[i] = model->meshes[i]->GetBounds().Transformed(transform);
+            worldSpheres[i] = model->meshes[i]->GetBoundingSphere().Transformed(transform);
+        }
+    }
+
+private:
+    /* Model the world bounds were computed for */
+    const Model * boundsModel = nullptr;
 };
 
 struct DirectionalLightComponent
@@ -261,7 +261,7 @@ private:
         {
             StartMap(out, "Model3D");
             const auto& component = entity.GetComponent<Model3DComponent>();
-            std::string copy = component.model.path;
+            std::string copy = component.path;
             for(char& c : copy)
             {
                 if(c == '\\')
@@ -9,6 +9,11 @@
 #include "JsonSceneSerializer.hpp"
 #include "json.hpp"
 #include "../Render/Renderer.h"
+#include "../Render/ModelCache.h"
+#include "../Render/ModelLoader.h"
+#include "../Core/ThreadPool.hpp"
+
+#include <chrono>
 #include "../Input/EventsHandler.h"
 
 
@@ -98,6 +103,20 @@ void Scene::LoadScene(const std::string &loadPath)
     {
         LOG(WARNING) << "Scene '" << path << "' does not have name";
     }
+
+    auto loadStart = std::chrono::high_resolution_clock::now();
+
+    // queuing all models first, so they are read and their textures are decoded in parallel while entities are created
+    ModelLoader loader;
+    for (const auto& model : data["Entities"].items())
+    {
+        const auto& components = model.value();
+        if (components.contains("Model3D") && components["Model3D"].contains("Path") && !ModelCache::Contains(components["Model3D"]["Path"]))
+        {
+            loader.Request(components["Model3D"]["Path"]);
+        }
+    }
+
     for (const auto& model : data["Entities"].items())
     {
         try
@@ -147,7 +166,25 @@ void Scene::LoadScene(const std::string &loadPath)
             {
                 const auto& model3Component = components["Model3D"];
 
-                auto& component = e.AddComponent<Model3DComponent>(model3Component["Path"]);
+                std::string modelPath = model3Component["Path"];
+
+                std::shared_ptr<Model> sharedModel;
+                if (ModelCache::Contains(modelPath))
+                {
+                    sharedModel = ModelCache::Get(modelPath);
+                }
+                else
+                {
+                    std::shared_ptr<const ModelData> modelData = loader.Get(modelPath);
+
+                    // only OpenGL objects are created on the main thread
+                    auto uploadStart = std::chrono::high_resolution_clock::now();
+                    sharedModel = ModelCache::Get(* modelData);
+                    LOG(INFO) << "Model " << modelData->path << " uploaded in "
+                              << std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(std::chrono::high_resolution_clock::now() - uploadStart).count() << " ms";
+                }
+
+                auto& component = e.AddComponent<Model3DComponent>(sharedModel);
                 try
                 {
                     component.castsShadow  = model3Component["castsShadow"];
@@ -215,6 +252,10 @@ void Scene::LoadScene(const std::string &loadPath)
             LOG(WARNING) << "Failed to load model " << model.key() << " . Reason: " << e.what();
         }
     }
+
+    LOG(INFO) << "Scene " << loadPath << " loaded in "
+              << std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(std::chrono::high_resolution_clock::now() - loadStart).count()
+              << " ms using " << ThreadPool::GetThreadsCount() << " worker threads";
 }
 
 
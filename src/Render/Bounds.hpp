@@ -0,0 +1,164 @@
+#ifndef GRAPHICS_BOUNDS_HPP
+#define GRAPHICS_BOUNDS_HPP
+
+#include "glm/glm.hpp"
+#include <limits>
+#include <algorithm>
+
+struct BoundingBox
+{
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+    /**
+     * Grows the box to contain the point
+     * @param point point to include
+     */
+    inline void Extend(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    /**
+     * Grows the box to contain other box
+     * @param other box to include
+     */
+    inline void Extend(const BoundingBox& other)
+    {
+        if (other.IsValid())
+        {
+            Extend(other.min);
+            Extend(other.max);
+        }
+    }
+
+    /**
+     * @return true if at least one point was added to the box
+     */
+    [[nodiscard]] inline bool IsValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+
+    [[nodiscard]] inline glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+
+    [[nodiscard]] inline glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+
+    /**
+     * @param matrix affine transform
+     * @return the smallest box containing this box transformed by the matrix (Arvo)
+     */
+    [[nodiscard]] inline BoundingBox Transformed(const glm::mat4& matrix) const
+    {
+        if (!IsValid())
+        {
+            return * this;
+        }
+
+        const glm::vec3 center(matrix * glm::vec4(GetCenter(), 1.0f));
+        const glm::vec3 halfSize = GetExtents();
+        const glm::vec3 extents = glm::abs(glm::vec3(matrix[0])) * halfSize.x + glm::abs(glm::vec3(matrix[1])) * halfSize.y +
+                                  glm::abs(glm::vec3(matrix[2])) * halfSize.z;
+
+        BoundingBox box;
+        box.min = center - extents;
+        box.max = center + extents;
+        return box;
+    }
+};
+
+struct BoundingSphere
+{
+    glm::vec3 center { 0.0f };
+    /* Negative if the sphere contains nothing */
+    float radius = -1.0f;
+
+    /**
+     * @return true if the sphere contains at least a single point
+     */
+    [[nodiscard]] inline bool IsValid() const { return radius >= 0.0f; }
+
+    /**
+     * @param matrix affine transform
+     * @return sphere containing this sphere transformed by the matrix, scaled by the largest axis scale
+     */
+    [[nodiscard]] inline BoundingSphere Transformed(const glm::mat4& matrix) const
+    {
+        if (!IsValid())
+        {
+            return * this;
+        }
+
+        const float scale = std::max({ glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2])) });
+        return { glm::vec3(matrix * glm::vec4(center, 1.0f)), radius * scale };
+    }
+};
+
+/**
+ * Six clipping planes of a projection, each one facing inside of the frustum
+ */
+struct Frustum
+{
+    /* Left, right, bottom, top, near, far; xyz is the normalized plane normal, w is the distance */
+    glm::vec4 planes[6];
+
+    Frustum() = default;
+
+    /**
+     * Extracts the planes from the clip space matrix (Gribb-Hartmann). Planes are in the space the matrix
+     * transforms from, so passing projection * view * model gives the frustum in the model space
+     * @param matrix clip space matrix
+     */
+    explicit Frustum(const glm::mat4& matrix)
+    {
+        const glm::mat4 m = glm::transpose(matrix);
+        planes[0] = m[3] + m[0];
+        planes[1] = m[3] - m[0];
+        planes[2] = m[3] + m[1];
+        planes[3] = m[3] - m[1];
+        planes[4] = m[3] + m[2];
+        planes[5] = m[3] - m[2];
+
+        // infinite projections have no far plane, it is replaced with the one that never rejects anything
+        for (auto& plane : planes)
+        {
+            const float length = glm::length(glm::vec3(plane));
+            plane = length > 1e-6f ? plane / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+    }
+
+    /**
+     * @param center sphere center
+     * @param radius sphere radius
+     * @return false if the sphere is completely outside of the frustum
+     */
+    [[nodiscard]] inline bool Intersects(const glm::vec3& center, float radius) const
+    {
+        for (const auto& plane : planes)
+        {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @param box bounding box
+     * @return false if the box is completely outside of the frustum
+     */
+    [[nodiscard]] inline bool Intersects(const BoundingBox& box) const
+    {
+        const glm::vec3 center = box.GetCenter(), extents = box.GetExtents();
+        for (const auto& plane : planes)
+        {
+            const glm::vec3 normal(plane);
+            if (glm::dot(normal, center) + plane.w < -glm::dot(glm::abs(normal), extents))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif //GRAPHICS_BOUNDS_HPP
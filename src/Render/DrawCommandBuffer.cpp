@@ -0,0 +1,371 @@
+#include "DrawCommandBuffer.h"
+#include "GeometryArena.h"
+#include "MaterialTable.h"
+#include "Mesh.h"
+#include "../Core/Hash.hpp"
+#include "../Core/Profiler.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+    /**
+     * Bits of the non negative floats grow with their values, so the upper half of them, the exponent and 7 bits of the
+     * mantissa, is a depth with the precision relative to the distance
+     * @param distance distance to the view point
+     * @return quantised distance
+     */
+    uint16_t QuantizeDepth(float distance)
+    {
+        distance = std::max(distance, 0.0f);
+        uint32_t bits;
+        std::memcpy(&bits, &distance, sizeof(bits));
+        return static_cast<uint16_t>(bits >> 16);
+    }
+}
+
+bool DrawCommandBuffer::InstancingKey::operator ==(const InstancingKey& other) const
+{
+    return vertexArray == other.vertexArray && materialId == other.materialId && count == other.count &&
+           firstIndex == other.firstIndex && baseVertex == other.baseVertex;
+}
+
+size_t DrawCommandBuffer::InstancingKeyHash::operator()(const InstancingKey& key) const
+{
+    uint64_t hash = Hash::Fnv1a(&key.vertexArray, sizeof(key.vertexArray));
+    hash = Hash::Fnv1a(&key.materialId, sizeof(key.materialId), hash);
+    hash = Hash::Fnv1a(&key.count, sizeof(key.count), hash);
+    hash = Hash::Fnv1a(&key.firstIndex, sizeof(key.firstIndex), hash);
+    hash = Hash::Fnv1a(&key.baseVertex, sizeof(key.baseVertex), hash);
+    return static_cast<size_t>(hash);
+}
+
+DrawCommandBuffer::DrawCommandBuffer()
+{
+    glGenBuffers(1, &drawDataBuffer);
+    glGenBuffers(1, &instancesBuffer);
+    glGenBuffers(1, &commandsBuffer);
+}
+
+DrawCommandBuffer::~DrawCommandBuffer()
+{
+    glDeleteBuffers(1, &drawDataBuffer);
+    glDeleteBuffers(1, &instancesBuffer);
+    glDeleteBuffers(1, &commandsBuffer);
+}
+
+void DrawCommandBuffer::Clear()
+{
+    items.clear();
+    drawData.clear();
+    instances.clear();
+    commands.clear();
+    isSorted = false;
+}
+
+uint32_t DrawCommandBuffer::AddDrawData(const glm::mat4& model, int tilingFactor, bool shouldBeLit)
+{
+    DrawData data;
+    data.model = model;
+    data.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(model))));
+    data.material = glm::ivec4(tilingFactor, shouldBeLit ? 1 : 0, 0, 0);
+    drawData.push_back(data);
+    isSorted = false;
+    return static_cast<uint32_t>(drawData.size() - 1);
+}
+
+void DrawCommandBuffer::SetViewPoint(const glm::vec3& position)
+{
+    viewPoint = position;
+    hasViewPoint = true;
+}
+
+uint16_t DrawCommandBuffer::GetDepth(const Mesh& mesh, uint32_t drawIndex) const
+{
+    if (!hasViewPoint)
+    {
+        return 0;
+    }
+
+    const glm::vec3 center = glm::vec3(drawData[drawIndex].model * glm::vec4(mesh.GetBoundingSphere().center, 1.0f));
+    return QuantizeDepth(glm::length(center - viewPoint));
+}
+
+size_t DrawCommandBuffer::AddMesh(const Mesh& mesh, uint32_t drawIndex, int lod, const ClusterCullingData * culling)
+{
+    const auto firstCommand = static_cast<uint32_t>(commands.size());
+    const auto instance = static_cast<uint32_t>(instances.size());
+    const size_t indices = mesh.CollectDrawCommands(commands, instance, lod, culling, false);
+    if (commands.size() > firstCommand)
+    {
+        const uint32_t materialId = mesh.material.GetId();
+        instances.push_back({ drawIndex, materialId, 0 });
+        items.push_back({ GeometryArena::GetVertexArray(mesh.GetVertexFormat(), mesh.GetIndexFormat()), mesh.GetIndexFormat(), materialId, 0,
+                          firstCommand, static_cast<uint32_t>(commands.size()) - firstCommand, 0, 0, GetDepth(mesh, drawIndex) });
+        isSorted = false;
+    }
+    return indices;
+}
+
+size_t DrawCommandBuffer::AddDepthMesh(const Mesh& mesh, uint32_t drawIndex, int lod, bool usePositionStream, uint32_t layerMask)
+{
+    if (layerMask == 0)
+    {
+        return 0;
+    }
+
+    const auto firstCommand = static_cast<uint32_t>(commands.size());
+    const auto instance = static_cast<uint32_t>(instances.size());
+    const size_t indices = mesh.CollectDrawCommands(commands, instance, lod, nullptr, usePositionStream);
+    if (commands.size() == firstCommand)
+    {
+        return indices;
+    }
+
+    // consecutive instances, one per layer, are addressed by the instance ID of the same commands
+    uint32_t layersCount = 0;
+    for (uint32_t layer = 0; layer < 32; layer++)
+    {
+        if (layerMask & (1u << layer))
+        {
+            instances.push_back({ drawIndex, MaterialTable::invalidId, layer });
+            layersCount++;
+        }
+    }
+    for (size_t c = firstCommand; c < commands.size(); c++)
+    {
+        commands[c].instanceCount = layersCount;
+    }
+
+    const unsigned int vertexArray = usePositionStream ? GeometryArena::GetDepthVertexArray(mesh.GetIndexFormat())
+                                                       : GeometryArena::GetVertexArray(mesh.GetVertexFormat(), mesh.GetIndexFormat());
+    items.push_back({ vertexArray, mesh.GetIndexFormat(), MaterialTable::invalidId, 0, firstCommand, static_cast<uint32_t>(commands.size()) - firstCommand,
+                      0, 0, GetDepth(mesh, drawIndex) });
+    isSorted = false;
+    return indices * layersCount;
+}
+
+uint64_t DrawCommandBuffer::MakeSortKey(const Item& item, bool isBindingMaterials)
+{
+    auto it = std::find(vertexArrays.begin(), vertexArrays.end(), item.vertexArray);
+    if (it == vertexArrays.end())
+    {
+        it = vertexArrays.insert(vertexArrays.end(), item.vertexArray);
+    }
+
+    constexpr uint64_t vertexArrayMask = (1ull << (textureMaskShift - vertexArrayShift)) - 1;
+    constexpr uint64_t materialMask = (1ull << (vertexArrayShift - materialShift)) - 1;
+    constexpr uint64_t meshMask = (1ull << (materialShift - meshShift)) - 1;
+    const auto vertexArrayIndex = static_cast<uint64_t>(it - vertexArrays.begin());
+
+    // every mesh owns its vertex range of the shared vertex array, so the base vertex identifies it along with all its
+    // levels of detail and clusters
+    const uint64_t meshKey = (static_cast<uint64_t>(item.vertexArray) << 32) | static_cast<uint32_t>(commands[item.firstCommand].baseVertex);
+    const uint64_t mesh = meshIndices.try_emplace(meshKey, static_cast<uint32_t>(meshIndices.size())).first->second;
+
+    // material is ignored if it binds nothing, so the meshes order the whole batch
+    const uint64_t material = isBindingMaterials ? std::min<uint64_t>(item.materialId, materialMask) : 0;
+    return (static_cast<uint64_t>(item.textureMask & 0xFF) << textureMaskShift) | (std::min(vertexArrayIndex, vertexArrayMask) << vertexArrayShift) |
+           (material << materialShift) | (std::min(mesh, meshMask) << meshShift) | item.depth;
+}
+
+void DrawCommandBuffer::Sort(bool isBindingVariants, bool useInstancing)
+{
+    const bool isBindingMaterials = !Texture::IsBindlessEnabled();
+
+    // draws with a single command, the same for every draw of the mesh unless its clusters were culled, are merged
+    // into the batches by their geometry and material, the rest are batches of their own
+    batches.clear();
+    batchIndices.clear();
+    itemBatches.resize(items.size());
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        auto& item = items[i];
+        const auto& command = commands[item.firstCommand];
+        item.firstInstance = command.baseInstance;
+        item.instancesCount = command.instanceCount;
+
+        if (useInstancing && item.commandsCount == 1)
+        {
+            const InstancingKey key { item.vertexArray, item.materialId, command.count, command.firstIndex, command.baseVertex };
+            const auto [it, isInserted] = batchIndices.try_emplace(key, static_cast<uint32_t>(batches.size()));
+            if (!isInserted)
+            {
+                // the nearest instance decides where the batch is drawn
+                auto& batch = batches[it->second];
+                batch.instancesCount += item.instancesCount;
+                batch.depth = std::min(batch.depth, item.depth);
+                itemBatches[i] = it->second;
+                Profiler::instancedPackets++;
+                continue;
+            }
+        }
+
+        itemBatches[i] = static_cast<uint32_t>(batches.size());
+        batches.push_back(item);
+    }
+
+    // instances of every batch are rewritten next to each other, so a single command addresses all of them
+    uint32_t instancesCount = 0;
+    for (auto& batch : batches)
+    {
+        batch.firstInstance = instancesCount;
+        instancesCount += batch.instancesCount;
+        batch.instancesCount = 0;
+    }
+    sortedInstances.resize(instancesCount);
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        auto& batch = batches[itemBatches[i]];
+        std::copy_n(instances.begin() + items[i].firstInstance, items[i].instancesCount, sortedInstances.begin() + batch.firstInstance + batch.instancesCount);
+        batch.instancesCount += items[i].instancesCount;
+    }
+
+    // residency changes with the streaming, so the masks are taken from the records of the current frame
+    meshIndices.clear();
+    sortEntries.resize(batches.size());
+    for (size_t i = 0; i < batches.size(); i++)
+    {
+        batches[i].textureMask = isBindingVariants ? MaterialTable::GetTextureMask(batches[i].materialId) : 0;
+        sortEntries[i] = { MakeSortKey(batches[i], isBindingMaterials), static_cast<uint32_t>(i) };
+    }
+    RadixSort::Sort(sortEntries, sortScratch);
+
+    // commands are rearranged too, so every group of draws sharing the same state is a single contiguous run of them
+    sortedItems.clear();
+    sortedCommands.clear();
+    for (const auto& entry : sortEntries)
+    {
+        Item batch = batches[entry.index];
+        for (uint32_t c = batch.firstCommand; c < batch.firstCommand + batch.commandsCount; c++)
+        {
+            DrawElementsIndirectCommand command = commands[c];
+            command.instanceCount = batch.instancesCount;
+            command.baseInstance = batch.firstInstance;
+            sortedCommands.push_back(command);
+        }
+        batch.firstCommand = static_cast<uint32_t>(sortedCommands.size()) - batch.commandsCount;
+        sortedItems.push_back(batch);
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawDataBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(drawData.size() * sizeof(DrawData)), drawData.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, instancesBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(sortedInstances.size() * sizeof(DrawInstance)), sortedInstances.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandsBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, static_cast<GLsizeiptr>(sortedCommands.size() * sizeof(DrawElementsIndirectCommand)), sortedCommands.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    isSorted = true;
+    isSortedByVariants = isBindingVariants;
+    isInstanced = useInstancing;
+}
+
+size_t DrawCommandBuffer::Submit(bool useMultiDrawIndirect, bool useInstancing, const std::function<void(uint32_t textureMask)>& bindVariant)
+{
+    if (items.empty())
+    {
+        return 0;
+    }
+
+    // parameters and bindless handles are fetched by the material ID, only the texture units depend on the material
+    const bool isBindingMaterials = !Texture::IsBindlessEnabled();
+    const bool isBindingVariants = static_cast<bool>(bindVariant);
+
+    // passes drawn several times, like the cascades without the layered rendering, are sorted and uploaded once
+    if (!isSorted || isSortedByVariants != isBindingVariants || isInstanced != useInstancing)
+    {
+        Sort(isBindingVariants, useInstancing);
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, drawDataBinding, drawDataBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, instancesBinding, instancesBuffer);
+
+    size_t drawCalls = 0;
+    unsigned int boundVertexArray = 0;
+    uint32_t boundMaterial = MaterialTable::invalidId;
+    uint32_t boundMask = UINT32_MAX;
+
+    auto bindState = [&](const Item& item)
+    {
+        if (isBindingVariants && item.textureMask != boundMask)
+        {
+            bindVariant(item.textureMask);
+            boundMask = item.textureMask;
+            Profiler::variantSwitches++;
+        }
+        if (item.vertexArray != boundVertexArray)
+        {
+            glBindVertexArray(item.vertexArray);
+            boundVertexArray = item.vertexArray;
+            Profiler::vertexArrayBinds++;
+        }
+        else
+        {
+            Profiler::skippedBinds++;
+        }
+        if (isBindingMaterials && item.materialId != MaterialTable::invalidId)
+        {
+            if (item.materialId != boundMaterial)
+            {
+                MaterialTable::BindTextures(item.materialId);
+                boundMaterial = item.materialId;
+                Profiler::materialBinds++;
+            }
+            else
+            {
+                Profiler::skippedBinds++;
+            }
+        }
+    };
+
+    if (useMultiDrawIndirect)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandsBuffer);
+
+        for (size_t begin = 0; begin < sortedItems.size();)
+        {
+            size_t end = begin + 1;
+            while (end < sortedItems.size() && sortedItems[end].textureMask == sortedItems[begin].textureMask &&
+                   sortedItems[end].vertexArray == sortedItems[begin].vertexArray &&
+                   (!isBindingMaterials || sortedItems[end].materialId == sortedItems[begin].materialId))
+            {
+                end++;
+            }
+
+            bindState(sortedItems[begin]);
+            const uint32_t commandsCount = sortedItems[end - 1].firstCommand + sortedItems[end - 1].commandsCount - sortedItems[begin].firstCommand;
+            glMultiDrawElementsIndirect(GL_TRIANGLES, VertexLayout::GetIndexType(sortedItems[begin].indexFormat),
+                                        reinterpret_cast<const void *>(sortedItems[begin].firstCommand * sizeof(DrawElementsIndirectCommand)),
+                                        static_cast<GLsizei>(commandsCount), sizeof(DrawElementsIndirectCommand));
+            drawCalls++;
+            begin = end;
+        }
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    else
+    {
+        for (const auto& item : sortedItems)
+        {
+            bindState(item);
+            const size_t indexSize = VertexLayout::GetIndexSize(item.indexFormat);
+            for (uint32_t c = item.firstCommand; c < item.firstCommand + item.commandsCount; c++)
+            {
+                const auto& command = sortedCommands[c];
+                glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, static_cast<GLsizei>(command.count), VertexLayout::GetIndexType(item.indexFormat),
+                                                              reinterpret_cast<const void *>(command.firstIndex * indexSize), static_cast<GLsizei>(command.instanceCount),
+                                                              command.baseVertex, command.baseInstance);
+                drawCalls++;
+            }
+        }
+    }
+
+    glBindVertexArray(0);
+
+    // material textures leave the last unit active, the passes after this one bind theirs to the first unit
+    glActiveTexture(GL_TEXTURE0);
+    return drawCalls;
+}
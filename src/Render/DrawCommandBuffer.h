@@ -0,0 +1,232 @@
+#ifndef GRAPHICS_DRAWCOMMANDBUFFER_H
+#define GRAPHICS_DRAWCOMMANDBUFFER_H
+
+#define GLEW_STATIC
+#include "glew.h"
+#include "glm/glm.hpp"
+
+#include "VertexLayout.h"
+#include "../Core/RadixSort.hpp"
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+class Mesh;
+struct ClusterCullingData;
+
+/**
+ * Layout of a single glMultiDrawElementsIndirect command
+ */
+struct DrawElementsIndirectCommand
+{
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t  baseVertex;
+    uint32_t baseInstance;
+};
+
+/**
+ * Per draw data, read by the shaders as draws[gl_BaseInstance]. Layout matches the std430 DrawData struct
+ */
+struct DrawData
+{
+    glm::mat4 model;
+    /* Upper 3x3 is the normal matrix, padded to mat4 to match the std430 layout */
+    glm::mat4 normalMatrix;
+    /* x - tiling factor, y - should be lit */
+    glm::ivec4 material;
+};
+
+static_assert(sizeof(DrawData) == 144, "DrawData must match the std430 layout");
+
+/**
+ * Mesh draw, read by the shaders as instances[gl_BaseInstance + gl_InstanceID]. Meshes of a single model share its per
+ * draw data, but each of them has its own material. Layout matches the std430 DrawInstance struct
+ */
+struct DrawInstance
+{
+    /* Index of the per draw data */
+    uint32_t drawIndex;
+    /* Material ID, as interned by the MaterialTable */
+    uint32_t materialId;
+    /* Layer of the layered framebuffer the instance is drawn into, shadow cascade for the depth draws */
+    uint32_t layer;
+};
+
+static_assert(sizeof(DrawInstance) == 12, "DrawInstance must match the std430 layout");
+
+/**
+ * Render queue of a single pass. Meshes are recorded as draw packets: indirect commands with their per draw data and
+ * material IDs. On submit packets are radix sorted by their 64-bit keys, so the draws sharing the same state are next to
+ * each other, and drawn either as multi draw indirect batches (one call per VAO, or per VAO and material, if material
+ * textures have to be bound to the texture units) or one by one, as a fallback. State already bound is never bound again.
+ * Packets of the same mesh and material, recorded by different entities, are merged into a single instanced draw
+ *
+ * Sort key layout, from the most significant bits:
+ *  - 8 bits of the material texture mask, selecting the shader variant
+ *  - 6 bits of the vertex array
+ *  - 20 bits of the material ID, zero if materials are not bound per draw
+ *  - 14 bits of the mesh, so the draws of the same geometry are next to each other
+ *  - 16 bits of the quantised distance to the view point, so the draws of the same mesh are drawn front to back
+ */
+class DrawCommandBuffer
+{
+public:
+    DrawCommandBuffer();
+
+    DrawCommandBuffer(DrawCommandBuffer&&) = delete;
+    DrawCommandBuffer(const DrawCommandBuffer&) = delete;
+
+    ~DrawCommandBuffer();
+
+    /**
+     * Removes all recorded draws
+     */
+    void Clear();
+
+    /**
+     * Records per draw data
+     * @param model model (transform) matrix
+     * @param tilingFactor material tiling factor
+     * @param shouldBeLit whether draw is lit
+     * @return draw index, to be passed as the base instance of the draw commands
+     */
+    uint32_t AddDrawData(const glm::mat4& model, int tilingFactor = 1, bool shouldBeLit = true);
+
+    /**
+     * Sets the point, draws recorded after it are sorted front to back from. Draws are not sorted by depth until it is set
+     * @param position view point in the world space, e.g. camera position
+     */
+    void SetViewPoint(const glm::vec3& position);
+
+    /**
+     * Records mesh draw with its material ID
+     * @param mesh mesh to draw
+     * @param drawIndex index of the per draw data
+     * @param lod level of detail to draw
+     * @param culling if not null and the full detail level is drawn, only the visible clusters are recorded
+     * @return number of recorded indices
+     */
+    size_t AddMesh(const Mesh& mesh, uint32_t drawIndex, int lod, const ClusterCullingData * culling);
+
+    /**
+     * Records mesh draw into the depth buffer, without material. Mesh is drawn as an instance per layer, all of them
+     * sharing the same commands
+     * @param mesh mesh to draw
+     * @param drawIndex index of the per draw data
+     * @param lod level of detail to draw
+     * @param usePositionStream if true, position only stream is used instead of the full vertices
+     * @param layerMask bit per layer to draw the mesh into, nothing is recorded if zero
+     * @return number of recorded indices, counted once per layer
+     */
+    size_t AddDepthMesh(const Mesh& mesh, uint32_t drawIndex, int lod, bool usePositionStream, uint32_t layerMask = 1);
+
+    /**
+     * Sorts and uploads recorded data, unless it is done already, and draws it with the currently used shader.
+     * Material records are expected to be bound by the MaterialTable already
+     * @param useMultiDrawIndirect if true, draws are batched into the multi draw indirect calls
+     * @param useInstancing if true, draws of the same mesh and material are merged into a single instanced draw
+     * @param bindVariant if set, draws are grouped by the texture masks of their materials and it is called with the
+     * mask before each group, to bind the shader variant sampling exactly these textures
+     * @return number of issued draw calls
+     */
+    size_t Submit(bool useMultiDrawIndirect, bool useInstancing, const std::function<void(uint32_t textureMask)>& bindVariant = nullptr);
+
+    /* Shader storage binding of the per draw data */
+    static constexpr unsigned int drawDataBinding = 0;
+
+    /* Shader storage binding of the mesh draws */
+    static constexpr unsigned int instancesBinding = 1;
+
+private:
+    struct Item
+    {
+        unsigned int vertexArray;
+        IndexFormat indexFormat;
+        uint32_t materialId;
+        /* Texture mask of the material, filled on submit */
+        uint32_t textureMask;
+        uint32_t firstCommand;
+        uint32_t commandsCount;
+        /* Instances drawn by the commands, filled on submit */
+        uint32_t firstInstance;
+        uint32_t instancesCount;
+        /* Quantised distance from the view point to the mesh bounds center */
+        uint16_t depth;
+    };
+
+    /**
+     * Everything the draws are merged into a single instanced draw by: the geometry, identified by the only command of
+     * the draw, and its state
+     */
+    struct InstancingKey
+    {
+        unsigned int vertexArray;
+        uint32_t materialId;
+        uint32_t count;
+        uint32_t firstIndex;
+        int32_t baseVertex;
+
+        bool operator ==(const InstancingKey& other) const;
+    };
+
+    struct InstancingKeyHash
+    {
+        size_t operator()(const InstancingKey& key) const;
+    };
+
+    /**
+     * @param mesh mesh to draw
+     * @param drawIndex index of the per draw data
+     * @return quantised distance from the view point to the mesh, 0 if view point is not set
+     */
+    [[nodiscard]] uint16_t GetDepth(const Mesh& mesh, uint32_t drawIndex) const;
+
+    /**
+     * @param item recorded draw
+     * @param isBindingMaterials whether material textures are bound per draw
+     * @return sort key of the draw
+     */
+    uint64_t MakeSortKey(const Item& item, bool isBindingMaterials);
+
+    /**
+     * Merges the recorded draws into the instanced ones, sorts them by their keys, rearranges their commands and
+     * instances in the sorted order and uploads the buffers
+     * @param isBindingVariants whether draws are grouped by the texture masks of their materials
+     * @param useInstancing whether draws of the same mesh and material are merged
+     */
+    void Sort(bool isBindingVariants, bool useInstancing);
+
+    /* Bit offsets of the sort key fields */
+    static constexpr uint32_t textureMaskShift = 56, vertexArrayShift = 50, materialShift = 30, meshShift = 16;
+
+    std::vector<Item> items, batches, sortedItems;
+    std::vector<DrawData> drawData;
+    std::vector<DrawInstance> instances, sortedInstances;
+    std::vector<DrawElementsIndirectCommand> commands, sortedCommands;
+    std::vector<RadixSort::Entry> sortEntries, sortScratch;
+
+    /* Batch of every recorded draw, and batches of the instanced draws by their keys */
+    std::vector<uint32_t> itemBatches;
+    std::unordered_map<InstancingKey, uint32_t, InstancingKeyHash> batchIndices;
+
+    /* Vertex arrays seen so far, the key stores their indices, as the names do not fit */
+    std::vector<unsigned int> vertexArrays;
+
+    /* Meshes of the sorted draws, by their vertex array and base vertex, the key stores their indices */
+    std::unordered_map<uint64_t, uint32_t> meshIndices;
+
+    glm::vec3 viewPoint = glm::vec3(0.0f);
+    bool hasViewPoint = false;
+
+    /* Whether recorded draws are sorted and uploaded, whether they were sorted by the texture masks and merged */
+    bool isSorted = false, isSortedByVariants = false, isInstanced = false;
+
+    unsigned int drawDataBuffer = 0, instancesBuffer = 0, commandsBuffer = 0;
+};
+
+#endif //GRAPHICS_DRAWCOMMANDBUFFER_H
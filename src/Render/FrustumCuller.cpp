@@ -0,0 +1,135 @@
+#include "FrustumCuller.h"
+
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define FRUSTUM_CULLER_SIMD
+#endif
+
+namespace
+{
+    /* Bounds large enough to never be culled, used for the invalid ones */
+    constexpr float unboundedExtent = 1e30f;
+}
+
+void FrustumCuller::Clear()
+{
+    count = 0;
+    for (auto * array : { &boxCenterX, &boxCenterY, &boxCenterZ, &boxExtentX, &boxExtentY, &boxExtentZ,
+                          &sphereCenterX, &sphereCenterY, &sphereCenterZ, &sphereRadius })
+    {
+        array->clear();
+    }
+}
+
+uint32_t FrustumCuller::Add(const BoundingBox& box, const BoundingSphere& sphere)
+{
+    const glm::vec3 center = box.IsValid() ? box.GetCenter() : glm::vec3(0.0f);
+    const glm::vec3 extents = box.IsValid() ? box.GetExtents() : glm::vec3(unboundedExtent);
+    boxCenterX.push_back(center.x);
+    boxCenterY.push_back(center.y);
+    boxCenterZ.push_back(center.z);
+    boxExtentX.push_back(extents.x);
+    boxExtentY.push_back(extents.y);
+    boxExtentZ.push_back(extents.z);
+
+    sphereCenterX.push_back(sphere.center.x);
+    sphereCenterY.push_back(sphere.center.y);
+    sphereCenterZ.push_back(sphere.center.z);
+    sphereRadius.push_back(sphere.IsValid() ? sphere.radius : unboundedExtent);
+
+    return static_cast<uint32_t>(count++);
+}
+
+size_t FrustumCuller::Cull(const Frustum& frustum)
+{
+    // padding bounds are never read back, so their content does not matter
+    const size_t paddedCount = (count + lanesCount - 1) / lanesCount * lanesCount;
+    for (auto * array : { &boxCenterX, &boxCenterY, &boxCenterZ, &boxExtentX, &boxExtentY, &boxExtentZ,
+                          &sphereCenterX, &sphereCenterY, &sphereCenterZ, &sphereRadius })
+    {
+        array->resize(paddedCount, 0.0f);
+    }
+    visibility.resize(paddedCount);
+
+#if defined(__AVX__)
+    for (size_t i = 0; i < paddedCount; i += 8)
+    {
+        const __m256 boxX = _mm256_loadu_ps(&boxCenterX[i]), boxY = _mm256_loadu_ps(&boxCenterY[i]), boxZ = _mm256_loadu_ps(&boxCenterZ[i]);
+        const __m256 extentX = _mm256_loadu_ps(&boxExtentX[i]), extentY = _mm256_loadu_ps(&boxExtentY[i]), extentZ = _mm256_loadu_ps(&boxExtentZ[i]);
+        const __m256 sphereX = _mm256_loadu_ps(&sphereCenterX[i]), sphereY = _mm256_loadu_ps(&sphereCenterY[i]), sphereZ = _mm256_loadu_ps(&sphereCenterZ[i]);
+        const __m256 radius = _mm256_loadu_ps(&sphereRadius[i]);
+
+        __m256 outside = _mm256_setzero_ps();
+        for (const auto& plane : frustum.planes)
+        {
+            const __m256 nx = _mm256_set1_ps(plane.x), ny = _mm256_set1_ps(plane.y), nz = _mm256_set1_ps(plane.z), w = _mm256_set1_ps(plane.w);
+            const __m256 ax = _mm256_set1_ps(std::abs(plane.x)), ay = _mm256_set1_ps(std::abs(plane.y)), az = _mm256_set1_ps(std::abs(plane.z));
+
+            // box is outside, if its center is farther behind the plane than its projected radius
+            const __m256 boxDistance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, boxX), _mm256_mul_ps(ny, boxY)), _mm256_add_ps(_mm256_mul_ps(nz, boxZ), w));
+            const __m256 boxRadius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, extentX), _mm256_mul_ps(ay, extentY)), _mm256_mul_ps(az, extentZ));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(boxDistance, boxRadius), _mm256_setzero_ps(), _CMP_LT_OQ));
+
+            const __m256 sphereDistance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, sphereX), _mm256_mul_ps(ny, sphereY)), _mm256_add_ps(_mm256_mul_ps(nz, sphereZ), w));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(sphereDistance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+
+        const int mask = _mm256_movemask_ps(outside);
+        for (size_t lane = 0; lane < 8; lane++)
+        {
+            visibility[i + lane] = (mask >> lane & 1) == 0;
+        }
+    }
+#elif defined(FRUSTUM_CULLER_SIMD)
+    for (size_t i = 0; i < paddedCount; i += 4)
+    {
+        const __m128 boxX = _mm_loadu_ps(&boxCenterX[i]), boxY = _mm_loadu_ps(&boxCenterY[i]), boxZ = _mm_loadu_ps(&boxCenterZ[i]);
+        const __m128 extentX = _mm_loadu_ps(&boxExtentX[i]), extentY = _mm_loadu_ps(&boxExtentY[i]), extentZ = _mm_loadu_ps(&boxExtentZ[i]);
+        const __m128 sphereX = _mm_loadu_ps(&sphereCenterX[i]), sphereY = _mm_loadu_ps(&sphereCenterY[i]), sphereZ = _mm_loadu_ps(&sphereCenterZ[i]);
+        const __m128 radius = _mm_loadu_ps(&sphereRadius[i]);
+
+        __m128 outside = _mm_setzero_ps();
+        for (const auto& plane : frustum.planes)
+        {
+            const __m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z), w = _mm_set1_ps(plane.w);
+            const __m128 ax = _mm_set1_ps(std::abs(plane.x)), ay = _mm_set1_ps(std::abs(plane.y)), az = _mm_set1_ps(std::abs(plane.z));
+
+            // box is outside, if its center is farther behind the plane than its projected radius
+            const __m128 boxDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, boxX), _mm_mul_ps(ny, boxY)), _mm_add_ps(_mm_mul_ps(nz, boxZ), w));
+            const __m128 boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, extentX), _mm_mul_ps(ay, extentY)), _mm_mul_ps(az, extentZ));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(boxDistance, boxRadius), _mm_setzero_ps()));
+
+            const __m128 sphereDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, sphereX), _mm_mul_ps(ny, sphereY)), _mm_add_ps(_mm_mul_ps(nz, sphereZ), w));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(sphereDistance, radius), _mm_setzero_ps()));
+        }
+
+        const int mask = _mm_movemask_ps(outside);
+        for (size_t lane = 0; lane < 4; lane++)
+        {
+            visibility[i + lane] = (mask >> lane & 1) == 0;
+        }
+    }
+#else
+    for (size_t i = 0; i < paddedCount; i++)
+    {
+        bool isOutside = false;
+        for (const auto& plane : frustum.planes)
+        {
+            const float boxDistance = plane.x * boxCenterX[i] + plane.y * boxCenterY[i] + plane.z * boxCenterZ[i] + plane.w;
+            const float boxRadius = std::abs(plane.x) * boxExtentX[i] + std::abs(plane.y) * boxExtentY[i] + std::abs(plane.z) * boxExtentZ[i];
+            const float sphereDistance = plane.x * sphereCenterX[i] + plane.y * sphereCenterY[i] + plane.z * sphereCenterZ[i] + plane.w;
+            isOutside |= boxDistance + boxRadius < 0.0f || sphereDistance + sphereRadius[i] < 0.0f;
+        }
+        visibility[i] = !isOutside;
+    }
+#endif
+
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        visibleCount += visibility[i];
+    }
+    return visibleCount;
+}
@@ -0,0 +1,59 @@
+#ifndef GRAPHICS_FRUSTUMCULLER_H
+#define GRAPHICS_FRUSTUMCULLER_H
+
+#include "Bounds.hpp"
+
+#include <vector>
+#include <cstdint>
+
+/**
+ * Batched frustum test of the world space bounds. Boxes and spheres are kept as the structure of arrays, so a single
+ * SIMD instruction tests a plane against 8 (AVX) or 4 (SSE) of them; bounds outside of a plane either by the box or
+ * by the sphere are culled, which is tighter than any of them alone. Falls back to the scalar test if neither
+ * instruction set is enabled at compile time
+ */
+class FrustumCuller
+{
+public:
+    /**
+     * Removes all bounds
+     */
+    void Clear();
+
+    /**
+     * Adds bounds to test, invalid ones are always visible
+     * @param box world space box
+     * @param sphere world space sphere
+     * @return index of the bounds
+     */
+    uint32_t Add(const BoundingBox& box, const BoundingSphere& sphere);
+
+    /**
+     * Tests all the added bounds against the frustum
+     * @param frustum world space frustum
+     * @return number of the visible bounds
+     */
+    size_t Cull(const Frustum& frustum);
+
+    /**
+     * @return byte per added bounds, non zero if they are visible, valid until the next Cull call
+     */
+    [[nodiscard]] inline const uint8_t * GetVisibility() const { return visibility.data(); }
+
+    /**
+     * @return number of the added bounds
+     */
+    [[nodiscard]] inline size_t GetCount() const { return count; }
+
+private:
+    /* Number of the bounds tested at once, arrays are padded to its multiple */
+    static constexpr size_t lanesCount = 8;
+
+    size_t count = 0;
+    std::vector<float> boxCenterX, boxCenterY, boxCenterZ;
+    std::vector<float> boxExtentX, boxExtentY, boxExtentZ;
+    std::vector<float> sphereCenterX, sphereCenterY, sphereCenterZ, sphereRadius;
+    std::vector<uint8_t> visibility;
+};
+
+#endif //GRAPHICS_FRUSTUMCULLER_H
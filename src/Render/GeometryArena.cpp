@@ -0,0 +1,366 @@
+#include "GeometryArena.h"
+#include "Mesh.h"
+#include "../Logging/easylogging++.h"
+
+#include <algorithm>
+
+namespace
+{
+    /* Initial capacity of every pool, in elements */
+    constexpr uint32_t initialPoolCapacity = 1u << 16;
+}
+
+void GeometryArena::Initialize()
+{
+    for (int f = 0; f < 2; f++)
+    {
+        vertexPools[f].elementSize = VertexLayout::GetSize(static_cast<VertexFormat>(f));
+        indexPools[f].elementSize = VertexLayout::GetIndexSize(static_cast<IndexFormat>(f));
+    }
+    depthPool.elementSize = sizeof(glm::vec3);
+
+    for (Pool * pool : { &vertexPools[0], &vertexPools[1], &indexPools[0], &indexPools[1], &depthPool })
+    {
+        Reallocate(* pool, initialPoolCapacity);
+    }
+
+    // attribute formats never change, only the buffers behind them do
+    for (int v = 0; v < 2; v++)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            glGenVertexArrays(1, &vertexArrays[v][i]);
+            glBindVertexArray(vertexArrays[v][i]);
+            VertexLayout::SetUpAttributes(static_cast<VertexFormat>(v));
+        }
+    }
+
+    for (auto& vao : depthVertexArrays)
+    {
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        glEnableVertexAttribArray(0);
+        glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+        glVertexAttribBinding(0, 0);
+    }
+    glBindVertexArray(0);
+
+    isInitialized = true;
+    BindBuffers();
+}
+
+GeometryHandle GeometryArena::Allocate(const MeshData& data, const std::vector<glm::vec3>& depthPositions)
+{
+    if (!isInitialized)
+    {
+        Initialize();
+    }
+
+    GeometryAllocation allocation;
+    allocation.vertexFormat = data.vertexFormat;
+    allocation.indexFormat = data.indexFormat;
+    allocation.verticesCount = static_cast<uint32_t>(data.verticesCount);
+    allocation.indicesCount = static_cast<uint32_t>(data.indicesCount);
+    allocation.isAlive = true;
+
+    auto& vertexPool = vertexPools[static_cast<int>(data.vertexFormat)];
+    auto& indexPool = indexPools[static_cast<int>(data.indexFormat)];
+
+    allocation.baseVertex = AllocateBlock(vertexPool, allocation.verticesCount);
+    allocation.firstIndex = AllocateBlock(indexPool, allocation.indicesCount);
+    allocation.depthBaseVertex = AllocateBlock(depthPool, allocation.verticesCount);
+
+    Upload(vertexPool, allocation.baseVertex, data.vertexData, data.verticesCount);
+    Upload(indexPool, allocation.firstIndex, data.indexData, data.indicesCount);
+    Upload(depthPool, allocation.depthBaseVertex, depthPositions.data(), depthPositions.size());
+
+    GeometryHandle handle;
+    if (!freeHandles.empty())
+    {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+        allocations[handle] = allocation;
+    }
+    else
+    {
+        handle = static_cast<GeometryHandle>(allocations.size());
+        allocations.push_back(allocation);
+    }
+    return handle;
+}
+
+void GeometryArena::Free(GeometryHandle handle)
+{
+    if (handle >= allocations.size() || !allocations[handle].isAlive)
+    {
+        return;
+    }
+
+    auto& allocation = allocations[handle];
+    ReleaseBlock(vertexPools[static_cast<int>(allocation.vertexFormat)], allocation.baseVertex, allocation.verticesCount);
+    ReleaseBlock(indexPools[static_cast<int>(allocation.indexFormat)], allocation.firstIndex, allocation.indicesCount);
+    ReleaseBlock(depthPool, allocation.depthBaseVertex, allocation.verticesCount);
+
+    allocation.isAlive = false;
+    freeHandles.push_back(handle);
+}
+
+unsigned int GeometryArena::GetVertexArray(VertexFormat vertexFormat, IndexFormat indexFormat)
+{
+    return vertexArrays[static_cast<int>(vertexFormat)][static_cast<int>(indexFormat)];
+}
+
+unsigned int GeometryArena::GetDepthVertexArray(IndexFormat indexFormat)
+{
+    return depthVertexArrays[static_cast<int>(indexFormat)];
+}
+
+uint32_t GeometryArena::AllocateBlock(Pool& pool, uint32_t count)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    // best fit keeps large blocks intact for the large meshes
+    auto findBlock = [&pool, count]()
+    {
+        auto best = pool.freeBlocks.end();
+        for (auto it = pool.freeBlocks.begin(); it != pool.freeBlocks.end(); ++it)
+        {
+            if (it->second >= count && (best == pool.freeBlocks.end() || it->second < best->second))
+            {
+                best = it;
+            }
+        }
+        return best;
+    };
+
+    auto block = findBlock();
+    if (block == pool.freeBlocks.end())
+    {
+        // packing live blocks turns all free space into a single trailing block, growing only if it is still too small
+        const uint32_t freeSpace = pool.capacity - pool.used;
+        Reallocate(pool, freeSpace >= count ? pool.capacity : std::max(pool.capacity * 2, pool.used + count));
+        block = findBlock();
+    }
+
+    const uint32_t offset = block->first;
+    const uint32_t remaining = block->second - count;
+    pool.freeBlocks.erase(block);
+    if (remaining > 0)
+    {
+        pool.freeBlocks.emplace(offset + count, remaining);
+    }
+
+    pool.used += count;
+    return offset;
+}
+
+void GeometryArena::ReleaseBlock(Pool& pool, uint32_t offset, uint32_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    pool.used -= count;
+    auto it = pool.freeBlocks.emplace(offset, count).first;
+
+    // merging with the following block
+    auto next = std::next(it);
+    if (next != pool.freeBlocks.end() && it->first + it->second == next->first)
+    {
+        it->second += next->second;
+        pool.freeBlocks.erase(next);
+    }
+
+    // merging with the preceding block
+    if (it != pool.freeBlocks.begin())
+    {
+        auto previous = std::prev(it);
+        if (previous->first + previous->second == it->first)
+        {
+            previous->second += it->second;
+            pool.freeBlocks.erase(it);
+        }
+    }
+}
+
+void GeometryArena::Upload(const Pool& pool, uint32_t offset, const void * data, size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // copy write target never touches the VAO state, unlike the element array one
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pool.buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset * pool.elementSize), static_cast<GLsizeiptr>(count * pool.elementSize), data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GeometryArena::Reallocate(Pool& pool, uint32_t capacity)
+{
+    unsigned int buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(capacity * pool.elementSize), nullptr, GL_STATIC_DRAW);
+
+    uint32_t offset = 0;
+    if (pool.buffer != 0)
+    {
+        // collecting offsets of all blocks living in this pool
+        std::vector<std::pair<uint32_t *, uint32_t>> blocks;
+        for (auto& allocation : allocations)
+        {
+            if (!allocation.isAlive)
+            {
+                continue;
+            }
+            if (&pool == &vertexPools[static_cast<int>(allocation.vertexFormat)])
+            {
+                blocks.emplace_back(&allocation.baseVertex, allocation.verticesCount);
+            }
+            if (&pool == &indexPools[static_cast<int>(allocation.indexFormat)])
+            {
+                blocks.emplace_back(&allocation.firstIndex, allocation.indicesCount);
+            }
+            if (&pool == &depthPool)
+            {
+                blocks.emplace_back(&allocation.depthBaseVertex, allocation.verticesCount);
+            }
+        }
+        std::sort(blocks.begin(), blocks.end(), [](const auto& a, const auto& b) { return * a.first < * b.first; });
+
+        glBindBuffer(GL_COPY_READ_BUFFER, pool.buffer);
+        for (auto& [blockOffset, count] : blocks)
+        {
+            if (count == 0)
+            {
+                continue;
+            }
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(* blockOffset * pool.elementSize),
+                                static_cast<GLintptr>(offset * pool.elementSize), static_cast<GLsizeiptr>(count * pool.elementSize));
+            * blockOffset = offset;
+            offset += count;
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &pool.buffer);
+
+        LOG(INFO) << "Geometry arena pool " << (capacity == pool.capacity ? "defragmented" : "resized") << ": " << offset << " / " << capacity
+                  << " elements of " << pool.elementSize << " bytes";
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    pool.buffer = buffer;
+    pool.capacity = capacity;
+    pool.freeBlocks.clear();
+    generation++;
+    if (capacity > offset)
+    {
+        pool.freeBlocks.emplace(offset, capacity - offset);
+    }
+
+    if (isInitialized)
+    {
+        BindBuffers();
+    }
+}
+
+void GeometryArena::BindBuffers()
+{
+    for (int v = 0; v < 2; v++)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            glBindVertexArray(vertexArrays[v][i]);
+            glBindVertexBuffer(0, vertexPools[v].buffer, 0, static_cast<GLsizei>(vertexPools[v].elementSize));
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexPools[i].buffer);
+        }
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        glBindVertexArray(depthVertexArrays[i]);
+        glBindVertexBuffer(0, depthPool.buffer, 0, static_cast<GLsizei>(depthPool.elementSize));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexPools[i].buffer);
+    }
+    glBindVertexArray(0);
+}
+
+void GeometryArena::Defragment()
+{
+    if (!isInitialized)
+    {
+        return;
+    }
+
+    for (Pool * pool : { &vertexPools[0], &vertexPools[1], &indexPools[0], &indexPools[1], &depthPool })
+    {
+        if (pool->freeBlocks.size() > 1)
+        {
+            Reallocate(* pool, pool->capacity);
+        }
+    }
+}
+
+float GeometryArena::GetFragmentation()
+{
+    float fragmentation = 0.0f;
+    for (const Pool * pool : { &vertexPools[0], &vertexPools[1], &indexPools[0], &indexPools[1], &depthPool })
+    {
+        uint32_t largest = 0, total = 0;
+        for (const auto& [offset, size] : pool->freeBlocks)
+        {
+            largest = std::max(largest, size);
+            total += size;
+        }
+        if (total > 0)
+        {
+            fragmentation = std::max(fragmentation, 1.0f - static_cast<float>(largest) / static_cast<float>(total));
+        }
+    }
+    return fragmentation;
+}
+
+size_t GeometryArena::GetMemoryUsage()
+{
+    size_t memory = 0;
+    for (const Pool * pool : { &vertexPools[0], &vertexPools[1], &indexPools[0], &indexPools[1], &depthPool })
+    {
+        memory += pool->used * pool->elementSize;
+    }
+    return memory;
+}
+
+size_t GeometryArena::GetCapacity()
+{
+    size_t memory = 0;
+    for (const Pool * pool : { &vertexPools[0], &vertexPools[1], &indexPools[0], &indexPools[1], &depthPool })
+    {
+        memory += pool->capacity * pool->elementSize;
+    }
+    return memory;
+}
+
+void GeometryArena::ShutDown()
+{
+    if (!isInitialized)
+    {
+        return;
+    }
+
+    for (Pool * pool : { &vertexPools[0], &vertexPools[1], &indexPools[0], &indexPools[1], &depthPool })
+    {
+        glDeleteBuffers(1, &pool->buffer);
+        * pool = Pool();
+    }
+
+    glDeleteVertexArrays(4, &vertexArrays[0][0]);
+    glDeleteVertexArrays(2, depthVertexArrays);
+
+    allocations.clear();
+    freeHandles.clear();
+    isInitialized = false;
+}
@@ -0,0 +1,176 @@
+#ifndef GRAPHICS_GEOMETRYARENA_H
+#define GRAPHICS_GEOMETRYARENA_H
+
+#define GLEW_STATIC
+#include "glew.h"
+#include "glm/glm.hpp"
+
+#include "VertexLayout.h"
+
+#include <map>
+#include <vector>
+#include <cstdint>
+
+struct MeshData;
+
+using GeometryHandle = uint32_t;
+constexpr GeometryHandle invalidGeometry = ~0u;
+
+/**
+ * Place of a single mesh inside of the arena buffers
+ */
+struct GeometryAllocation
+{
+    VertexFormat vertexFormat = VertexFormat::Static;
+    IndexFormat indexFormat = IndexFormat::UInt32;
+    uint32_t verticesCount = 0;
+    uint32_t indicesCount = 0;
+
+    /* Offsets inside of the arena buffers, in vertices and indices, ready to be used as draw call parameters */
+    uint32_t baseVertex = 0;
+    uint32_t firstIndex = 0;
+    uint32_t depthBaseVertex = 0;
+
+    bool isAlive = false;
+};
+
+/**
+ * Global vertex and index storage. Meshes are suballocated from a few large buffers: one vertex buffer per vertex
+ * format, one index buffer per index format and one position only buffer for the depth passes. Every pair of the
+ * vertex and index format shares a single VAO, so meshes drawn one after another need no state changes and can be
+ * batched into the multi draw indirect calls.
+ *
+ * Free space is tracked with sorted free lists, neighbouring blocks are merged on release. Buffers grow on demand;
+ * if a buffer has enough free space, but no block is large enough, it is defragmented instead of growing.
+ * Allocations may move during the defragmentation, so their offsets must be queried every frame with Get
+ */
+class GeometryArena
+{
+public:
+    /* Restriction to create an instance of this class */
+    GeometryArena() = delete;
+    GeometryArena(GeometryArena&&) = delete;
+    GeometryArena(const GeometryArena&) = delete;
+
+    /**
+     * Suballocates mesh and uploads its data
+     * @param data mesh vertices and indices
+     * @param depthPositions position only stream of the mesh vertices
+     * @return handle of the allocation
+     */
+    static GeometryHandle Allocate(const MeshData& data, const std::vector<glm::vec3>& depthPositions);
+
+    /**
+     * Releases mesh allocation. Releasing after ShutDown is a no-op
+     * @param handle handle of the allocation
+     */
+    static void Free(GeometryHandle handle);
+
+    /**
+     * @param handle handle of the allocation
+     * @return current place of the mesh inside of the arena buffers
+     */
+    static const GeometryAllocation& Get(GeometryHandle handle) { return allocations.at(handle); }
+
+    /**
+     * @param vertexFormat vertex format
+     * @param indexFormat index format
+     * @return shared VAO of the format pair
+     */
+    static unsigned int GetVertexArray(VertexFormat vertexFormat, IndexFormat indexFormat);
+
+    /**
+     * @param indexFormat index format
+     * @return shared VAO of the position only stream
+     */
+    static unsigned int GetDepthVertexArray(IndexFormat indexFormat);
+
+    /**
+     * Compacts all buffers, moving allocations to the beginning of them
+     */
+    static void Defragment();
+
+    /**
+     * @return fragmentation of the most fragmented buffer: 0 if all its free space is a single block, close to 1 if
+     * free space is spread over many small blocks
+     */
+    static float GetFragmentation();
+
+    /**
+     * @return size of all live allocations, in bytes
+     */
+    static size_t GetMemoryUsage();
+
+    /**
+     * @return size of all arena buffers, in bytes
+     */
+    static size_t GetCapacity();
+
+    /**
+     * @return number of the pool reallocations so far. Changes whenever allocations are moved, invalidating their
+     * offsets kept by the draws recorded earlier
+     */
+    static uint64_t GetGeneration() { return generation; }
+
+    /**
+     * Deletes all buffers and VAOs, must be called after all meshes are destroyed and before the OpenGL context is
+     */
+    static void ShutDown();
+
+    /* Fragmentation, at which scene switches defragment the arena */
+    static constexpr float defragmentationThreshold = 0.5f;
+
+private:
+    struct Pool
+    {
+        unsigned int buffer;
+        size_t elementSize;
+        uint32_t capacity;
+        uint32_t used;
+
+        /* Free blocks, offset to size, both in elements */
+        std::map<uint32_t, uint32_t> freeBlocks;
+    };
+
+    static void Initialize();
+
+    /**
+     * Takes a block from the pool, growing or defragmenting it if necessary
+     * @return offset of the block, in elements
+     */
+    static uint32_t AllocateBlock(Pool& pool, uint32_t count);
+
+    static void ReleaseBlock(Pool& pool, uint32_t offset, uint32_t count);
+
+    static void Upload(const Pool& pool, uint32_t offset, const void * data, size_t count);
+
+    /**
+     * Moves pool into a new buffer of the given capacity, packing live blocks at its beginning
+     * @param pool pool to resize
+     * @param capacity new capacity, in elements, must fit all live blocks
+     */
+    static void Reallocate(Pool& pool, uint32_t capacity);
+
+    /**
+     * Points the VAOs to the current pool buffers
+     */
+    static void BindBuffers();
+
+    inline static bool isInitialized = false;
+
+    inline static Pool vertexPools[2] {};
+    inline static Pool indexPools[2] {};
+    inline static Pool depthPool {};
+
+    /* Indexed by the vertex and index format */
+    inline static unsigned int vertexArrays[2][2] {};
+    inline static unsigned int depthVertexArrays[2] {};
+
+    inline static std::vector<GeometryAllocation> allocations;
+    inline static std::vector<GeometryHandle> freeHandles;
+
+    /* Incremented by every pool reallocation */
+    inline static uint64_t generation = 0;
+};
+
+#endif //GRAPHICS_GEOMETRYARENA_H
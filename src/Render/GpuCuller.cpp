@@ -0,0 +1,483 @@
+#include "GpuCuller.h"
+#include "GeometryArena.h"
+#include "MaterialTable.h"
+#include "Shader.h"
+#include "SSBO.hpp"
+#include "Model.h"
+#include "../Core/Profiler.hpp"
+
+#include <tuple>
+#include <string>
+#include <algorithm>
+
+namespace
+{
+    namespace Uniforms
+    {
+        constexpr UniformId objectsCount("objectsCount"), cascadesCount("cascadesCount");
+    }
+
+    /* Local size of the culling compute shader */
+    constexpr size_t groupSize = 64;
+
+    /* Extents of the meshes without bounds, so they are never culled */
+    constexpr float unboundedExtents = 1e30f;
+
+    void MultiDrawElementsIndirectCount(GLenum type, GLintptr indirect, GLintptr drawCount, GLsizei maxDrawCount)
+    {
+        if (GLEW_VERSION_4_6)
+        {
+            glMultiDrawElementsIndirectCount(GL_TRIANGLES, type, reinterpret_cast<const void *>(indirect), drawCount, maxDrawCount, sizeof(DrawElementsIndirectCommand));
+        }
+        else
+        {
+            glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, type, reinterpret_cast<const void *>(indirect), drawCount, maxDrawCount, sizeof(DrawElementsIndirectCommand));
+        }
+    }
+}
+
+GpuCuller::GpuCuller()
+{
+    shader = std::make_unique<Shader>(std::string(shaderPath), std::vector<std::string> { "MAX_CASCADES " + std::to_string(maxCascadesCount) });
+
+    glGenBuffers(1, &drawDataBuffer);
+    glGenBuffers(1, &objectsBuffer);
+    glGenBuffers(1, &instancesBuffer);
+    glGenBuffers(1, &shadowInstancesBuffer);
+    glGenBuffers(1, &frustaBuffer);
+    glGenBuffers(1, &commandsBuffer);
+    glGenBuffers(1, &countsBuffer);
+}
+
+GpuCuller::~GpuCuller()
+{
+    glDeleteBuffers(1, &drawDataBuffer);
+    glDeleteBuffers(1, &objectsBuffer);
+    glDeleteBuffers(1, &instancesBuffer);
+    glDeleteBuffers(1, &shadowInstancesBuffer);
+    glDeleteBuffers(1, &frustaBuffer);
+    glDeleteBuffers(1, &commandsBuffer);
+    glDeleteBuffers(1, &countsBuffer);
+}
+
+bool GpuCuller::IsSupported()
+{
+    return GLEW_VERSION_4_3 && (GLEW_VERSION_4_6 || GLEW_ARB_indirect_parameters);
+}
+
+void GpuCuller::Begin()
+{
+    recordsCount = 0;
+}
+
+void GpuCuller::AddModel(const std::shared_ptr<Model>& model, const glm::mat4& transform, const std::vector<BoundingBox>& worldBoxes,
+                         int lod, int shadowLod, int tilingFactor, bool shouldBeLit, bool castsShadow)
+{
+    const size_t index = recordsCount++;
+
+    // same model at the same place as during the last frame, only its changes are uploaded
+    if (index < records.size() && records[index].model == model)
+    {
+        auto& record = records[index];
+        const bool isMoved = record.transform != transform;
+        if (isMoved || record.tilingFactor != tilingFactor || record.shouldBeLit != shouldBeLit)
+        {
+            record.transform = transform;
+            record.tilingFactor = tilingFactor;
+            record.shouldBeLit = shouldBeLit;
+            WriteDrawData(index);
+        }
+
+        if (isMoved || record.lod != lod || record.shadowLod != shadowLod)
+        {
+            record.lod = lod;
+            record.shadowLod = shadowLod;
+            WriteObjects(index, worldBoxes);
+        }
+
+        if (record.castsShadow != castsShadow)
+        {
+            record.castsShadow = castsShadow;
+            isLayoutChanged = true;
+        }
+        return;
+    }
+
+    // instances from this one on are laid out again
+    isLayoutChanged = true;
+    records.resize(index);
+    firstObjects.resize(index);
+
+    const uint32_t firstObject = index == 0 ? 0 : firstObjects[index - 1] + static_cast<uint32_t>(records[index - 1].model->meshes.size());
+    records.push_back({ model, transform, lod, shadowLod, tilingFactor, shouldBeLit, castsShadow });
+    firstObjects.push_back(firstObject);
+
+    drawData.resize(index + 1);
+    objects.resize(firstObject + model->meshes.size());
+    instances.resize(objects.size());
+
+    WriteDrawData(index);
+    WriteObjects(index, worldBoxes);
+}
+
+void GpuCuller::WriteDrawData(size_t index)
+{
+    const auto& record = records[index];
+
+    DrawData& data = drawData[index];
+    data.model = record.transform;
+    data.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(record.transform))));
+    data.material = glm::ivec4(record.tilingFactor, record.shouldBeLit ? 1 : 0, 0, 0);
+
+    drawDataBegin = std::min(drawDataBegin, index);
+    drawDataEnd = std::max(drawDataEnd, index + 1);
+}
+
+void GpuCuller::WriteObjects(size_t index, const std::vector<BoundingBox>& worldBoxes)
+{
+    const auto& record = records[index];
+    const auto& meshes = record.model->meshes;
+    const size_t firstObject = firstObjects[index];
+
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        const Mesh& mesh = * meshes[i];
+        auto& object = objects[firstObject + i];
+
+        if (i < worldBoxes.size() && worldBoxes[i].IsValid())
+        {
+            object.center = glm::vec4(worldBoxes[i].GetCenter(), 0.0f);
+            object.extents = glm::vec4(worldBoxes[i].GetExtents(), 0.0f);
+        }
+        else
+        {
+            object.center = glm::vec4(0.0f);
+            object.extents = glm::vec4(unboundedExtents);
+        }
+        object.drawIndex = static_cast<uint32_t>(index);
+
+        // commands of the meshes without culled clusters differ only by the instances
+        scratchCommands.clear();
+        mesh.CollectDrawCommands(scratchCommands, 0, record.lod, nullptr, false);
+        const DrawElementsIndirectCommand command = scratchCommands.empty() ? DrawElementsIndirectCommand {} : scratchCommands.front();
+        object.indicesCount = command.count;
+        object.firstIndex = command.firstIndex;
+        object.baseVertex = command.baseVertex;
+
+        scratchCommands.clear();
+        mesh.CollectDrawCommands(scratchCommands, 0, record.shadowLod, nullptr, isUsingPositionStream);
+        const DrawElementsIndirectCommand shadowCommand = scratchCommands.empty() ? DrawElementsIndirectCommand {} : scratchCommands.front();
+        object.shadowIndicesCount = shadowCommand.count;
+        object.shadowFirstIndex = shadowCommand.firstIndex;
+        object.shadowBaseVertex = shadowCommand.baseVertex;
+    }
+
+    objectsBegin = std::min(objectsBegin, firstObject);
+    objectsEnd = std::max(objectsEnd, firstObject + meshes.size());
+}
+
+void GpuCuller::InternMaterials()
+{
+    // instances, no longer recorded, are dropped
+    if (recordsCount < records.size())
+    {
+        records.resize(recordsCount);
+        firstObjects.resize(recordsCount);
+        drawData.resize(recordsCount);
+        objects.resize(recordsCount == 0 ? 0 : firstObjects.back() + records.back().model->meshes.size());
+        instances.resize(objects.size());
+        isLayoutChanged = true;
+    }
+
+    if (isLayoutChanged)
+    {
+        materials.clear();
+        for (const auto& record : records)
+        {
+            for (const auto& mesh : record.model->meshes)
+            {
+                materials.emplace(&mesh->material, std::make_pair(MaterialTable::invalidId, 0u));
+            }
+        }
+    }
+
+    // materials go cold unless they are interned every frame, which may give them the new IDs
+    for (auto& [material, state] : materials)
+    {
+        const uint32_t id = material->GetId();
+        if (id != state.first)
+        {
+            state.first = id;
+            isLayoutChanged = true;
+        }
+    }
+}
+
+void GpuCuller::Update(bool usePositionStream)
+{
+    if (usePositionStream != isUsingPositionStream)
+    {
+        isUsingPositionStream = usePositionStream;
+        isLayoutChanged = true;
+        RewriteObjects();
+    }
+
+    // arena moved the geometry, so the offsets of the unchanged meshes are stale as well
+    if (GeometryArena::GetGeneration() != arenaGeneration)
+    {
+        arenaGeneration = GeometryArena::GetGeneration();
+        RewriteObjects();
+    }
+
+    // residency changes with the streaming, moving the materials between the variants
+    for (auto& [material, state] : materials)
+    {
+        const uint32_t textureMask = MaterialTable::GetTextureMask(state.first);
+        if (textureMask != state.second)
+        {
+            state.second = textureMask;
+            isLayoutChanged = true;
+        }
+    }
+
+    if (isLayoutChanged)
+    {
+        RebuildBuckets();
+        isLayoutChanged = false;
+    }
+
+    Upload(drawDataBuffer, drawDataCapacity, drawData.data(), sizeof(DrawData), drawData.size(), drawDataBegin, drawDataEnd);
+    Upload(objectsBuffer, objectsCapacity, objects.data(), sizeof(GpuCullObject), objects.size(), objectsBegin, objectsEnd);
+    Upload(instancesBuffer, instancesCapacity, instances.data(), sizeof(DrawInstance), instances.size(), objectsBegin, objectsEnd);
+    drawDataBegin = objectsBegin = SIZE_MAX;
+    drawDataEnd = objectsEnd = 0;
+}
+
+void GpuCuller::RewriteObjects()
+{
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const auto& meshes = records[i].model->meshes;
+        std::vector<BoundingBox> worldBoxes(meshes.size());
+        for (size_t m = 0; m < meshes.size(); m++)
+        {
+            worldBoxes[m] = meshes[m]->GetBounds().Transformed(records[i].transform);
+        }
+        WriteObjects(i, worldBoxes);
+    }
+}
+
+void GpuCuller::RebuildBuckets()
+{
+    buckets.clear();
+    shadowBuckets.clear();
+
+    // parameters and bindless handles are fetched by the material ID, only the texture units depend on the material
+    const bool isBindingMaterials = !Texture::IsBindlessEnabled();
+
+    std::map<std::tuple<uint32_t, unsigned int, uint32_t>, uint32_t> bucketIndices;
+    std::map<unsigned int, uint32_t> shadowBucketIndices;
+    for (size_t r = 0; r < records.size(); r++)
+    {
+        const auto& record = records[r];
+        const auto& meshes = record.model->meshes;
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            const Mesh& mesh = * meshes[i];
+            const size_t o = firstObjects[r] + i;
+            auto& object = objects[o];
+
+            const auto& [materialId, textureMask] = materials.at(&mesh.material);
+            object.materialId = materialId;
+            instances[o] = { static_cast<uint32_t>(r), materialId, 0 };
+
+            const unsigned int vertexArray = GeometryArena::GetVertexArray(mesh.GetVertexFormat(), mesh.GetIndexFormat());
+            const auto key = std::make_tuple(textureMask, vertexArray, isBindingMaterials ? materialId : MaterialTable::invalidId);
+            const auto [it, isInserted] = bucketIndices.try_emplace(key, static_cast<uint32_t>(buckets.size()));
+            if (isInserted)
+            {
+                buckets.push_back({ vertexArray, mesh.GetIndexFormat(), materialId, textureMask, 0, 0 });
+            }
+            object.bucket = it->second;
+            buckets[it->second].capacity++;
+
+            object.shadowBucket = noBucket;
+            if (record.castsShadow)
+            {
+                const unsigned int shadowVertexArray = isUsingPositionStream ? GeometryArena::GetDepthVertexArray(mesh.GetIndexFormat()) : vertexArray;
+                const auto [shadowIt, isShadowInserted] = shadowBucketIndices.try_emplace(shadowVertexArray, static_cast<uint32_t>(shadowBuckets.size()));
+                if (isShadowInserted)
+                {
+                    shadowBuckets.push_back({ shadowVertexArray, mesh.GetIndexFormat(), MaterialTable::invalidId, 0, 0, 0 });
+                }
+                object.shadowBucket = shadowIt->second;
+                shadowBuckets[shadowIt->second].capacity++;
+            }
+        }
+    }
+
+    // every bucket reserves a command per its mesh, the G-pass ones go first
+    uint32_t commandsCount = 0;
+    for (auto* passBuckets : { &buckets, &shadowBuckets })
+    {
+        for (auto& bucket : * passBuckets)
+        {
+            bucket.firstCommand = commandsCount;
+            commandsCount += bucket.capacity;
+        }
+    }
+    // counts of the shadow buckets follow the G-pass ones
+    for (auto& object : objects)
+    {
+        object.firstCommand = buckets[object.bucket].firstCommand;
+        if (object.shadowBucket != noBucket)
+        {
+            object.shadowFirstCommand = shadowBuckets[object.shadowBucket].firstCommand;
+            object.shadowBucket += static_cast<uint32_t>(buckets.size());
+        }
+    }
+    objectsBegin = 0;
+    objectsEnd = objects.size();
+
+    // buffers written by the culling shader only need to be large enough
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandsBuffer);
+    SSBO::Grow(commandsCapacity, std::max<size_t>(commandsCount, 1) * sizeof(DrawElementsIndirectCommand), GL_DYNAMIC_COPY);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, shadowInstancesBuffer);
+    SSBO::Grow(shadowInstancesCapacity, std::max<size_t>(objects.size(), 1) * maxCascadesCount * sizeof(DrawInstance), GL_DYNAMIC_COPY);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, countsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(std::max<size_t>(buckets.size() + shadowBuckets.size(), 1) * sizeof(uint32_t)), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuCuller::Upload(unsigned int buffer, size_t& capacity, const void * data, size_t elementSize, size_t count, size_t begin, size_t end)
+{
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    if (SSBO::Grow(capacity, std::max<size_t>(count, 64) * elementSize, GL_DYNAMIC_DRAW))
+    {
+        begin = 0;
+        end = count;
+    }
+
+    end = std::min(end, count);
+    if (begin < end)
+    {
+        const size_t size = (end - begin) * elementSize;
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, static_cast<GLintptr>(begin * elementSize), static_cast<GLsizeiptr>(size),
+                        static_cast<const char *>(data) + begin * elementSize);
+        Profiler::gpuCullingBytesUploaded += size;
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuCuller::Cull(const Frustum& camera, const glm::mat4 * cascades, size_t cascadesCount)
+{
+    if (objects.empty())
+    {
+        return;
+    }
+
+    // planes of the camera frustum, followed by the planes of each cascade
+    cascadesCount = std::min<size_t>(cascadesCount, maxCascadesCount);
+    planes.assign(std::begin(camera.planes), std::end(camera.planes));
+    for (size_t cascade = 0; cascade < cascadesCount; cascade++)
+    {
+        const Frustum frustum(cascades[cascade]);
+        planes.insert(planes.end(), std::begin(frustum.planes), std::end(frustum.planes));
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, frustaBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(planes.size() * sizeof(glm::vec4)), planes.data(), GL_STREAM_DRAW);
+
+    const uint32_t zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, countsBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, objectsBinding, objectsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, frustaBinding, frustaBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, commandsBinding, commandsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, countsBinding, countsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, shadowInstancesBinding, shadowInstancesBuffer);
+
+    shader->Use();
+    shader->setInt(Uniforms::objectsCount, static_cast<int>(objects.size()));
+    shader->setInt(Uniforms::cascadesCount, static_cast<int>(cascadesCount));
+    glDispatchCompute(static_cast<GLuint>((objects.size() + groupSize - 1) / groupSize), 1, 1);
+
+    // commands and counts are read by the draws, shadow instances by the vertex shaders
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+size_t GpuCuller::SubmitGeometry(const std::function<void(uint32_t textureMask)>& bindVariant)
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DrawCommandBuffer::drawDataBinding, drawDataBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DrawCommandBuffer::instancesBinding, instancesBuffer);
+    return Submit(buckets, 0, bindVariant);
+}
+
+size_t GpuCuller::SubmitShadows()
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DrawCommandBuffer::drawDataBinding, drawDataBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DrawCommandBuffer::instancesBinding, shadowInstancesBuffer);
+    return Submit(shadowBuckets, buckets.size(), nullptr);
+}
+
+size_t GpuCuller::Submit(const std::vector<Bucket>& passBuckets, size_t firstBucket, const std::function<void(uint32_t textureMask)>& bindVariant)
+{
+    if (passBuckets.empty())
+    {
+        return 0;
+    }
+
+    const bool isBindingMaterials = !Texture::IsBindlessEnabled();
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandsBuffer);
+    glBindBuffer(GL_PARAMETER_BUFFER, countsBuffer);
+
+    size_t drawCalls = 0;
+    unsigned int boundVertexArray = 0;
+    uint32_t boundMaterial = MaterialTable::invalidId;
+    uint32_t boundMask = UINT32_MAX;
+    for (size_t i = 0; i < passBuckets.size(); i++)
+    {
+        const auto& bucket = passBuckets[i];
+        if (bindVariant && bucket.textureMask != boundMask)
+        {
+            bindVariant(bucket.textureMask);
+            boundMask = bucket.textureMask;
+            Profiler::variantSwitches++;
+        }
+        if (bucket.vertexArray != boundVertexArray)
+        {
+            glBindVertexArray(bucket.vertexArray);
+            boundVertexArray = bucket.vertexArray;
+            Profiler::vertexArrayBinds++;
+        }
+        else
+        {
+            Profiler::skippedBinds++;
+        }
+        if (isBindingMaterials && bucket.materialId != MaterialTable::invalidId && bucket.materialId != boundMaterial)
+        {
+            MaterialTable::BindTextures(bucket.materialId);
+            boundMaterial = bucket.materialId;
+            Profiler::materialBinds++;
+        }
+
+        // count of the visible meshes is read by the driver, the bucket capacity only bounds it
+        MultiDrawElementsIndirectCount(VertexLayout::GetIndexType(bucket.indexFormat),
+                                       static_cast<GLintptr>(bucket.firstCommand * sizeof(DrawElementsIndirectCommand)),
+                                       static_cast<GLintptr>((firstBucket + i) * sizeof(uint32_t)), static_cast<GLsizei>(bucket.capacity));
+        drawCalls++;
+    }
+
+    glBindBuffer(GL_PARAMETER_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+
+    // material textures leave the last unit active, the passes after this one bind theirs to the first unit
+    glActiveTexture(GL_TEXTURE0);
+    return drawCalls;
+}
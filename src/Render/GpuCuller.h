@@ -0,0 +1,248 @@
+#ifndef GRAPHICS_GPUCULLER_H
+#define GRAPHICS_GPUCULLER_H
+
+#define GLEW_STATIC
+#include "glew.h"
+#include "glm/glm.hpp"
+
+#include "Bounds.hpp"
+#include "DrawCommandBuffer.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+class Model;
+class Shader;
+class Material;
+
+/**
+ * Mesh of a model instance, as tested by the culling compute shader. Layout matches the std430 CullObject struct
+ */
+struct GpuCullObject
+{
+    /* World bounding box center and extents, w is unused */
+    glm::vec4 center;
+    glm::vec4 extents;
+
+    uint32_t drawIndex;
+    uint32_t materialId;
+    /* G-pass bucket and its first command */
+    uint32_t bucket;
+    uint32_t firstCommand;
+
+    /* G-pass command of the selected level of detail */
+    uint32_t indicesCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    /* Shadow pass bucket, counted after the G-pass ones, noBucket if mesh casts no shadow */
+    uint32_t shadowBucket;
+
+    /* Shadow pass command of the selected level of detail, and the first command of the shadow bucket */
+    uint32_t shadowIndicesCount;
+    uint32_t shadowFirstIndex;
+    int32_t shadowBaseVertex;
+    uint32_t shadowFirstCommand;
+};
+
+static_assert(sizeof(GpuCullObject) == 80, "GpuCullObject must match the std430 layout");
+
+/**
+ * GPU driven draws of the geometry and shadow passes. Model instances and their meshes are kept in the persistent
+ * shader storage buffers, so only the changed ones are uploaded. A compute shader tests the meshes against the camera
+ * and the cascades frusta and writes the indirect commands of the visible ones, compacted per bucket of the draws
+ * sharing the same state, along with their counts. Every bucket is drawn with a single glMultiDrawElementsIndirectCount,
+ * so the CPU never builds the draw lists.
+ *
+ * Model instances are expected in the same order every frame, the ones matching the instances of the last frame are
+ * compared and uploaded only if they changed. Any other change rebuilds the buckets
+ */
+class GpuCuller
+{
+public:
+    GpuCuller();
+
+    GpuCuller(GpuCuller&&) = delete;
+    GpuCuller(const GpuCuller&) = delete;
+
+    ~GpuCuller();
+
+    /**
+     * @return true if the driver can draw with the indirect draw counts
+     */
+    static bool IsSupported();
+
+    /**
+     * Starts recording the model instances of the frame
+     */
+    void Begin();
+
+    /**
+     * Records model instance
+     * @param model model to draw
+     * @param transform model (transform) matrix
+     * @param worldBoxes world bounding box of each model mesh
+     * @param lod level of detail to draw in the G-pass
+     * @param shadowLod level of detail to draw in the shadow pass
+     * @param tilingFactor material tiling factor
+     * @param shouldBeLit whether model is lit
+     * @param castsShadow whether model is drawn into the shadow cascades
+     */
+    void AddModel(const std::shared_ptr<Model>& model, const glm::mat4& transform, const std::vector<BoundingBox>& worldBoxes,
+                  int lod, int shadowLod, int tilingFactor, bool shouldBeLit, bool castsShadow);
+
+    /**
+     * Interns materials of the recorded meshes, so they are kept by the MaterialTable. Must be called before it is
+     * updated
+     */
+    void InternMaterials();
+
+    /**
+     * Rebuilds the buckets if needed and uploads the changed instances. Must be called after the MaterialTable is
+     * updated, as the buckets depend on the texture masks of the materials
+     * @param usePositionStream if true, shadow casters are drawn with the position only stream
+     */
+    void Update(bool usePositionStream);
+
+    /**
+     * Runs the culling compute shader, writing the commands of both passes
+     * @param camera camera frustum in the world space
+     * @param cascades light space matrices of the cascades
+     * @param cascadesCount number of the cascades, shadow commands are not written if zero
+     */
+    void Cull(const Frustum& camera, const glm::mat4 * cascades, size_t cascadesCount);
+
+    /**
+     * Draws the G-pass buckets with the currently used shader
+     * @param bindVariant called with the texture mask before each bucket with a different one, to bind the shader
+     * variant sampling exactly these textures
+     * @return number of issued draw calls
+     */
+    size_t SubmitGeometry(const std::function<void(uint32_t textureMask)>& bindVariant);
+
+    /**
+     * Draws the shadow buckets with the currently used shader, as an instance per cascade each mesh is visible in
+     * @return number of issued draw calls
+     */
+    size_t SubmitShadows();
+
+    /**
+     * @return number of the recorded meshes
+     */
+    [[nodiscard]] size_t GetObjectsCount() const { return objects.size(); }
+
+    /* Shader storage bindings of the culling compute shader */
+    static constexpr unsigned int objectsBinding = 3, frustaBinding = 4, commandsBinding = 5, countsBinding = 6, shadowInstancesBinding = 7;
+
+    /* Shadow instances reserved per mesh */
+    static constexpr uint32_t maxCascadesCount = 16;
+
+    /* Bucket of the meshes, which cast no shadow */
+    static constexpr uint32_t noBucket = UINT32_MAX;
+
+    /* Culling compute shader */
+    static constexpr const char * shaderPath = "../res/shaders/cull.cs.glsl";
+
+private:
+    struct Record
+    {
+        std::shared_ptr<Model> model;
+        glm::mat4 transform;
+        int lod, shadowLod, tilingFactor;
+        bool shouldBeLit, castsShadow;
+    };
+
+    /**
+     * Run of the commands drawn with the same state
+     */
+    struct Bucket
+    {
+        unsigned int vertexArray;
+        IndexFormat indexFormat;
+        uint32_t materialId;
+        uint32_t textureMask;
+        uint32_t firstCommand;
+        uint32_t capacity;
+    };
+
+    /**
+     * Fills the per draw data of the record
+     * @param index record index
+     */
+    void WriteDrawData(size_t index);
+
+    /**
+     * Fills the bounds and the commands of the record meshes, keeping their buckets
+     * @param index record index
+     * @param worldBoxes world bounding box of each model mesh
+     */
+    void WriteObjects(size_t index, const std::vector<BoundingBox>& worldBoxes);
+
+    /**
+     * Fills the bounds and the commands of all the recorded meshes again, keeping their buckets
+     */
+    void RewriteObjects();
+
+    /**
+     * Assigns every mesh to the buckets of both passes and reserves their commands
+     */
+    void RebuildBuckets();
+
+    /**
+     * Binds the buckets state and draws them
+     * @param passBuckets buckets to draw
+     * @param firstBucket index of the first bucket count
+     * @param bindVariant if set, called with the texture mask of the bucket
+     * @return number of issued draw calls
+     */
+    size_t Submit(const std::vector<Bucket>& passBuckets, size_t firstBucket, const std::function<void(uint32_t textureMask)>& bindVariant);
+
+    /**
+     * Uploads range of the elements, growing the buffer if needed
+     * @param buffer buffer to upload to
+     * @param capacity buffer capacity, in bytes
+     * @param data first element
+     * @param elementSize size of a single element
+     * @param count number of the elements
+     * @param begin first changed element
+     * @param end element past the last changed one
+     */
+    static void Upload(unsigned int buffer, size_t& capacity, const void * data, size_t elementSize, size_t count, size_t begin, size_t end);
+
+    std::unique_ptr<Shader> shader;
+
+    std::vector<Record> records;
+    /* First mesh of each record */
+    std::vector<uint32_t> firstObjects;
+    size_t recordsCount = 0;
+
+    std::vector<DrawData> drawData;
+    std::vector<GpuCullObject> objects;
+    /* G-pass instance of each mesh, shadow instances are written by the culling shader */
+    std::vector<DrawInstance> instances;
+
+    std::vector<Bucket> buckets, shadowBuckets;
+
+    /* Frusta planes of the current frame and the commands of a single mesh, kept to avoid allocations */
+    std::vector<glm::vec4> planes;
+    std::vector<DrawElementsIndirectCommand> scratchCommands;
+
+    /* Materials of the meshes, with the IDs and texture masks the buckets were built with */
+    std::map<const Material *, std::pair<uint32_t, uint32_t>> materials;
+
+    /* Ranges of the data changed since the last upload */
+    size_t drawDataBegin = SIZE_MAX, drawDataEnd = 0, objectsBegin = SIZE_MAX, objectsEnd = 0;
+
+    bool isLayoutChanged = true, isUsingPositionStream = true;
+
+    /* Geometry arena generation the commands of the meshes were filled at */
+    uint64_t arenaGeneration = 0;
+
+    unsigned int drawDataBuffer = 0, objectsBuffer = 0, instancesBuffer = 0, shadowInstancesBuffer = 0;
+    unsigned int frustaBuffer = 0, commandsBuffer = 0, countsBuffer = 0;
+    size_t drawDataCapacity = 0, objectsCapacity = 0, instancesCapacity = 0, shadowInstancesCapacity = 0, commandsCapacity = 0;
+};
+
+#endif //GRAPHICS_GPUCULLER_H
@@ -5,62 +5,282 @@
 #include <mutex>
 #include <thread>
 #include <future>
+#include <chrono>
 #include "json.hpp"
 #include <functional>
 #include "Material.h"
+#include "TextureCache.h"
+#include "MaterialTable.h"
+#include "MipGenerator.h"
+#include "TextureStreamer.h"
+#include "TextureRegistry.h"
+#include "TextureCompressor.h"
 #include "../Core/EngineException.h"
 #include "../Core/Profiler.hpp"
+#include "../Core/ThreadPool.hpp"
 
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 
-Texture::Texture(const std::string& path, bool /*gamma*/) : path(path)
+Texture::Texture(const std::string& path, TextureType usage) : textureType(GL_TEXTURE_2D), usage(usage), isResident(false), path(path)
 {
-    textureType = GL_TEXTURE_2D;
+}
 
-    stbi_set_flip_vertically_on_load(0);
+std::shared_ptr<ImageData> Texture::Decode(const std::string& path)
+{
+    auto image = std::make_shared<ImageData>();
 
-    int nrComponents = 0;
+    // flipping is controlled per thread, so decoding on the workers never races with the main thread
+    stbi_set_flip_vertically_on_load_thread(0);
 
-    unsigned char * data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
+    image->pixels.reset(stbi_load(path.c_str(), &image->width, &image->height, &image->components, 0));
 
-    ASSERT(data != nullptr, "Failed to load texture " + path + "Reason: " + std::string(stbi_failure_reason() == nullptr ? "" : stbi_failure_reason()));
+    ASSERT(image->pixels != nullptr, "Failed to load texture " + path + "Reason: " + std::string(stbi_failure_reason() == nullptr ? "" : stbi_failure_reason()));
+    return image;
+}
 
-    GLenum format = 0;
-    if (nrComponents == 1)
+std::shared_ptr<TextureData> Texture::LoadData(const std::string& path, TextureType usage)
+{
+    // cache written with the other compression setting is ignored
+    if (auto cached = TextureCache::Load(path, usage); cached && cached->IsCompressed() == TextureCompressor::IsEnabled())
     {
-        format = GL_RED;
+        return cached;
     }
-    else if (nrComponents == 3)
+
+    auto image = Decode(path);
+    auto processStart = std::chrono::high_resolution_clock::now();
+
+    std::shared_ptr<TextureData> data;
+    if (TextureCompressor::IsEnabled())
     {
-        format = GL_RGB;
+        data = TextureCompressor::Compress(* image, usage);
     }
-    else if (nrComponents == 4)
+    else
     {
-        format = GL_RGBA;
+        data = MipGenerator::Generate(* image, MipGenerator::SelectFilter(usage));
     }
+    LOG(INFO) << "Texture " << path << " mip chain " << (data->IsCompressed() ? "compressed" : "generated") << " in "
+              << std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(std::chrono::high_resolution_clock::now() - processStart).count() << " ms";
 
-    glGenTextures(1, &id);
-    glBindTexture(textureType, id);
+    TextureCache::Save(path, usage, * data);
+    return data;
+}
+
+void Texture::Initialize(const TextureData& data)
+{
+    if (levelSizes.size() == data.levels.size() && internalFormat == data.internalFormat &&
+        width == data.levels.front().width && height == data.levels.front().height)
+    {
+        return;
+    }
+
+    // source image has changed since the texture was loaded, levels of the current storage are no longer valid
+    Evict();
+
+    width = data.levels.front().width;
+    height = data.levels.front().height;
+    internalFormat = data.internalFormat;
+
+    levelSizes.clear();
+    for (const auto& level : data.levels)
+    {
+        levelSizes.push_back(level.size);
+    }
+    allocatedLevel = residentLevel = levelSizes.size();
+}
+
+void Texture::Reallocate(size_t firstLevel)
+{
+    const auto levelsCount = levelSizes.size();
+    const int levelWidth = std::max(width >> firstLevel, 1), levelHeight = std::max(height >> firstLevel, 1);
+
+    unsigned int storage = 0;
+    glGenTextures(1, &storage);
+    glBindTexture(textureType, storage);
 
     glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(textureType, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(textureType, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // whole mip chain always comes with the data, so the GPU never generates it
+    glTexStorage2D(textureType, static_cast<GLsizei>(levelsCount - firstLevel), internalFormat, levelWidth, levelHeight);
+    glBindTexture(textureType, 0);
 
-    glTexImage2D(textureType, 0, static_cast<int>(format), width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(textureType);
+    // uploaded levels, present in both storages, never go through the CPU again
+    const size_t firstCopied = std::max(firstLevel, residentLevel);
+    for (size_t level = firstCopied; id != 0 && level < levelsCount; level++)
+    {
+        glCopyImageSubData(id, textureType, static_cast<GLint>(level - allocatedLevel), 0, 0, 0,
+                           storage, textureType, static_cast<GLint>(level - firstLevel), 0, 0, 0,
+                           std::max(width >> level, 1), std::max(height >> level, 1), 1);
+    }
 
-    LOG(INFO) << "Texture " << path << " loaded, taking " << nrComponents * width * height << " bytes of memory; Generated id: " << id;
-    stbi_image_free(data);
+    ReleaseHandle();
+    glDeleteTextures(1, &id);
+    id = storage;
+    allocatedLevel = firstLevel;
+    memoryUsage = GetMemoryUsage(firstLevel);
+
+    if (isResident)
+    {
+        SetResidentLevel(firstCopied);
+    }
+    else
+    {
+        residentLevel = levelsCount;
+    }
+}
+
+void Texture::SetResidentLevel(size_t level)
+{
+    ReleaseHandle();
+    residentLevel = level;
+    isResident = true;
+
+    // sampling never reaches the levels, which are not uploaded yet
+    glBindTexture(textureType, id);
+    glTexParameteri(textureType, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(level - allocatedLevel));
+    glTexParameterf(textureType, GL_TEXTURE_MIN_LOD, static_cast<float>(level - allocatedLevel));
+    glBindTexture(textureType, 0);
+}
+
+void Texture::FinishStreaming()
+{
+    isStreaming = false;
+    LOG(INFO) << "Texture " << path << " streamed to level " << residentLevel << ", taking " << memoryUsage << " bytes of memory; Generated id: " << id;
+}
+
+void Texture::Evict()
+{
+    ReleaseHandle();
+    glDeleteTextures(1, &id);
+    id = 0;
+    memoryUsage = 0;
+    allocatedLevel = residentLevel = levelSizes.size();
+    isResident = false;
+}
+
+size_t Texture::GetMemoryUsage(size_t firstLevel) const
+{
+    size_t size = 0;
+    for (size_t i = firstLevel; i < levelSizes.size(); i++)
+    {
+        size += levelSizes[i];
+    }
+    return size;
+}
+
+unsigned int Texture::GetId() const
+{
+    lastUsedFrame = TextureRegistry::GetFrame();
+    return isResident ? id : GetPlaceholderId();
+}
+
+uint64_t Texture::GetHandle() const
+{
+    lastUsedFrame = TextureRegistry::GetFrame();
+    if (!isResident)
+    {
+        return GetPlaceholderHandle();
+    }
+
+    if (handle == 0 && levelSizes.empty())
+    {
+        // texture is not streamed, so its parameters are never changed again
+        handle = glGetTextureHandleARB(id);
+        glMakeTextureHandleResidentARB(handle);
+    }
+    else if (handle == 0)
+    {
+        // handle freezes the parameters of the texture it is created for, so it is created for a view of the uploaded
+        // levels, and streaming keeps changing the base level of the texture itself
+        const auto firstLevel = static_cast<GLuint>(residentLevel - allocatedLevel);
+        const auto levelsCount = static_cast<GLuint>(levelSizes.size() - residentLevel);
+
+        glGenTextures(1, &handleView);
+        glTextureView(handleView, textureType, id, internalFormat, firstLevel, levelsCount, 0, 1);
+        glBindTexture(textureType, handleView);
+        glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(textureType, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(textureType, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(textureType, 0);
+
+        handle = glGetTextureHandleARB(handleView);
+        glMakeTextureHandleResidentARB(handle);
+    }
+    return handle;
+}
+
+void Texture::ReleaseHandle() const
+{
+    if (handle == 0)
+    {
+        return;
+    }
+
+    // draws, already issued with the handle, are completed by the driver before the view is destroyed
+    glMakeTextureHandleNonResidentARB(handle);
+    if (handleView != 0)
+    {
+        glDeleteTextures(1, &handleView);
+    }
+    handle = 0;
+    handleView = 0;
+}
+
+void Texture::SetBindlessEnabled(bool enabled)
+{
+    isBindlessEnabled = enabled && GLEW_ARB_bindless_texture;
+    if (enabled && !isBindlessEnabled)
+    {
+        LOG(WARNING) << "ARB_bindless_texture is not supported, material textures are bound to the texture units";
+    }
+}
+
+unsigned int Texture::GetPlaceholderId()
+{
+    if (placeholderId == 0)
+    {
+        constexpr unsigned char white[] = { 255, 255, 255, 255 };
+
+        glGenTextures(1, &placeholderId);
+        glBindTexture(GL_TEXTURE_2D, placeholderId);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    return placeholderId;
+}
+
+uint64_t Texture::GetPlaceholderHandle()
+{
+    if (placeholderHandle == 0)
+    {
+        placeholderHandle = glGetTextureHandleARB(GetPlaceholderId());
+        glMakeTextureHandleResidentARB(placeholderHandle);
+    }
+    return placeholderHandle;
+}
+
+void Texture::DeletePlaceholder()
+{
+    if (placeholderHandle != 0)
+    {
+        glMakeTextureHandleNonResidentARB(placeholderHandle);
+        placeholderHandle = 0;
+    }
+    glDeleteTextures(1, &placeholderId);
+    placeholderId = 0;
 }
 
 Texture::~Texture()
 {
+    ReleaseHandle();
     glDeleteTextures(1, &id);
 }
 
@@ -90,7 +310,6 @@ Texture::Texture(GLsizei width, GLsizei height, unsigned int format, unsigned in
         glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_REPEAT);
     }
-    glGenerateMipmap(textureType);
 }
 
 std::shared_ptr<Texture> Texture::CreateTextureArray(GLsizei width, GLsizei height, unsigned int textureArraySize, unsigned int format, unsigned int internalFormat, unsigned int pixelType, bool repeat)
@@ -106,7 +325,6 @@ std::shared_ptr<Texture> Texture::CreateTextureArray(GLsizei width, GLsizei heig
     glTexImage3D(
             temp->textureType, 0, static_cast<GLsizei>(internalFormat), width, height, static_cast<GLsizei>(textureArraySize) + 1,
             0, format, GL_FLOAT, nullptr);
-    glGenerateMipmap(temp->textureType);
 
     glTexParameteri(temp->textureType, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(temp->textureType, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -127,150 +345,62 @@ std::shared_ptr<Texture> Texture::CreateTextureArray(GLsizei width, GLsizei heig
     return temp;
 }
 
-Material::Material(const aiMaterial *material, const std::string &directory)
+Material::Material(const MaterialData& data, const ImageMap * images) : specular(data.specular), defaultColor(data.defaultColor)
 {
-    aiColor4D diffuse;
-    if(aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &diffuse) == AI_SUCCESS)
-    {
-        defaultColor = glm::vec4(diffuse.r, diffuse.g, diffuse.b, diffuse.a);
-    }
-    if (material->Get(AI_MATKEY_SPECULAR_FACTOR, specular) != AI_SUCCESS)
+    // every texture type has to be present in the map, as Bind accesses them unconditionally
+    materialTextures[Normal];
+    materialTextures[Diffuse];
+    materialTextures[Specular];
+    materialTextures[Metallic];
+    materialTextures[Roughness];
+
+    for (const auto& [type, path] : data.textures)
     {
-        specular = 0.0f;
+        std::shared_ptr<TextureData> texture = nullptr;
+        if (images != nullptr && images->find(path) != images->end())
+        {
+            texture = images->at(path);
+        }
+        materialTextures[type].push_back(LoadTexture(path, type, texture));
     }
-
-    LoadTextures(material, directory, aiTextureType_NORMALS, Normal);
-    LoadTextures(material, directory, aiTextureType_DIFFUSE, Diffuse);
-    LoadTextures(material, directory, aiTextureType_SPECULAR, Specular);
-    LoadTextures(material, directory, aiTextureType_METALNESS, Metallic);
-    LoadTextures(material, directory, aiTextureType_DIFFUSE_ROUGHNESS, Roughness);
 }
 
-void Material::Bind(const std::shared_ptr<Shader>& shader) const
+MaterialData Material::ReadMaterialData(const aiMaterial *material, const std::string &directory)
 {
-    // bind appropriate textures
-    unsigned int texturesCount = 0;
-    shader->setFloat("material.specular", specular);
-    shader->setFloat("material.metallic", metallic);
-    shader->setFloat("material.roughness", roughness);
-    shader->setVec4("material.colorDiffuse", defaultColor);
-
-    if (materialTextures.at(Diffuse).empty())
-    {
-        shader->setBool("material.hasDiffuseTexture", false);
-        glActiveTexture(GL_TEXTURE0 + texturesCount); // active proper texture unit before binding
-        shader->setInt("material.mapDiffuse_1", (int) texturesCount++);
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
-    else
-    {
-        shader->setBool("material.hasDiffuseTexture", true);
-        for(const auto& texture : materialTextures.at(Diffuse))
-        {
-            unsigned int count = 1;
-            glActiveTexture(GL_TEXTURE0 + texturesCount); // active proper texture unit before binding
-            shader->setInt("material.mapDiffuse_" + std::to_string(count++), (int) texturesCount++);
-            glBindTexture(GL_TEXTURE_2D, texture->GetId());
-        }
-    }
+    MaterialData data;
 
-    if (materialTextures.at(Normal).empty())
+    aiColor4D diffuse;
+    if(aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &diffuse) == AI_SUCCESS)
     {
-        shader->setBool("material.hasNormalTexture", false);
-        glActiveTexture(GL_TEXTURE0 + texturesCount); // active proper texture unit before binding
-        shader->setInt("material.mapNormal_1", (int) texturesCount++);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        data.defaultColor = glm::vec4(diffuse.r, diffuse.g, diffuse.b, diffuse.a);
     }
-    else
+    if (material->Get(AI_MATKEY_SPECULAR_FACTOR, data.specular) != AI_SUCCESS)
     {
-        shader->setBool("material.hasNormalTexture", true);
-        for(const auto& texture : materialTextures.at(Normal))
-        {
-            unsigned int count = 1;
-            glActiveTexture(GL_TEXTURE0 + texturesCount); // active proper texture unit before binding
-            shader->setInt("material.mapNormal_" + std::to_string(count++), (int) texturesCount++);
-            glBindTexture(GL_TEXTURE_2D, texture->GetId());
-        }
+        data.specular = 0.0f;
     }
 
-    if (materialTextures.at(Specular).empty())
-    {
-        shader->setBool("material.hasSpecularTexture", false);
-        glActiveTexture(GL_TEXTURE0 + texturesCount); // active proper texture unit before binding
-        shader->setInt("material.mapSpecular_1", (int) texturesCount++);
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
-    else
-    {
-        shader->setBool("material.hasSpecularTexture", true);
-        for(const auto& texture : materialTextures.at(Specular))
-        {
-            unsigned int count = 1;
-            glActiveTexture(GL_TEXTURE0 + texturesCount); // active proper texture unit before binding
-            shader->setInt("material.mapSpecular_" + std::to_string(count++), (int) texturesCount++);
-            glBindTexture(GL_TEXTURE_2D, texture->GetId());
-        }
-    }
-    if (materialTextures.at(Roughness).empty())
-    {
-        shader->setBool("material.hasRoughnessTexture", false);
-        glActiveTexture(GL_TEXTURE0 + texturesCount); // active proper texture unit before binding
-        shader->setInt("material.mapRoughness_1", (int) texturesCount++);
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
-    else
-    {
-        shader->setBool("material.hasRoughnessTexture", true);
-        for(const auto& texture : materialTextures.at(Roughness))
-        {
-            unsigned int count = 1;
-            glActiveTexture(GL_TEXTURE0 + texturesCount); // active proper texture unit before binding
-            shader->setInt("material.mapRoughness_" + std::to_string(count++), (int) texturesCount++);
-            glBindTexture(GL_TEXTURE_2D, texture->GetId());
-        }
-    }
+    ReadTextures(data, material, directory, aiTextureType_NORMALS, Normal);
+    ReadTextures(data, material, directory, aiTextureType_DIFFUSE, Diffuse);
+    ReadTextures(data, material, directory, aiTextureType_SPECULAR, Specular);
+    ReadTextures(data, material, directory, aiTextureType_METALNESS, Metallic);
+    ReadTextures(data, material, directory, aiTextureType_DIFFUSE_ROUGHNESS, Roughness);
 
-    if (materialTextures.at(Metallic).empty())
-    {
-        shader->setBool("material.hasMetallicTexture", false);
-        glActiveTexture(GL_TEXTURE0 + texturesCount); // active proper texture unit before binding
-        shader->setInt("material.mapMetallic_1", (int) texturesCount++);
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
-    else
-    {
-        shader->setBool("material.hasMetallicTexture", true);
-        for(const auto& texture : materialTextures.at(Metallic))
-        {
-            unsigned int count = 1;
-            glActiveTexture(GL_TEXTURE0 + texturesCount); // active proper texture unit before binding
-            shader->setInt("material.mapMetallic_" + std::to_string(count++), (int) texturesCount++);
-            glBindTexture(GL_TEXTURE_2D, texture->GetId());
-        }
-    }
+    return data;
 }
 
-std::shared_ptr<Texture> Material::LoadTexture(const std::string &path)
+uint32_t Material::GetId() const
 {
-    // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-    for(auto & j : Texture::texturesLoaded)
-    {
-        if(* j == path)
-        {
-            return j;
-        }
-    }
-    std::shared_ptr<Texture> texture = std::make_shared<Texture>(path);
-    Texture::texturesLoaded.push_back(texture);
-    return texture;
+    id = MaterialTable::Intern(* this, id);
+    return id;
 }
 
-void Material::LoadTextures(const aiMaterial *material, const std::string &directory, aiTextureType aiType, TextureType texType)
+std::shared_ptr<Texture> Material::LoadTexture(const std::string &path, TextureType usage, const std::shared_ptr<TextureData>& data)
 {
-    std::vector<Texture> textures_loaded;
-
-    materialTextures[texType];
+    return TextureRegistry::Load(path, usage, data);
+}
 
+void Material::ReadTextures(MaterialData& data, const aiMaterial *material, const std::string &directory, aiTextureType aiType, TextureType texType)
+{
     for(unsigned int i = 0; i < material->GetTextureCount(aiType); i++)
     {
         aiString path;
@@ -288,7 +418,7 @@ void Material::LoadTextures(const aiMaterial *material, const std::string &direc
             filename = directory + path.C_Str();
         }
 
-        materialTextures[texType].push_back(LoadTexture(filename));
+        data.textures.emplace_back(texType, filename);
     }
 }
 
@@ -299,55 +429,53 @@ CubeMap::CubeMap(const std::array<std::string, 6>& faces) : id(0)
 
     if(!faces.empty())
     {
-        int width, height, nrComponents;
+        // all faces are decoded and their mip chains are generated in parallel, only the upload is left for the main thread
+        std::array<std::future<std::shared_ptr<TextureData>>, 6> decoded;
         for (unsigned int i = 0; i < faces.size(); i++)
         {
-            unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrComponents, 0);
-
-            GLenum format = 0;
-            GLenum internalFormat = 0;
-            if (nrComponents == 1)
-            {
-                format = GL_RED;
-                internalFormat = GL_R8;
-            }
-            else if (nrComponents == 3)
-            {
-                format = GL_RGB;
-                internalFormat = GL_RGB8;
-            }
-            else if (nrComponents == 4)
+            decoded[i] = ThreadPool::Submit([&path = faces[i]]() -> std::shared_ptr<TextureData>
             {
-                format = GL_RGBA;
-                internalFormat = GL_RGBA8;
-            }
+                try
+                {
+                    return MipGenerator::Generate(* Texture::Decode(path), MipFilter::Srgb);
+                }
+                catch (const std::exception&)
+                {
+                    return nullptr;
+                }
+            });
+        }
 
-            if (data)
+        for (unsigned int i = 0; i < faces.size(); i++)
+        {
+            const auto data = decoded[i].get();
+            if (!data)
             {
-                LOG(INFO) << "Texture " << faces[i] << " loaded, taking " << nrComponents * width * height << " bytes of memory, number of components: " << nrComponents;
-
-                auto textureType = GL_TEXTURE_CUBE_MAP_POSITIVE_X + i;
+                LOG(WARNING) << "CubeMap texture failed to load at path: " << faces[i];
+                continue;
+            }
 
-                glTexImage2D(textureType, 0, static_cast<int>(internalFormat), width, height, 0, format, GL_UNSIGNED_BYTE, data);
+            LOG(INFO) << "Texture " << faces[i] << " loaded, taking " << data->storage.size() << " bytes of memory, number of levels: " << data->levels.size();
 
-                glTexParameteri(textureType, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-                glTexParameteri(textureType, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            auto textureType = GL_TEXTURE_CUBE_MAP_POSITIVE_X + i;
 
-                glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_REPEAT);
-                glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            }
-            else
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            for (size_t level = 0; level < data->levels.size(); level++)
             {
-                LOG(WARNING) << "CubeMap texture failed to load at path: " << faces[i];
-                stbi_image_free(data);
+                const auto& mip = data->levels[level];
+                glTexImage2D(textureType, static_cast<GLint>(level), static_cast<int>(data->internalFormat), mip.width, mip.height, 0, data->pixelFormat, GL_UNSIGNED_BYTE, data->pixels + mip.offset);
             }
+
+            glTexParameteri(textureType, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(textureType, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+            glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_REPEAT);
         }
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
     }
 }
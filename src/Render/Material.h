@@ -15,11 +15,18 @@
 #include <iostream>
 #include <vector>
 #include <array>
+#include <memory>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+class MappedFile;
 
 using TextureType = enum TextureType
 {
@@ -31,6 +38,55 @@ using TextureType = enum TextureType
     Translucency
 };
 
+/**
+ * Decoded image pixels, as stored in the image file. Can be produced on any thread
+ */
+struct ImageData
+{
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    std::unique_ptr<unsigned char, void(*)(void *)> pixels { nullptr, free };
+};
+
+/**
+ * Single mip level of the texture data
+ */
+struct TextureLevel
+{
+    int width = 0;
+    int height = 0;
+
+    /* Offset from the beginning of the texture pixels and size, both in bytes */
+    size_t offset = 0;
+    size_t size = 0;
+};
+
+/**
+ * Texture pixels with the whole mip chain, either block compressed or not, ready to be uploaded to the GPU. Can be
+ * produced on any thread
+ */
+struct TextureData
+{
+    /* OpenGL sized internal format */
+    unsigned int internalFormat = 0;
+
+    /* OpenGL pixel format of the uncompressed data, 0 if data is compressed */
+    unsigned int pixelFormat = 0;
+
+    std::vector<TextureLevel> levels;
+    const uint8_t * pixels = nullptr;
+
+    /* Owners of the pixels: own storage, decoded image or the mapped cache file */
+    std::vector<uint8_t> storage;
+    std::shared_ptr<ImageData> image;
+    std::shared_ptr<MappedFile> cacheFile;
+
+    [[nodiscard]] inline bool IsCompressed() const { return pixelFormat == 0; }
+};
+
+using ImageMap = std::unordered_map<std::string, std::shared_ptr<TextureData>>;
+
 struct Texture
 {
 public:
@@ -38,11 +94,29 @@ public:
     Texture(const Texture& ) = default;
 
     /**
-     * Loads texture and creates all OpenGL needed data
+     * Creates texture, which pixels are streamed in later by the TextureStreamer. Placeholder is bound instead of it
+     * until the upload is finished
      * @param path texture path
-     * @param gamma gamma correction (not implemented)
+     * @param usage how texture is sampled by the shaders, defines the compression format
+     */
+    explicit Texture(const std::string& path, TextureType usage = Diffuse);
+
+    /**
+     * Decodes image file, does not touch OpenGL, so it is safe to call from the worker threads
+     * @param path image path
+     * @return decoded image
+     */
+    static std::shared_ptr<ImageData> Decode(const std::string& path);
+
+    /**
+     * Loads texture data from the texture cache. On a cache miss image is decoded, its mip chain is generated and, if
+     * compression is enabled, compressed, then the result is written to the cache. Does not touch OpenGL, so it is safe to call from
+     * the worker threads
+     * @param path image path
+     * @param usage how texture is sampled by the shaders
+     * @return texture data, ready to be uploaded
      */
-    explicit Texture(const std::string& path, bool gamma = false);
+    static std::shared_ptr<TextureData> LoadData(const std::string& path, TextureType usage);
 
     /**
      * Creates an empty texture
@@ -74,9 +148,102 @@ public:
     static std::shared_ptr<Texture> CreateTextureArray(GLsizei width, GLsizei height, unsigned int textureArraySize = 0, unsigned int format = GL_RGBA, unsigned int internalFormat = GL_RGBA, unsigned int pixelType = GL_UNSIGNED_BYTE, bool repeat = true);
 
     /**
+     * Marks texture as used during the current frame, so it is kept resident
      * @return texture id
      */
-    [[nodiscard]] inline unsigned int GetId() const { return id; }
+    [[nodiscard]] unsigned int GetId() const;
+
+    /**
+     * Marks texture as used during the current frame, so it is kept resident. Handle stays valid until the next
+     * change of the uploaded levels, so it has to be queried every frame
+     * @return resident bindless handle of the uploaded levels, or of the placeholder, if there are none
+     */
+    [[nodiscard]] uint64_t GetHandle() const;
+
+    /**
+     * @return false while texture pixels are still being streamed in
+     */
+    [[nodiscard]] inline bool IsResident() const { return isResident; }
+
+    /**
+     * @return how texture is sampled by the shaders
+     */
+    [[nodiscard]] inline TextureType GetUsage() const { return usage; }
+
+    /**
+     * @return size of the allocated mip levels, in bytes, 0 until the storage is created or once texture is evicted
+     */
+    [[nodiscard]] inline size_t GetMemoryUsage() const { return memoryUsage; }
+
+    /**
+     * @return index of the largest uploaded mip level, sampling is clamped to it, 0 if texture is resident in the full
+     * resolution
+     */
+    [[nodiscard]] inline size_t GetResidentLevel() const { return residentLevel; }
+
+    /**
+     * @return index of the level, which matches the screen space texel density of the meshes using the texture best
+     */
+    [[nodiscard]] inline size_t GetDesiredLevel() const { return desiredLevel; }
+
+    /**
+     * Requests texture resolution, at which a texel of the base level covers a single pixel on the screen. The largest
+     * request of the frame defines the level texture is streamed to
+     * @param resolution requested resolution, in pixels
+     */
+    inline void RequestResolution(float resolution) const { requestedResolution = std::max(requestedResolution, resolution); }
+
+    /**
+     * @return number of the mip levels of the texture data, 0 until it is loaded for the first time
+     */
+    [[nodiscard]] inline size_t GetLevelsCount() const { return levelSizes.size(); }
+
+    /**
+     * @return full resolution width, 0 until the storage is created
+     */
+    [[nodiscard]] inline int GetWidth() const { return width; }
+
+    /**
+     * @return full resolution height, 0 until the storage is created
+     */
+    [[nodiscard]] inline int GetHeight() const { return height; }
+
+    /**
+     * @return frame, during which texture was used last time
+     */
+    [[nodiscard]] inline uint64_t GetLastUsedFrame() const { return lastUsedFrame; }
+
+    /**
+     * @return true while texture levels are being loaded or uploaded
+     */
+    [[nodiscard]] inline bool IsStreaming() const { return isStreaming; }
+
+    /**
+     * @return 1x1 white texture, bound in place of the textures which are not resident yet
+     */
+    static unsigned int GetPlaceholderId();
+
+    /**
+     * @return resident bindless handle of the placeholder texture
+     */
+    static uint64_t GetPlaceholderHandle();
+
+    /**
+     * Deletes placeholder texture, must be called before the OpenGL context is destroyed
+     */
+    static void DeletePlaceholder();
+
+    /**
+     * Enables sampling material textures through the bindless handles, if ARB_bindless_texture is supported. Must be
+     * called before the shaders are compiled
+     * @param enabled whether bindless textures should be used
+     */
+    static void SetBindlessEnabled(bool enabled);
+
+    /**
+     * @return true if material textures are sampled through the bindless handles instead of the texture units
+     */
+    static bool IsBindlessEnabled() { return isBindlessEnabled; }
 
     void Bind() const { glBindTexture(textureType, id); }
 
@@ -111,8 +278,50 @@ public:
     ~Texture();
 private:
     Texture() = default;
-public:
-    inline static std::vector<std::shared_ptr<Texture>> texturesLoaded;
+
+    /**
+     * Remembers size, format and levels of the texture data, once it is loaded for the first time
+     * @param data texture data
+     */
+    void Initialize(const TextureData& data);
+
+    /**
+     * Creates storage for the mip chain starting from the given level. Levels, already uploaded to the current
+     * storage, are copied on the GPU, so texture stays resident and only the missing levels have to be uploaded
+     * @param firstLevel largest level to allocate
+     */
+    void Reallocate(size_t firstLevel);
+
+    /**
+     * Marks level as uploaded and clamps sampling to it
+     * @param level largest uploaded level
+     */
+    void SetResidentLevel(size_t level);
+
+    /**
+     * Ends streaming, once all requested levels are uploaded or loading of the texture data failed
+     */
+    void FinishStreaming();
+
+    /**
+     * Deletes texture storage, so it takes no video memory. Placeholder is bound instead of it until it is reloaded
+     */
+    void Evict();
+
+    /**
+     * @param firstLevel largest level
+     * @return size of the mip chain, starting from the given level, in bytes
+     */
+    [[nodiscard]] size_t GetMemoryUsage(size_t firstLevel) const;
+
+    /**
+     * Makes the bindless handle non resident and deletes the view it was created for, must be called before the
+     * storage or the uploaded levels change
+     */
+    void ReleaseHandle() const;
+
+    friend class TextureStreamer;
+    friend class TextureRegistry;
 
 private:
     int width = 0;
@@ -121,7 +330,25 @@ private:
     float blend = 1.0f;
     unsigned int id = 0;
     unsigned int textureType = 0;
+    unsigned int internalFormat = 0;
+    size_t memoryUsage = 0;
+    size_t allocatedLevel = 0;
+    size_t residentLevel = 0;
+    size_t desiredLevel = 0;
+    std::vector<size_t> levelSizes;
+    mutable float requestedResolution = 0.0f;
+    mutable uint64_t lastUsedFrame = 0;
+    /* Bindless handle and the view of the uploaded levels it is created for, 0 until the handle is requested */
+    mutable uint64_t handle = 0;
+    mutable unsigned int handleView = 0;
+    TextureType usage = Diffuse;
+    bool isResident = true;
+    bool isStreaming = false;
     std::string path;
+
+    inline static unsigned int placeholderId = 0;
+    inline static uint64_t placeholderHandle = 0;
+    inline static bool isBindlessEnabled = false;
 };
 
 struct CubeMap
@@ -150,30 +377,39 @@ private:
 
 using TextureStack = std::vector<std::shared_ptr<Texture>>;
 
+/**
+ * CPU side material description, produced either by the importer or by the mesh cache
+ */
+struct MaterialData
+{
+    float specular = 0.0f;
+    glm::vec4 defaultColor = glm::vec4(1.0f);
+    std::vector<std::pair<TextureType, std::string>> textures;
+};
+
 class Material
 {
 public:
     /**
     * Loads texture at given path or returns an already loaded one if paths are the same
     * @param path texture path
+    * @param usage how texture is sampled by the shaders
+    * @param data already loaded texture data, loaded on the thread pool if nullptr
     * @return pointer to the texture
     */
-    static std::shared_ptr<Texture> LoadTexture(const std::string& path);
+    static std::shared_ptr<Texture> LoadTexture(const std::string& path, TextureType usage = Diffuse, const std::shared_ptr<TextureData>& data = nullptr);
 
     /**
-     * Deletes all textures, unused by materials
+     * Requests resolution of all material textures
+     * @param resolution resolution, at which a texel of the base level covers a single pixel on the screen
      */
-    static void UnloadUnusedTextures()
+    void RequestTextureResolution(float resolution) const
     {
-        for (auto it = Texture::texturesLoaded.begin(); it != Texture::texturesLoaded.end();)
+        for (const auto& [type, stack] : materialTextures)
         {
-            if ((* it).use_count() == 1)
+            for (const auto& texture : stack)
             {
-                it = Texture::texturesLoaded.erase(it);
-            }
-            else
-            {
-                ++it;
+                texture->RequestResolution(resolution);
             }
         }
     }
@@ -188,18 +424,26 @@ public:
     Material(const std::string& path);
 
     /**
-     * Creates new material
+     * Creates new material and loads all of its textures
+     * @param data material description
+     * @param images already loaded textures data, optional
+     */
+    explicit Material(const MaterialData& data, const ImageMap * images = nullptr);
+
+    /**
+     * Reads material description from the assimp material
      * @param material assimp loaded material
      * @param directory material directory
+     * @return material description
      */
-    Material(const aiMaterial * material, const std::string& directory);
+    static MaterialData ReadMaterialData(const aiMaterial * material, const std::string& directory);
 
     /**
-     * Binds all material textures to shader
-     * @param shader draw shader
-     * @param shadowTexture shadow texture, rendered by ShadowHandler
+     * Interns the material, materials with the same parameters and textures share the same ID. Parameters can be
+     * changed at any time, material is interned again once they differ from the interned ones
+     * @return ID of the material record, read by the shaders
      */
-    void Bind(const std::shared_ptr<Shader>& shader) const;
+    [[nodiscard]] uint32_t GetId() const;
 
     void AttachTexture(const std::shared_ptr<Texture>& texture, TextureType type)
     {
@@ -215,13 +459,17 @@ public:
 
 private:
     /**
-     * Loads all material textures
+     * Collects paths of all material textures of the given type
+     * @param data material description to fill
      * @param material assimp material
      * @param directory material texture directory
      * @param aiType texture type
      * @param texType engine texture type
      */
-    void LoadTextures(const aiMaterial * material, const std::string& directory, aiTextureType aiType, TextureType texType);
+    static void ReadTextures(MaterialData& data, const aiMaterial * material, const std::string& directory, aiTextureType aiType, TextureType texType);
     bool isTwoSided = false;
+
+    /* ID, material was interned with last time */
+    mutable uint32_t id = UINT32_MAX;
 };
 #endif //GRAPHICS_MATERIAL_H
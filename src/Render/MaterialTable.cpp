@@ -0,0 +1,227 @@
+#include "MaterialTable.h"
+#include "TextureRegistry.h"
+#include "SSBO.hpp"
+#include "../Core/Hash.hpp"
+#include "../Core/Profiler.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+bool MaterialTable::Key::operator ==(const Key& other) const
+{
+    return colorDiffuse == other.colorDiffuse && specular == other.specular && metallic == other.metallic &&
+           roughness == other.roughness && std::equal(std::begin(textures), std::end(textures), std::begin(other.textures));
+}
+
+size_t MaterialTable::KeyHash::operator()(const Key& key) const
+{
+    // hashed field by field, so the padding never affects the result
+    uint64_t hash = Hash::Fnv1a(&key.colorDiffuse, sizeof(key.colorDiffuse));
+    hash = Hash::Fnv1a(&key.specular, sizeof(key.specular), hash);
+    hash = Hash::Fnv1a(&key.metallic, sizeof(key.metallic), hash);
+    hash = Hash::Fnv1a(&key.roughness, sizeof(key.roughness), hash);
+    hash = Hash::Fnv1a(key.textures, sizeof(key.textures), hash);
+    return static_cast<size_t>(hash);
+}
+
+MaterialTable::Key MaterialTable::MakeKey(const Material& material)
+{
+    Key key {};
+    key.colorDiffuse = material.defaultColor;
+    key.specular = material.specular;
+    key.metallic = material.metallic;
+    key.roughness = material.roughness;
+
+    // only the first texture of each type is sampled
+    for (const auto& [type, stack] : material.materialTextures)
+    {
+        if (static_cast<size_t>(type) < MATERIAL_TEXTURES_COUNT && !stack.empty())
+        {
+            key.textures[type] = stack.front().get();
+        }
+    }
+    return key;
+}
+
+bool MaterialTable::IsExpired(const Entry& entry)
+{
+    for (size_t i = 0; i < MATERIAL_TEXTURES_COUNT; i++)
+    {
+        if (entry.key.textures[i] != nullptr && entry.textures[i].expired())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t MaterialTable::Intern(const Material& material, uint32_t hint)
+{
+    const Key key = MakeKey(material);
+    const uint64_t frame = TextureRegistry::GetFrame();
+
+    // material is unchanged since the last frame, no lookup needed
+    if (hint < materials.size() && materials[hint].lastUsedFrame != 0 && materials[hint].key == key && !IsExpired(materials[hint]))
+    {
+        materials[hint].lastUsedFrame = frame;
+        return hint;
+    }
+
+    if (auto it = ids.find(key); it != ids.end())
+    {
+        // texture at the same address is a different one, if the entry has expired
+        if (!IsExpired(materials[it->second]))
+        {
+            materials[it->second].lastUsedFrame = frame;
+            return it->second;
+        }
+        Release(it->second);
+    }
+
+    uint32_t id;
+    if (!freeIds.empty())
+    {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    else
+    {
+        id = static_cast<uint32_t>(materials.size());
+        materials.emplace_back();
+        records.emplace_back();
+    }
+
+    auto& entry = materials[id];
+    entry.key = key;
+    entry.lastUsedFrame = frame;
+    for (const auto& [type, stack] : material.materialTextures)
+    {
+        if (static_cast<size_t>(type) < MATERIAL_TEXTURES_COUNT && !stack.empty())
+        {
+            entry.textures[type] = stack.front();
+        }
+    }
+
+    // record is filled on the next update, forcing it to differ from the current one
+    records[id] = MaterialRecord {};
+    records[id].textureMask = UINT32_MAX;
+
+    ids.emplace(key, id);
+    return id;
+}
+
+void MaterialTable::Release(uint32_t id)
+{
+    ids.erase(materials[id].key);
+    materials[id] = Entry {};
+    freeIds.push_back(id);
+}
+
+MaterialRecord MaterialTable::MakeRecord(const Entry& entry)
+{
+    MaterialRecord record {};
+    record.colorDiffuse = entry.key.colorDiffuse;
+    record.specular = entry.key.specular;
+    record.metallic = entry.key.metallic;
+    record.roughness = entry.key.roughness;
+
+    for (size_t i = 0; i < MATERIAL_TEXTURES_COUNT; i++)
+    {
+        // textures still being streamed in are treated as missing ones
+        const auto texture = entry.textures[i].lock();
+        if (texture && texture->IsResident())
+        {
+            record.textureMask |= 1u << i;
+        }
+
+        // handles change with the resident levels, so they are queried every frame
+        if (Texture::IsBindlessEnabled())
+        {
+            record.handles[i] = texture ? texture->GetHandle() : Texture::GetPlaceholderHandle();
+        }
+    }
+    return record;
+}
+
+void MaterialTable::Update()
+{
+    const uint64_t frame = TextureRegistry::GetFrame();
+    for (uint32_t id = 0; id < materials.size(); id++)
+    {
+        const auto& entry = materials[id];
+        if (entry.lastUsedFrame == 0)
+        {
+            continue;
+        }
+
+        if (IsExpired(entry) || frame - entry.lastUsedFrame > coldFramesCount)
+        {
+            Release(id);
+            continue;
+        }
+
+        if (entry.lastUsedFrame != frame)
+        {
+            continue;
+        }
+
+        const MaterialRecord record = MakeRecord(entry);
+        if (std::memcmp(&record, &records[id], sizeof(MaterialRecord)) != 0)
+        {
+            records[id] = record;
+            dirtyBegin = std::min<size_t>(dirtyBegin, id);
+            dirtyEnd = std::max<size_t>(dirtyEnd, id + 1);
+        }
+    }
+
+    if (buffer == 0)
+    {
+        glGenBuffers(1, &buffer);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+
+    if (SSBO::Grow(bufferCapacity, std::max<size_t>(records.size(), 64) * sizeof(MaterialRecord), GL_DYNAMIC_DRAW))
+    {
+        dirtyBegin = 0;
+        dirtyEnd = records.size();
+    }
+
+    Profiler::materialBytesUploaded = 0;
+    if (dirtyBegin < dirtyEnd)
+    {
+        Profiler::materialBytesUploaded = (dirtyEnd - dirtyBegin) * sizeof(MaterialRecord);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, static_cast<GLintptr>(dirtyBegin * sizeof(MaterialRecord)),
+                        static_cast<GLsizeiptr>(Profiler::materialBytesUploaded), records.data() + dirtyBegin);
+        dirtyBegin = SIZE_MAX;
+        dirtyEnd = 0;
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    Profiler::materialsCount = GetMaterialsCount();
+}
+
+void MaterialTable::BindTextures(uint32_t id)
+{
+    for (size_t i = 0; i < MATERIAL_TEXTURES_COUNT; i++)
+    {
+        const auto texture = materials[id].textures[i].lock();
+        glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
+        glBindTexture(GL_TEXTURE_2D, texture ? texture->GetId() : Texture::GetPlaceholderId());
+    }
+}
+
+void MaterialTable::ShutDown()
+{
+    materials.clear();
+    records.clear();
+    freeIds.clear();
+    ids.clear();
+    dirtyBegin = SIZE_MAX;
+    dirtyEnd = 0;
+
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    bufferCapacity = 0;
+}
@@ -0,0 +1,165 @@
+#ifndef GRAPHICS_MATERIALTABLE_H
+#define GRAPHICS_MATERIALTABLE_H
+
+#define GLEW_STATIC
+#include "glew.h"
+#include "glm/glm.hpp"
+
+#include "Material.h"
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+/* Number of the texture types, sampled by the G-buffer shader: Diffuse, Normal, Specular, Metallic and Roughness */
+constexpr size_t MATERIAL_TEXTURES_COUNT = 5;
+
+/**
+ * Material parameters, as read by the shaders from materials[materialId]. Layout matches the std430 MaterialData struct
+ */
+struct MaterialRecord
+{
+    glm::vec4 colorDiffuse;
+    float specular;
+    float metallic;
+    float roughness;
+    /* Bit per texture type, set if the texture is resident */
+    uint32_t textureMask;
+    /* Bindless handles, indexed by the texture type, 0 if bindless textures are not used */
+    uint64_t handles[MATERIAL_TEXTURES_COUNT];
+    /* Pads the record to the std430 struct alignment */
+    uint64_t padding;
+};
+
+static_assert(sizeof(MaterialRecord) == 80, "MaterialRecord must match the std430 layout");
+
+/**
+ * Interned materials. Materials with the same parameters and textures share the same ID, no matter which model they
+ * were imported with, and a single record in the shader storage buffer. Records are refreshed for the materials drawn
+ * during the frame and only the changed ones are uploaded, so binding a material costs a single integer.
+ *
+ * Materials, no longer drawn, are released once they go cold, their IDs are reused
+ */
+class MaterialTable
+{
+public:
+    /* Restriction to create an instance of this class */
+    MaterialTable() = delete;
+    MaterialTable(MaterialTable&&) = delete;
+    MaterialTable(const MaterialTable&) = delete;
+
+    /**
+     * Finds ID of the material with the same parameters and textures, or creates a new one. Marks it as used during the
+     * current frame
+     * @param material material to intern
+     * @param hint ID material was interned with last time, checked first
+     * @return material ID
+     */
+    static uint32_t Intern(const Material& material, uint32_t hint);
+
+    /**
+     * Refreshes records of the materials, used during the current frame, uploads the changed ones and binds the
+     * buffer. Must be called after all the draws of the frame are recorded and before they are submitted
+     */
+    static void Update();
+
+    /**
+     * Binds textures of the material to the texture units, matching the sampler bindings of the G-buffer shader. Used
+     * only if bindless textures are not supported
+     * @param id material ID
+     */
+    static void BindTextures(uint32_t id);
+
+    /**
+     * @param id material ID, or invalidId
+     * @return bit per texture type, set if the texture is resident, as of the last update. 0 for the invalid ID
+     */
+    static uint32_t GetTextureMask(uint32_t id) { return id < records.size() ? records[id].textureMask : 0; }
+
+    /**
+     * Releases all materials and the buffer, must be called before the OpenGL context is destroyed
+     */
+    static void ShutDown();
+
+    /**
+     * @return number of the interned materials
+     */
+    static size_t GetMaterialsCount() { return materials.size() - freeIds.size(); }
+
+    /* Shader storage binding of the material records */
+    static constexpr unsigned int binding = 2;
+
+    /* ID, never returned for a material, used by the draws without one */
+    static constexpr uint32_t invalidId = UINT32_MAX;
+
+private:
+    /**
+     * Everything materials are compared by
+     */
+    struct Key
+    {
+        glm::vec4 colorDiffuse;
+        float specular;
+        float metallic;
+        float roughness;
+        const Texture * textures[MATERIAL_TEXTURES_COUNT];
+
+        bool operator ==(const Key& other) const;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        /* Textures are owned by the materials, expired ones mean entry is no longer reachable */
+        std::weak_ptr<Texture> textures[MATERIAL_TEXTURES_COUNT];
+        /* 0 if the ID is free */
+        uint64_t lastUsedFrame;
+    };
+
+    /**
+     * @param material material
+     * @return key of the material current parameters and textures
+     */
+    static Key MakeKey(const Material& material);
+
+    /**
+     * @param entry material entry
+     * @return true if any texture of the entry was released
+     */
+    static bool IsExpired(const Entry& entry);
+
+    /**
+     * Frees the material ID, so it can be reused
+     * @param id material ID
+     */
+    static void Release(uint32_t id);
+
+    /**
+     * @param entry material entry
+     * @return record with the current parameters, texture residency and handles
+     */
+    static MaterialRecord MakeRecord(const Entry& entry);
+
+    /* Frames since the last use, after which material is released */
+    static constexpr uint64_t coldFramesCount = 300;
+
+    inline static std::vector<Entry> materials;
+    inline static std::vector<MaterialRecord> records;
+    inline static std::vector<uint32_t> freeIds;
+    inline static std::unordered_map<Key, uint32_t, KeyHash> ids;
+
+    /* Range of the records changed since the last upload */
+    inline static size_t dirtyBegin = SIZE_MAX, dirtyEnd = 0;
+
+    inline static unsigned int buffer = 0;
+    /* Storage size of the buffer, in bytes */
+    inline static size_t bufferCapacity = 0;
+};
+
+#endif //GRAPHICS_MATERIALTABLE_H
@@ -6,79 +6,81 @@
 
 #include <utility>
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, const Material& material, std::string name) : vertices(std::move(vertices)), indices(std::move(indices)), material(material), name(std::move(name))
+Mesh::Mesh(const MeshData& data, const Material& material) : name(data.name), material(material), vertexFormat(data.vertexFormat), indexFormat(data.indexFormat), bounds(data.bounds), sphere(data.sphere), uvDensity(data.uvDensity)
 {
-    SetUpMesh();
+    SetUpMesh(data);
+
+    verticesCount = data.verticesCount;
+    indicesCount = data.indicesCount;
+
+    lods = data.lods;
+    clusters = data.clusters;
+    if (lods.empty())
+    {
+        lods.push_back({ 0, static_cast<uint32_t>(indicesCount), 0.0f });
+    }
 
     Profiler::totalMeshes++;
-    Profiler::totalVertices += this->indices.size();
+    Profiler::totalVertices += verticesCount;
+    Profiler::meshGpuMemory += GetMemoryUsage();
 }
 
-void Mesh::Draw(const std::shared_ptr<Shader> &shader) const
+void Mesh::SetUpMesh(const MeshData& data)
 {
-    material.Bind(shader);
-
-    // draw mesh
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<int>(indices.size()), GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
-
-    // always good practice to set everything back to defaults once configured.
-    glActiveTexture(GL_TEXTURE0);
+    // position only stream for the shadow pass: 12 bytes per vertex, normal attribute stays disabled and reads as zero
+    const auto positions = VertexLayout::ExtractDepthPositions(data.vertexData, data.verticesCount, data.vertexFormat);
+    geometry = GeometryArena::Allocate(data, positions);
 }
 
-void Mesh::SetUpMesh()
+size_t Mesh::CollectDrawCommands(std::vector<DrawElementsIndirectCommand>& commands, uint32_t instance, int lod, const ClusterCullingData * culling, bool usePositionStream) const
 {
-    // create buffers/arrays
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    const GeometryAllocation& allocation = GeometryArena::Get(geometry);
+    const auto baseVertex = static_cast<int32_t>(usePositionStream ? allocation.depthBaseVertex : allocation.baseVertex);
+    const MeshLod& level = GetLod(lod);
 
-    glBindVertexArray(VAO);
-    // load data into vertex buffers
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    if (culling == nullptr || &level != &lods.front() || clusters.size() < 2)
+    {
+        if (level.indicesCount > 0)
+        {
+            commands.push_back({ level.indicesCount, 1, allocation.firstIndex + level.indexOffset, baseVertex, instance });
+        }
+        return level.indicesCount;
+    }
 
-    // A great thing about structs is that their memory layout is sequential for all its items.
-    // The effect is that we can simply pass a pointer to the struct, and it translates perfectly to a glm::vec3/2 array which
-    // again translates to 3/2 floats which translates to a byte array.
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    size_t visibleIndices = 0;
+    uint32_t rangeEnd = ~0u;
+    for (const auto& cluster : clusters)
+    {
+        if (!culling->frustum.Intersects(cluster.center, cluster.radius))
+        {
+            continue;
+        }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        // backfacing cluster: camera is inside of the normal cone, behind all triangles
+        if (culling->isConeCullingEnabled && cluster.coneCutoff < 1.0f)
+        {
+            const glm::vec3 direction = cluster.center - culling->cameraPosition;
+            const float distance = glm::length(direction);
+            if (distance > cluster.radius && glm::dot(direction, cluster.coneAxis) >= cluster.coneCutoff * distance + cluster.radius)
+            {
+                continue;
+            }
+        }
 
-    // set the vertex attribute pointers
-    // vertex Positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
-    // vertex normals
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-    // vertex texture coords
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-    // vertex tangent
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-    // vertex bitangent
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-    // ids
-    glEnableVertexAttribArray(5);
-    glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-
-    // weights
-    glEnableVertexAttribArray(6);
-    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
-    glBindVertexArray(0);
-}
-
-void Mesh::DrawIntoDepth() const
-{
-    // draw mesh
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<int>(indices.size()), GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
+        // neighbouring visible clusters are merged into a single command
+        if (cluster.indexOffset == rangeEnd)
+        {
+            commands.back().count += cluster.indicesCount;
+        }
+        else
+        {
+            commands.push_back({ cluster.indicesCount, 1, allocation.firstIndex + cluster.indexOffset, baseVertex, instance });
+        }
+        rangeEnd = cluster.indexOffset + cluster.indicesCount;
+        visibleIndices += cluster.indicesCount;
+        Profiler::visibleClusters++;
+    }
+    Profiler::totalClusters += clusters.size();
 
-    // always good practice to set everything back to defaults once configured.
-    glActiveTexture(GL_TEXTURE0);
+    return visibleIndices;
 }
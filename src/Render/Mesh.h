@@ -6,26 +6,73 @@
 #include "glew.h"
 #include "glm/glm.hpp"
 
+#include "Bounds.hpp"
+#include "VertexLayout.h"
+#include "MeshOptimizer.h"
+#include "GeometryArena.h"
+#include "DrawCommandBuffer.h"
 #include "Shader.h"
 #include "Material.h"
 #include "../Core/Profiler.hpp"
 
 #include <string>
 #include <vector>
+#include <algorithm>
 
-constexpr int MAX_BONE_INFLUENCE = 4;
-
-struct Vertex
+/**
+ * CPU side mesh data, produced either by the importer or by the mesh cache
+ */
+struct MeshData
 {
-    glm::vec3 Position;
-    glm::vec3 Normal;
-    glm::vec2 TexCoords;
+    std::string name;
+    unsigned int materialIndex = 0;
+    BoundingBox bounds;
+    BoundingSphere sphere;
+
+    /* Texture coordinates units per model space unit, defines the resolution textures are streamed to */
+    float uvDensity = 0.0f;
+
+    /* Layout of the vertex and index data */
+    VertexFormat vertexFormat = VertexFormat::Static;
+    IndexFormat indexFormat = IndexFormat::UInt32;
+
+    /* Storage, filled by the importer. Stays empty if the data lives in a mapped mesh cache file */
+    std::vector<uint8_t> vertices;
+    std::vector<uint8_t> indices;
+
+    /* Views over the packed vertex and index data, point either to the vectors above or into the mapped cache file */
+    const uint8_t * vertexData = nullptr;
+    const uint8_t * indexData = nullptr;
+    size_t verticesCount = 0;
+    size_t indicesCount = 0;
 
-    glm::vec3 Tangent;
-    glm::vec3 Bitangent;
+    /* Levels of detail, ranges of the index data. Whole index data is a single level if empty */
+    std::vector<MeshLod> lods;
+
+    /* Clusters of the full detail level, ranges of the index data */
+    std::vector<MeshCluster> clusters;
+
+    /**
+     * Points the views to the owned vertices and indices
+     */
+    void UseOwnedStorage()
+    {
+        vertexData = vertices.data();
+        indexData = indices.data();
+        verticesCount = vertices.size() / VertexLayout::GetSize(vertexFormat);
+        indicesCount = indices.size() / VertexLayout::GetIndexSize(indexFormat);
+    }
+};
 
-    int m_BoneIDs[MAX_BONE_INFLUENCE];
-    float m_Weights[MAX_BONE_INFLUENCE];
+/**
+ * Camera, transformed into the model space of the mesh being drawn, to cull its clusters
+ */
+struct ClusterCullingData
+{
+    Frustum frustum;
+    glm::vec3 cameraPosition { 0.0f };
+    /* Normal cones stay valid only under rotations and uniform scales */
+    bool isConeCullingEnabled = true;
 };
 
 class Mesh
@@ -36,47 +83,107 @@ public:
     Mesh(const Mesh& other) = delete;
 
     /***
-     * Mesh constructor, creates new instance of the mesh
-     * @param vertices vector of mesh vertices
-     * @param indices  vector of mesh indices
-     * @param textures vector of mesh textures
+     * Mesh constructor, creates new instance of the mesh and uploads its data into the geometry arena straight from the
+     * data views (e.g. mapped mesh cache pages). Only compact data (bounds, levels of detail and clusters) is kept on the CPU side
+     * @param data mesh vertices, indices and bounds
+     * @param material mesh material
      */
-    Mesh(std::vector<Vertex>  vertices, std::vector<unsigned int>  indices, const Material& material, std::string name = "No name");
+    Mesh(const MeshData& data, const Material& material);
 
-    /* Cleaning OpenGL stuff */
+    /* Releasing the geometry arena allocation */
     ~Mesh()
     {
         Profiler::totalMeshes--;
-        Profiler::totalVertices -= vertices.size();
+        Profiler::totalVertices -= verticesCount;
+        Profiler::meshGpuMemory -= GetMemoryUsage();
 
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
-        glDeleteVertexArrays(1, &VAO);
+        GeometryArena::Free(geometry);
     }
-    /***
-     * Draws mesh instance
-     * @param shader shader to be applied to the instance when drawing
+
+    /**
+     * Appends indirect draw commands of the mesh, referencing its place in the geometry arena
+     * @param commands commands to append to
+     * @param instance index of the mesh draw instance, passed as the base instance
+     * @param lod level of detail to draw, clamped to the last available one
+     * @param culling if not null and the full detail level is drawn, only the visible clusters are appended
+     * @param usePositionStream if true, commands address the position only stream instead of the full vertices
+     * @return number of indices in the appended commands
+     */
+    size_t CollectDrawCommands(std::vector<DrawElementsIndirectCommand>& commands, uint32_t instance, int lod, const ClusterCullingData * culling, bool usePositionStream) const;
+
+    /**
+     * @return mesh levels of detail, the first one is the full detail mesh
+     */
+    [[nodiscard]] inline const std::vector<MeshLod>& GetLods() const { return lods; }
+
+    /**
+     * @param lod level of detail
+     * @return level of detail, clamped to the last available one
+     */
+    [[nodiscard]] inline const MeshLod& GetLod(int lod) const { return lods.at(std::clamp(lod, 0, static_cast<int>(lods.size()) - 1)); }
+
+    /**
+     * @param lod level of detail
+     * @return triangles count of the level, clamped to the last available one
+     */
+    [[nodiscard]] inline size_t GetTrianglesCount(int lod = 0) const { return GetLod(lod).indicesCount / 3; }
+
+    /**
+     * @return clusters of the full detail level
+     */
+    [[nodiscard]] inline const std::vector<MeshCluster>& GetClusters() const { return clusters; }
+
+    /**
+     * @return mesh bounding box, in model space
+     */
+    [[nodiscard]] inline const BoundingBox& GetBounds() const { return bounds; }
+
+    /**
+     * @return mesh bounding sphere, in model space
+     */
+    [[nodiscard]] inline const BoundingSphere& GetBoundingSphere() const { return sphere; }
+
+    /**
+     * @return texture coordinates units per model space unit
+     */
+    [[nodiscard]] inline float GetUvDensity() const { return uvDensity; }
+
+    /**
+     * @return size of the mesh vertex and index buffers, in bytes
+     */
+    [[nodiscard]] inline size_t GetMemoryUsage() const { return verticesCount * (VertexLayout::GetSize(vertexFormat) + sizeof(glm::vec3)) + indicesCount * VertexLayout::GetIndexSize(indexFormat); }
+
+    /**
+     * @return layout of the mesh vertices
      */
-    void Draw(const std::shared_ptr<Shader> &shader) const;
+    [[nodiscard]] inline VertexFormat GetVertexFormat() const { return vertexFormat; }
 
     /**
-     * Draws mesh, without applying any textures, useful for depth buffer draw
+     * @return layout of the mesh indices
      */
-    void DrawIntoDepth() const;
+    [[nodiscard]] inline IndexFormat GetIndexFormat() const { return indexFormat; }
 public:
     std::string name;
     Material material;
     bool overrideDefaultMaterial = true;
 
 private:
-    unsigned int VBO{}, EBO{};
-    unsigned int VAO{};
-    std::vector<Vertex>       vertices;
-    std::vector<unsigned int> indices;
+    /* Vertices, indices and position only stream, suballocated from the shared buffers */
+    GeometryHandle geometry = invalidGeometry;
+    size_t verticesCount = 0;
+    size_t indicesCount = 0;
+    VertexFormat vertexFormat = VertexFormat::Static;
+    IndexFormat indexFormat = IndexFormat::UInt32;
+    BoundingBox bounds;
+    BoundingSphere sphere;
+    float uvDensity = 0.0f;
+    std::vector<MeshLod> lods;
+    std::vector<MeshCluster> clusters;
 
     /***
-     * Initializes buffers and textures for OpenGL
+     * Uploads vertices, indices and position only stream into the geometry arena
+     * @param data data to upload
      */
-    void SetUpMesh();
+    void SetUpMesh(const MeshData& data);
 };
 #endif
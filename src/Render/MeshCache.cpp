@@ -0,0 +1,398 @@
+#include "MeshCache.h"
+#include "Model.h"
+#include "../Core/Hash.hpp"
+#include "../Core/CacheFile.h"
+#include "../Core/MappedFile.h"
+#include "../Logging/easylogging++.h"
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+namespace
+{
+    constexpr char cacheMagic[4] = { 'O', 'G', 'M', 'C' };
+
+    struct MeshCacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+
+        uint64_t sourceSize;
+        int64_t  sourceTime;
+        uint64_t sourceHash;
+
+        uint32_t meshesCount;
+        uint32_t materialsCount;
+        uint32_t texturesCount;
+        uint32_t padding;
+
+        uint64_t meshesOffset;
+        uint64_t materialsOffset;
+        uint64_t texturesOffset;
+        uint64_t stringsOffset;
+        uint64_t stringsSize;
+
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    struct MeshCacheLod
+    {
+        uint32_t indexOffset;
+        uint32_t indicesCount;
+        float error;
+    };
+
+    struct MeshCacheCluster
+    {
+        uint32_t indexOffset;
+        uint32_t indicesCount;
+        float center[3];
+        float radius;
+        float coneAxis[3];
+        float coneCutoff;
+    };
+
+    struct MeshCacheMesh
+    {
+        uint64_t verticesOffset;
+        uint64_t indicesOffset;
+        uint64_t clustersOffset;
+        uint32_t verticesCount;
+        uint32_t indicesCount;
+        uint32_t clustersCount;
+
+        uint32_t materialIndex;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t vertexFormat;
+        uint32_t indexFormat;
+        uint32_t lodsCount;
+
+        float boundsMin[3];
+        float boundsMax[3];
+        float sphereCenter[3];
+        float sphereRadius;
+        float uvDensity;
+
+        MeshCacheLod lods[MAX_MESH_LODS];
+    };
+
+    struct MeshCacheMaterial
+    {
+        float defaultColor[4];
+        float specular;
+        uint32_t texturesFirst;
+        uint32_t texturesCount;
+        uint32_t padding;
+    };
+
+    struct MeshCacheTexture
+    {
+        uint32_t type;
+        uint32_t pathOffset;
+        uint32_t pathLength;
+        uint32_t padding;
+    };
+}
+
+std::string MeshCache::GetCachePath(const std::string& sourcePath)
+{
+    std::string normalized = sourcePath;
+    for (char& c : normalized)
+    {
+        if (c == '\\')
+        {
+            c = '/';
+        }
+    }
+    return (std::filesystem::path(cacheDirectory) / (Hash::ToHex(Hash::Fnv1a(normalized)) + ".mesh")).string();
+}
+
+std::unique_ptr<ModelData> MeshCache::Load(const std::string& sourcePath)
+{
+    const std::string cachePath = GetCachePath(sourcePath);
+
+    uint64_t sourceSize = 0;
+    int64_t sourceTime  = 0;
+    if (!CacheFile::GetSourceStamp(sourcePath, sourceSize, sourceTime) || !std::filesystem::exists(cachePath))
+    {
+        return nullptr;
+    }
+
+    auto file = std::make_shared<MappedFile>(cachePath);
+    if (!file->IsOpen() || file->GetSize() < sizeof(MeshCacheHeader))
+    {
+        LOG(WARNING) << "Mesh cache " << cachePath << " can not be read, ignoring it";
+        return nullptr;
+    }
+
+    const uint8_t * base = file->GetData();
+    const uint64_t fileSize = file->GetSize();
+    const auto * header = reinterpret_cast<const MeshCacheHeader *>(base);
+
+    if (std::memcmp(header->magic, cacheMagic, sizeof(cacheMagic)) != 0 || header->version != version)
+    {
+        LOG(INFO) << "Mesh cache of " << sourcePath << " has an outdated format";
+        return nullptr;
+    }
+
+    if (header->sourceSize != sourceSize || (header->sourceTime != sourceTime && header->sourceHash != Hash::HashFile(sourcePath)))
+    {
+        LOG(INFO) << "Mesh cache of " << sourcePath << " is outdated";
+        return nullptr;
+    }
+    const bool isSourceTimeOutdated = header->sourceTime != sourceTime;
+
+    if (!CacheFile::IsInRange(header->meshesOffset, uint64_t(header->meshesCount) * sizeof(MeshCacheMesh), fileSize) ||
+        !CacheFile::IsInRange(header->materialsOffset, uint64_t(header->materialsCount) * sizeof(MeshCacheMaterial), fileSize) ||
+        !CacheFile::IsInRange(header->texturesOffset, uint64_t(header->texturesCount) * sizeof(MeshCacheTexture), fileSize) ||
+        !CacheFile::IsInRange(header->stringsOffset, header->stringsSize, fileSize))
+    {
+        LOG(WARNING) << "Mesh cache " << cachePath << " is corrupted";
+        return nullptr;
+    }
+
+    const auto * meshes    = reinterpret_cast<const MeshCacheMesh *>(base + header->meshesOffset);
+    const auto * materials = reinterpret_cast<const MeshCacheMaterial *>(base + header->materialsOffset);
+    const auto * textures  = reinterpret_cast<const MeshCacheTexture *>(base + header->texturesOffset);
+    const auto * strings   = reinterpret_cast<const char *>(base + header->stringsOffset);
+
+    auto data = std::make_unique<ModelData>();
+    data->path = sourcePath;
+    data->cacheFile = file;
+    data->bounds.min = glm::vec3(header->boundsMin[0], header->boundsMin[1], header->boundsMin[2]);
+    data->bounds.max = glm::vec3(header->boundsMax[0], header->boundsMax[1], header->boundsMax[2]);
+
+    for (uint32_t i = 0; i < header->materialsCount; i++)
+    {
+        const auto& record = materials[i];
+        if (uint64_t(record.texturesFirst) + record.texturesCount > header->texturesCount)
+        {
+            LOG(WARNING) << "Mesh cache " << cachePath << " is corrupted";
+            return nullptr;
+        }
+
+        MaterialData material;
+        material.specular = record.specular;
+        material.defaultColor = glm::vec4(record.defaultColor[0], record.defaultColor[1], record.defaultColor[2], record.defaultColor[3]);
+        for (uint32_t t = record.texturesFirst; t < record.texturesFirst + record.texturesCount; t++)
+        {
+            if (!CacheFile::IsInRange(textures[t].pathOffset, textures[t].pathLength, header->stringsSize))
+            {
+                LOG(WARNING) << "Mesh cache " << cachePath << " is corrupted";
+                return nullptr;
+            }
+            material.textures.emplace_back(static_cast<TextureType>(textures[t].type), std::string(strings + textures[t].pathOffset, textures[t].pathLength));
+        }
+        data->materials.push_back(std::move(material));
+    }
+
+    data->meshes.reserve(header->meshesCount);
+    for (uint32_t i = 0; i < header->meshesCount; i++)
+    {
+        const auto& record = meshes[i];
+        const auto vertexFormat = static_cast<VertexFormat>(record.vertexFormat);
+        const auto indexFormat = static_cast<IndexFormat>(record.indexFormat);
+        if (!VertexLayout::IsValid(vertexFormat) || !VertexLayout::IsValid(indexFormat) ||
+            !CacheFile::IsInRange(record.verticesOffset, uint64_t(record.verticesCount) * VertexLayout::GetSize(vertexFormat), fileSize) ||
+            !CacheFile::IsInRange(record.indicesOffset, uint64_t(record.indicesCount) * VertexLayout::GetIndexSize(indexFormat), fileSize) ||
+            !CacheFile::IsInRange(record.clustersOffset, uint64_t(record.clustersCount) * sizeof(MeshCacheCluster), fileSize) ||
+            !CacheFile::IsInRange(record.nameOffset, record.nameLength, header->stringsSize) ||
+            record.materialIndex >= header->materialsCount || record.lodsCount > MAX_MESH_LODS)
+        {
+            LOG(WARNING) << "Mesh cache " << cachePath << " is corrupted";
+            return nullptr;
+        }
+
+        MeshData mesh;
+        mesh.name = std::string(strings + record.nameOffset, record.nameLength);
+        mesh.materialIndex = record.materialIndex;
+        mesh.bounds.min = glm::vec3(record.boundsMin[0], record.boundsMin[1], record.boundsMin[2]);
+        mesh.bounds.max = glm::vec3(record.boundsMax[0], record.boundsMax[1], record.boundsMax[2]);
+        mesh.sphere.center = glm::vec3(record.sphereCenter[0], record.sphereCenter[1], record.sphereCenter[2]);
+        mesh.sphere.radius = record.sphereRadius;
+        mesh.uvDensity = record.uvDensity;
+
+        // pointing straight into the mapped pages, no copies are made
+        mesh.vertexFormat = vertexFormat;
+        mesh.indexFormat = indexFormat;
+        mesh.vertexData = base + record.verticesOffset;
+        mesh.indexData = base + record.indicesOffset;
+        mesh.verticesCount = record.verticesCount;
+        mesh.indicesCount = record.indicesCount;
+
+        for (uint32_t l = 0; l < record.lodsCount; l++)
+        {
+            const auto& lod = record.lods[l];
+            if (uint64_t(lod.indexOffset) + lod.indicesCount > record.indicesCount)
+            {
+                LOG(WARNING) << "Mesh cache " << cachePath << " is corrupted";
+                return nullptr;
+            }
+            mesh.lods.push_back({ lod.indexOffset, lod.indicesCount, lod.error });
+        }
+
+        // clusters are tiny compared to the vertices, so they are copied out of the mapped pages
+        const auto * clusters = reinterpret_cast<const MeshCacheCluster *>(base + record.clustersOffset);
+        mesh.clusters.reserve(record.clustersCount);
+        for (uint32_t c = 0; c < record.clustersCount; c++)
+        {
+            const auto& cluster = clusters[c];
+            if (uint64_t(cluster.indexOffset) + cluster.indicesCount > record.indicesCount)
+            {
+                LOG(WARNING) << "Mesh cache " << cachePath << " is corrupted";
+                return nullptr;
+            }
+
+            MeshCluster& result = mesh.clusters.emplace_back();
+            result.indexOffset = cluster.indexOffset;
+            result.indicesCount = cluster.indicesCount;
+            result.center = glm::vec3(cluster.center[0], cluster.center[1], cluster.center[2]);
+            result.radius = cluster.radius;
+            result.coneAxis = glm::vec3(cluster.coneAxis[0], cluster.coneAxis[1], cluster.coneAxis[2]);
+            result.coneCutoff = cluster.coneCutoff;
+        }
+
+        data->meshes.push_back(std::move(mesh));
+    }
+
+    // content hash matched, so the new time is stored to skip hashing the source on the next launches
+    if (isSourceTimeOutdated && !CacheFile::UpdateSourceTime(cachePath, offsetof(MeshCacheHeader, sourceTime), sourceTime))
+    {
+        LOG(WARNING) << "Failed to update source time of mesh cache " << cachePath;
+    }
+
+    return data;
+}
+
+void MeshCache::Save(const std::string& sourcePath, const ModelData& data)
+{
+    const std::string cachePath = GetCachePath(sourcePath);
+
+    MeshCacheHeader header {};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = version;
+
+    if (!CacheFile::GetSourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+    {
+        LOG(WARNING) << "Failed to cache " << sourcePath << ". Reason: source file is not accessible";
+        return;
+    }
+    header.sourceHash = Hash::HashFile(sourcePath);
+
+    std::string strings;
+    std::vector<MeshCacheMesh> meshes;
+    std::vector<std::vector<MeshCacheCluster>> clusters;
+    std::vector<MeshCacheMaterial> materials;
+    std::vector<MeshCacheTexture> textures;
+
+    for (const auto& material : data.materials)
+    {
+        MeshCacheMaterial record {};
+        record.defaultColor[0] = material.defaultColor.r;
+        record.defaultColor[1] = material.defaultColor.g;
+        record.defaultColor[2] = material.defaultColor.b;
+        record.defaultColor[3] = material.defaultColor.a;
+        record.specular = material.specular;
+        record.texturesFirst = static_cast<uint32_t>(textures.size());
+        record.texturesCount = static_cast<uint32_t>(material.textures.size());
+
+        for (const auto& [type, path] : material.textures)
+        {
+            textures.push_back({ static_cast<uint32_t>(type), static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(path.size()), 0 });
+            strings += path;
+        }
+        materials.push_back(record);
+    }
+
+    header.meshesCount    = static_cast<uint32_t>(data.meshes.size());
+    header.materialsCount = static_cast<uint32_t>(materials.size());
+    header.texturesCount  = static_cast<uint32_t>(textures.size());
+
+    for (int i = 0; i < 3; i++)
+    {
+        header.boundsMin[i] = data.bounds.min[i];
+        header.boundsMax[i] = data.bounds.max[i];
+    }
+
+    for (const auto& mesh : data.meshes)
+    {
+        MeshCacheMesh record {};
+        record.verticesCount = static_cast<uint32_t>(mesh.verticesCount);
+        record.indicesCount  = static_cast<uint32_t>(mesh.indicesCount);
+        record.materialIndex = mesh.materialIndex;
+        record.nameOffset    = static_cast<uint32_t>(strings.size());
+        record.nameLength    = static_cast<uint32_t>(mesh.name.size());
+        record.vertexFormat  = static_cast<uint32_t>(mesh.vertexFormat);
+        record.indexFormat   = static_cast<uint32_t>(mesh.indexFormat);
+        record.clustersCount = static_cast<uint32_t>(mesh.clusters.size());
+        record.lodsCount     = static_cast<uint32_t>(std::min<size_t>(mesh.lods.size(), MAX_MESH_LODS));
+        for (uint32_t l = 0; l < record.lodsCount; l++)
+        {
+            record.lods[l] = { mesh.lods[l].indexOffset, mesh.lods[l].indicesCount, mesh.lods[l].error };
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            record.boundsMin[i] = mesh.bounds.min[i];
+            record.boundsMax[i] = mesh.bounds.max[i];
+            record.sphereCenter[i] = mesh.sphere.center[i];
+        }
+        record.sphereRadius = mesh.sphere.radius;
+        record.uvDensity = mesh.uvDensity;
+        strings += mesh.name;
+        meshes.push_back(record);
+
+        auto& meshClusters = clusters.emplace_back();
+        for (const auto& cluster : mesh.clusters)
+        {
+            meshClusters.push_back({ cluster.indexOffset, cluster.indicesCount,
+                                     { cluster.center.x, cluster.center.y, cluster.center.z }, cluster.radius,
+                                     { cluster.coneAxis.x, cluster.coneAxis.y, cluster.coneAxis.z }, cluster.coneCutoff });
+        }
+    }
+
+    // laying out the sections
+    header.meshesOffset    = CacheFile::Align(sizeof(MeshCacheHeader));
+    header.materialsOffset = CacheFile::Align(header.meshesOffset + meshes.size() * sizeof(MeshCacheMesh));
+    header.texturesOffset  = CacheFile::Align(header.materialsOffset + materials.size() * sizeof(MeshCacheMaterial));
+    header.stringsOffset   = CacheFile::Align(header.texturesOffset + textures.size() * sizeof(MeshCacheTexture));
+    header.stringsSize     = strings.size();
+
+    uint64_t offset = CacheFile::Align(header.stringsOffset + header.stringsSize);
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        meshes[i].verticesOffset = offset;
+        offset = CacheFile::Align(offset + data.meshes[i].verticesCount * VertexLayout::GetSize(data.meshes[i].vertexFormat));
+        meshes[i].indicesOffset = offset;
+        offset = CacheFile::Align(offset + data.meshes[i].indicesCount * VertexLayout::GetIndexSize(data.meshes[i].indexFormat));
+        meshes[i].clustersOffset = offset;
+        offset = CacheFile::Align(offset + clusters[i].size() * sizeof(MeshCacheCluster));
+    }
+
+    const bool isWritten = CacheFile::Write(cachePath, [&](std::ostream& os)
+    {
+        CacheFile::WriteAt(os, 0, &header, sizeof(header));
+        CacheFile::WriteAt(os, header.meshesOffset, meshes.data(), meshes.size() * sizeof(MeshCacheMesh));
+        CacheFile::WriteAt(os, header.materialsOffset, materials.data(), materials.size() * sizeof(MeshCacheMaterial));
+        CacheFile::WriteAt(os, header.texturesOffset, textures.data(), textures.size() * sizeof(MeshCacheTexture));
+        CacheFile::WriteAt(os, header.stringsOffset, strings.data(), strings.size());
+
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            CacheFile::WriteAt(os, meshes[i].verticesOffset, data.meshes[i].vertexData, data.meshes[i].verticesCount * VertexLayout::GetSize(data.meshes[i].vertexFormat));
+            CacheFile::WriteAt(os, meshes[i].indicesOffset, data.meshes[i].indexData, data.meshes[i].indicesCount * VertexLayout::GetIndexSize(data.meshes[i].indexFormat));
+            CacheFile::WriteAt(os, meshes[i].clustersOffset, clusters[i].data(), clusters[i].size() * sizeof(MeshCacheCluster));
+        }
+    });
+
+    if (!isWritten)
+    {
+        LOG(WARNING) << "Failed to write mesh cache of " << sourcePath;
+        return;
+    }
+
+    LOG(INFO) << "Mesh cache of " << sourcePath << " written to " << cachePath;
+}
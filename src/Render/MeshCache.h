@@ -0,0 +1,67 @@
+#ifndef GRAPHICS_MESHCACHE_H
+#define GRAPHICS_MESHCACHE_H
+
+#include <memory>
+#include <string>
+#include <cstdint>
+
+struct ModelData;
+
+/**
+ * Binary mesh cache. Every imported model is written into a versioned binary file, which is memory mapped on the next
+ * launches, so vertex and index data is uploaded straight from the mapped pages, skipping assimp entirely.
+ *
+ * File layout (all offsets are relative to the beginning of the file):
+ *  - MeshCacheHeader
+ *  - MeshCacheHeader::meshesCount     x MeshCacheMesh
+ *  - MeshCacheHeader::materialsCount  x MeshCacheMaterial
+ *  - MeshCacheHeader::texturesCount   x MeshCacheTexture
+ *  - strings blob (mesh names, texture paths)
+ *  - vertex data, index data and clusters of every mesh, each block aligned to the 16 bytes
+ *
+ * Cache is invalidated if the format version, source file size or source modification time differ.
+ * If only the modification time differs, source file content hash is used as a fallback, and the new time is stored
+ * once the hash matches
+ */
+class MeshCache
+{
+public:
+    /* Restriction to create an instance of this class */
+    MeshCache() = delete;
+    MeshCache(MeshCache&&) = delete;
+    MeshCache(const MeshCache&) = delete;
+
+    /**
+     * Loads model data from the cache
+     * @param sourcePath path to the source model file
+     * @return model data, which meshes point into the mapped cache file, or nullptr if there is no valid cache
+     */
+    static std::unique_ptr<ModelData> Load(const std::string& sourcePath);
+
+    /**
+     * Writes model data into the cache. Failures are logged, but never thrown
+     * @param sourcePath path to the source model file
+     * @param data imported model data
+     */
+    static void Save(const std::string& sourcePath, const ModelData& data);
+
+    /**
+     * @param sourcePath path to the source model file
+     * @return path to the cache file of the given model
+     */
+    static std::string GetCachePath(const std::string& sourcePath);
+
+    /**
+     * Sets directory, where cache files are stored
+     * @param directory cache directory
+     */
+    static void SetCacheDirectory(const std::string& directory) { cacheDirectory = directory; }
+
+    /* Format version, must be incremented each time the layout, vertex formats or import flags change */
+    static constexpr uint32_t version = 7;
+
+private:
+    inline static std::string cacheDirectory = "../res/cache/meshes";
+};
+
+#endif //GRAPHICS_MESHCACHE_H
@@ -0,0 +1,902 @@
+#include "MeshOptimizer.h"
+#include "Bounds.hpp"
+#include "../Core/Hash.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+    /* Cache size the Forsyth scoring is tuned for */
+    constexpr int scoringCacheSize = 32;
+    constexpr float lastTriangleScore = 0.75f;
+    constexpr float cacheDecayPower = 1.5f;
+    constexpr float valenceBoostScale = 2.0f;
+    constexpr float valenceBoostPower = 0.5f;
+
+    /* Simulated hardware cache size, used to split triangles into clusters for the overdraw ordering */
+    constexpr unsigned int clusterCacheSize = 16;
+
+    constexpr unsigned int invalidIndex = ~0u;
+
+    float VertexScore(int cachePosition, unsigned int remainingTriangles)
+    {
+        if (remainingTriangles == 0)
+        {
+            return -1.0f;
+        }
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            // vertices of the last triangle get a fixed score, so the next triangle does not just reuse its edge
+            if (cachePosition < 3)
+            {
+                score = lastTriangleScore;
+            }
+            else
+            {
+                float scale = 1.0f / static_cast<float>(scoringCacheSize - 3);
+                score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scale, cacheDecayPower);
+            }
+        }
+
+        // boosting vertices with few triangles left, so the lone ones are not left behind
+        score += valenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -valenceBoostPower);
+        return score;
+    }
+
+    /* Levels of detail are not generated below this triangles count */
+    constexpr size_t minLodTriangles = 64;
+    /* Level is dropped if simplification removed less than this fraction of triangles */
+    constexpr float minLodReduction = 0.15f;
+    /* Maximum error of the whole chain, relative to the mesh bounding box diagonal */
+    constexpr float maxLodRelativeError = 0.1f;
+
+    /**
+     * Symmetric 4x4 matrix of the plane distance quadric, with the accumulated weight to normalize the error
+     */
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+        double weight = 0;
+
+        void AddPlane(const glm::dvec3& n, double d, double w)
+        {
+            a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z; a03 += w * n.x * d;
+            a11 += w * n.y * n.y; a12 += w * n.y * n.z; a13 += w * n.y * d;
+            a22 += w * n.z * n.z; a23 += w * n.z * d;
+            a33 += w * d * d;
+            weight += w;
+        }
+
+        Quadric& operator +=(const Quadric& other)
+        {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+            a11 += other.a11; a12 += other.a12; a13 += other.a13;
+            a22 += other.a22; a23 += other.a23;
+            a33 += other.a33;
+            weight += other.weight;
+            return * this;
+        }
+
+        /**
+         * @return weighted sum of squared distances from the point to the planes
+         */
+        [[nodiscard]] double Evaluate(const glm::vec3& p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            return a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+                 + a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+                 + a22 * z * z + 2 * a23 * z
+                 + a33;
+        }
+    };
+
+    struct PositionHasher
+    {
+        size_t operator()(const glm::vec3& position) const
+        {
+            return static_cast<size_t>(Hash::Fnv1a(&position, sizeof(glm::vec3)));
+        }
+    };
+
+    struct VertexHasher
+    {
+        size_t operator()(const Vertex& vertex) const
+        {
+            return static_cast<size_t>(Hash::Fnv1a(&vertex, sizeof(Vertex)));
+        }
+    };
+
+    struct VertexEqual
+    {
+        bool operator()(const Vertex& lhs, const Vertex& rhs) const
+        {
+            return std::memcmp(&lhs, &rhs, sizeof(Vertex)) == 0;
+        }
+    };
+}
+
+void MeshOptimizer::Optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    WeldVertices(vertices, indices);
+    OptimizeVertexCache(indices, vertices.size());
+    OptimizeOverdraw(indices, vertices);
+    OptimizeVertexFetch(vertices, indices);
+}
+
+void MeshOptimizer::WeldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    std::vector<Vertex> unique;
+    std::vector<unsigned int> remap(vertices.size());
+    std::unordered_map<Vertex, unsigned int, VertexHasher, VertexEqual> lookup;
+
+    unique.reserve(vertices.size());
+    lookup.reserve(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        auto [it, isInserted] = lookup.try_emplace(vertices[i], static_cast<unsigned int>(unique.size()));
+        if (isInserted)
+        {
+            unique.push_back(vertices[i]);
+        }
+        remap[i] = it->second;
+    }
+
+    // welding may collapse triangles, they are dropped as they never produce any fragments
+    std::vector<unsigned int> welded;
+    welded.reserve(indices.size());
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        unsigned int a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+        if (a != b && b != c && a != c)
+        {
+            welded.insert(welded.end(), { a, b, c });
+        }
+    }
+
+    vertices = std::move(unique);
+    indices = std::move(welded);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, size_t verticesCount)
+{
+    const size_t trianglesCount = indices.size() / 3;
+    if (trianglesCount == 0)
+    {
+        return;
+    }
+
+    // vertex to triangles adjacency, triangles which are not emitted yet are kept in front of each list
+    std::vector<unsigned int> remaining(verticesCount, 0);
+    for (unsigned int index : indices)
+    {
+        remaining[index]++;
+    }
+
+    std::vector<unsigned int> offsets(verticesCount + 1, 0);
+    for (size_t v = 0; v < verticesCount; v++)
+    {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < trianglesCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+        }
+    }
+
+    std::vector<int> cachePosition(verticesCount, -1);
+    std::vector<float> vertexScores(verticesCount);
+    for (size_t v = 0; v < verticesCount; v++)
+    {
+        vertexScores[v] = VertexScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScores(trianglesCount);
+    std::vector<bool> isEmitted(trianglesCount, false);
+
+    unsigned int bestTriangle = 0;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < trianglesCount; t++)
+    {
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+        if (triangleScores[t] > bestScore)
+        {
+            bestScore = triangleScores[t];
+            bestTriangle = static_cast<unsigned int>(t);
+        }
+    }
+
+    std::vector<unsigned int> cache, newCache;
+    cache.reserve(scoringCacheSize + 3);
+    newCache.reserve(scoringCacheSize + 3);
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    size_t cursor = 0;
+    for (size_t emittedCount = 0; emittedCount < trianglesCount; emittedCount++)
+    {
+        // no candidates in the cache, continuing from the next triangle in the input order
+        if (bestTriangle == invalidIndex)
+        {
+            while (isEmitted[cursor])
+            {
+                cursor++;
+            }
+            bestTriangle = static_cast<unsigned int>(cursor);
+        }
+
+        isEmitted[bestTriangle] = true;
+
+        const unsigned int * triangle = &indices[bestTriangle * 3];
+        newCache.assign(triangle, triangle + 3);
+        result.insert(result.end(), triangle, triangle + 3);
+
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = triangle[k];
+            unsigned int * first = &adjacency[offsets[v]];
+            unsigned int * last = first + remaining[v];
+            std::iter_swap(std::find(first, last, bestTriangle), last - 1);
+            remaining[v]--;
+        }
+
+        for (unsigned int v : cache)
+        {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+            {
+                newCache.push_back(v);
+            }
+        }
+
+        // updating scores of everything the cache touched, including vertices that were just pushed out of it
+        for (size_t i = 0; i < newCache.size(); i++)
+        {
+            unsigned int v = newCache[i];
+            cachePosition[v] = i < scoringCacheSize ? static_cast<int>(i) : -1;
+
+            float score = VertexScore(cachePosition[v], remaining[v]);
+            float delta = score - vertexScores[v];
+            vertexScores[v] = score;
+
+            for (unsigned int a = offsets[v]; a < offsets[v] + remaining[v]; a++)
+            {
+                triangleScores[adjacency[a]] += delta;
+            }
+        }
+
+        if (newCache.size() > scoringCacheSize)
+        {
+            newCache.resize(scoringCacheSize);
+        }
+        std::swap(cache, newCache);
+
+        bestTriangle = invalidIndex;
+        bestScore = -1.0f;
+        for (unsigned int v : cache)
+        {
+            for (unsigned int a = offsets[v]; a < offsets[v] + remaining[v]; a++)
+            {
+                unsigned int t = adjacency[a];
+                if (triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+    }
+
+    indices = std::move(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices)
+{
+    const size_t trianglesCount = indices.size() / 3;
+    if (trianglesCount == 0)
+    {
+        return;
+    }
+
+    // a new cluster starts wherever the cache ordering had to start over, i.e. all vertices of the triangle miss
+    std::vector<size_t> clusters;
+    std::vector<unsigned int> cacheTime(vertices.size(), 0);
+    unsigned int time = clusterCacheSize + 1;
+
+    for (size_t t = 0; t < trianglesCount; t++)
+    {
+        int misses = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (time - cacheTime[v] > clusterCacheSize)
+            {
+                cacheTime[v] = time++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3)
+        {
+            clusters.push_back(t);
+        }
+    }
+
+    glm::vec3 meshCentroid(0.0f);
+    for (unsigned int index : indices)
+    {
+        meshCentroid += vertices[index].Position;
+    }
+    meshCentroid /= static_cast<float>(indices.size());
+
+    // outer facing clusters occlude the rest of the mesh, so they go first
+    std::vector<float> sortKeys(clusters.size());
+    for (size_t c = 0; c < clusters.size(); c++)
+    {
+        size_t begin = clusters[c];
+        size_t end = c + 1 < clusters.size() ? clusters[c + 1] : trianglesCount;
+
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = begin; t < end; t++)
+        {
+            const glm::vec3& p0 = vertices[indices[t * 3]].Position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+
+            glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+            float triangleArea = glm::length(cross);
+
+            centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+            normal += cross;
+            area += triangleArea;
+        }
+
+        centroid = area > 0.0f ? centroid / area : centroid;
+        float normalLength = glm::length(normal);
+        sortKeys[c] = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+    }
+
+    std::vector<size_t> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t lhs, size_t rhs) { return sortKeys[lhs] > sortKeys[rhs]; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (size_t c : order)
+    {
+        size_t begin = clusters[c];
+        size_t end = c + 1 < clusters.size() ? clusters[c + 1] : trianglesCount;
+        result.insert(result.end(), indices.begin() + static_cast<std::ptrdiff_t>(begin * 3), indices.begin() + static_cast<std::ptrdiff_t>(end * 3));
+    }
+
+    indices = std::move(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    std::vector<unsigned int> remap(vertices.size(), invalidIndex);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+
+    for (unsigned int& index : indices)
+    {
+        if (remap[index] == invalidIndex)
+        {
+            remap[index] = static_cast<unsigned int>(ordered.size());
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices = std::move(ordered);
+}
+
+std::vector<unsigned int> MeshOptimizer::Simplify(const std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, size_t targetIndicesCount, float targetError, float& resultError)
+{
+    resultError = 0.0f;
+    std::vector<unsigned int> result = indices;
+    if (result.size() <= targetIndicesCount)
+    {
+        return result;
+    }
+
+    const size_t verticesCount = vertices.size();
+
+    // vertices, split by the attribute seams, share the position
+    std::vector<unsigned int> positionIds(verticesCount);
+    std::unordered_map<glm::vec3, unsigned int, PositionHasher> positionLookup;
+    for (size_t v = 0; v < verticesCount; v++)
+    {
+        positionIds[v] = positionLookup.try_emplace(vertices[v].Position, static_cast<unsigned int>(positionLookup.size())).first->second;
+    }
+    const size_t positionsCount = positionLookup.size();
+
+    std::vector<unsigned int> wedgesCount(positionsCount, 0);
+    for (size_t v = 0; v < verticesCount; v++)
+    {
+        wedgesCount[positionIds[v]]++;
+    }
+
+    // open border edges belong to a single triangle
+    std::unordered_map<uint64_t, unsigned int> edgeUsage;
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            uint64_t a = positionIds[result[i + k]], b = positionIds[result[i + (k + 1) % 3]];
+            edgeUsage[a < b ? (a << 32) | b : (b << 32) | a]++;
+        }
+    }
+
+    std::vector<bool> isLockedPosition(positionsCount, false);
+    for (const auto& [edge, usage] : edgeUsage)
+    {
+        if (usage == 1)
+        {
+            isLockedPosition[edge >> 32] = true;
+            isLockedPosition[edge & 0xFFFFFFFFu] = true;
+        }
+    }
+
+    std::vector<bool> isLocked(verticesCount);
+    for (size_t v = 0; v < verticesCount; v++)
+    {
+        isLocked[v] = isLockedPosition[positionIds[v]] || wedgesCount[positionIds[v]] > 1;
+    }
+
+    std::vector<Quadric> quadrics(positionsCount);
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        const glm::dvec3 p0 = vertices[result[i]].Position, p1 = vertices[result[i + 1]].Position, p2 = vertices[result[i + 2]].Position;
+        glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        double area = glm::length(normal);
+        if (area <= 0.0)
+        {
+            continue;
+        }
+        normal /= area;
+
+        for (int k = 0; k < 3; k++)
+        {
+            quadrics[positionIds[result[i + k]]].AddPlane(normal, -glm::dot(normal, p0), area);
+        }
+    }
+
+    auto collapseCost = [&](unsigned int from, unsigned int to)
+    {
+        Quadric q = quadrics[positionIds[from]];
+        q += quadrics[positionIds[to]];
+        return q.weight > 0.0 ? std::max(q.Evaluate(vertices[to].Position) / q.weight, 0.0) : 0.0;
+    };
+
+    struct Collapse
+    {
+        unsigned int from;
+        unsigned int to;
+        double cost;
+    };
+
+    const double maxCost = static_cast<double>(targetError) * targetError;
+    double currentCost = 0.0;
+
+    std::vector<unsigned int> remap(verticesCount);
+    std::iota(remap.begin(), remap.end(), 0);
+
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> adjacencyOffsets(verticesCount + 1), adjacency;
+    std::vector<bool> isTouched(verticesCount);
+
+    while (result.size() > targetIndicesCount)
+    {
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int a = result[i + k], b = result[i + (k + 1) % 3];
+                if (!isLocked[a])
+                {
+                    collapses.push_back({ a, b, collapseCost(a, b) });
+                }
+                if (!isLocked[b])
+                {
+                    collapses.push_back({ b, a, collapseCost(b, a) });
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs) { return lhs.cost < rhs.cost; });
+
+        // vertex to triangles adjacency of the current pass
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (unsigned int index : result)
+        {
+            adjacencyOffsets[index + 1]++;
+        }
+        for (size_t v = 0; v < verticesCount; v++)
+        {
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+        adjacency.resize(result.size());
+        std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < result.size(); i++)
+        {
+            adjacency[fill[result[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+
+        std::fill(isTouched.begin(), isTouched.end(), false);
+
+        const size_t trianglesToRemove = (result.size() - targetIndicesCount) / 3;
+        size_t trianglesRemoved = 0, collapsesApplied = 0;
+
+        for (const auto& collapse : collapses)
+        {
+            if (trianglesRemoved >= trianglesToRemove || collapse.cost > maxCost)
+            {
+                break;
+            }
+            if (isTouched[collapse.from] || isTouched[collapse.to])
+            {
+                continue;
+            }
+
+            // collapse must not flip any of the remaining triangles around the collapsed vertex
+            bool isFlipping = false;
+            size_t trianglesCollapsed = 0;
+            const glm::vec3& target = vertices[collapse.to].Position;
+            for (unsigned int a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && !isFlipping; a++)
+            {
+                const unsigned int * triangle = &result[adjacency[a] * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    trianglesCollapsed++;
+                    continue;
+                }
+
+                glm::vec3 p[3], moved[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    p[k] = vertices[triangle[k]].Position;
+                    moved[k] = triangle[k] == collapse.from ? target : p[k];
+                }
+                glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+                isFlipping = glm::dot(before, after) <= 0.0f;
+            }
+            if (isFlipping)
+            {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[positionIds[collapse.to]] += quadrics[positionIds[collapse.from]];
+            currentCost = std::max(currentCost, collapse.cost);
+            trianglesRemoved += trianglesCollapsed;
+            collapsesApplied++;
+
+            // the whole one-ring has changed, it is not touched again until the next pass
+            for (unsigned int a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; a++)
+            {
+                const unsigned int * triangle = &result[adjacency[a] * 3];
+                isTouched[triangle[0]] = isTouched[triangle[1]] = isTouched[triangle[2]] = true;
+            }
+        }
+
+        if (collapsesApplied == 0)
+        {
+            break;
+        }
+
+        std::vector<unsigned int> collapsed;
+        collapsed.reserve(result.size());
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a != b && b != c && a != c)
+            {
+                collapsed.insert(collapsed.end(), { a, b, c });
+            }
+        }
+        result = std::move(collapsed);
+    }
+
+    resultError = static_cast<float>(std::sqrt(currentCost));
+    return result;
+}
+
+std::vector<MeshLod> MeshOptimizer::GenerateLods(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices)
+{
+    std::vector<MeshLod> lods;
+    lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+
+    glm::vec3 min(std::numeric_limits<float>::max()), max(std::numeric_limits<float>::lowest());
+    for (const auto& vertex : vertices)
+    {
+        min = glm::min(min, vertex.Position);
+        max = glm::max(max, vertex.Position);
+    }
+    const float maxError = vertices.empty() ? 0.0f : glm::length(max - min) * maxLodRelativeError;
+
+    std::vector<unsigned int> current(indices);
+    float error = 0.0f;
+
+    while (lods.size() < MAX_MESH_LODS)
+    {
+        size_t target = (current.size() / 6) * 3;
+        if (target < minLodTriangles * 3)
+        {
+            break;
+        }
+
+        // every level is simplified from the previous one, so errors add up
+        float levelError = 0.0f;
+        std::vector<unsigned int> simplified = Simplify(current, vertices, target, maxError - error, levelError);
+        if (static_cast<float>(simplified.size()) > static_cast<float>(current.size()) * (1.0f - minLodReduction))
+        {
+            break;
+        }
+
+        OptimizeVertexCache(simplified, vertices.size());
+
+        error += levelError;
+        lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), error });
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        current = std::move(simplified);
+    }
+
+    return lods;
+}
+
+std::vector<MeshCluster> MeshOptimizer::BuildClusters(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices)
+{
+    std::vector<MeshCluster> clusters;
+    const size_t trianglesCount = indices.size() / 3;
+    if (trianglesCount == 0)
+    {
+        return clusters;
+    }
+
+    // triangles adjacent to every vertex
+    std::vector<unsigned int> adjacencyOffsets(vertices.size() + 1, 0);
+    for (unsigned int index : indices)
+    {
+        adjacencyOffsets[index + 1]++;
+    }
+    std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t t = 0; t < trianglesCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            adjacency[adjacencyFill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+        }
+    }
+
+    std::vector<glm::vec3> triangleCenters(trianglesCount);
+    for (size_t t = 0; t < trianglesCount; t++)
+    {
+        triangleCenters[t] = (vertices[indices[t * 3]].Position + vertices[indices[t * 3 + 1]].Position + vertices[indices[t * 3 + 2]].Position) / 3.0f;
+    }
+
+    std::vector<bool> isEmitted(trianglesCount, false);
+    // index of the last cluster, which used the vertex, so membership checks need no clearing
+    std::vector<unsigned int> vertexCluster(vertices.size(), invalidIndex);
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> clusterVertices;
+    size_t nextSeed = 0;
+
+    auto newVerticesCount = [&](size_t t, unsigned int clusterIndex)
+    {
+        unsigned int count = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            count += vertexCluster[indices[t * 3 + k]] != clusterIndex;
+        }
+        return count;
+    };
+
+    while (result.size() < indices.size())
+    {
+        const auto clusterIndex = static_cast<unsigned int>(clusters.size());
+        MeshCluster cluster;
+        cluster.indexOffset = static_cast<uint32_t>(result.size());
+
+        candidates.clear();
+        clusterVertices.clear();
+        glm::vec3 centroid(0.0f);
+        unsigned int clusterTriangles = 0;
+
+        auto emit = [&](size_t t)
+        {
+            isEmitted[t] = true;
+            for (int k = 0; k < 3; k++)
+            {
+                const unsigned int v = indices[t * 3 + k];
+                result.push_back(v);
+                if (vertexCluster[v] != clusterIndex)
+                {
+                    vertexCluster[v] = clusterIndex;
+                    clusterVertices.push_back(v);
+                    for (unsigned int a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; a++)
+                    {
+                        if (!isEmitted[adjacency[a]])
+                        {
+                            candidates.push_back(adjacency[a]);
+                        }
+                    }
+                }
+            }
+            clusterTriangles++;
+            centroid += (triangleCenters[t] - centroid) / static_cast<float>(clusterTriangles);
+        };
+
+        while (clusterTriangles < MAX_CLUSTER_TRIANGLES)
+        {
+            // growing over the connected triangles, preferring the ones which add fewer vertices and stay close to the cluster
+            size_t best = trianglesCount;
+            float bestScore = std::numeric_limits<float>::max();
+            size_t alive = 0;
+            for (unsigned int t : candidates)
+            {
+                if (isEmitted[t])
+                {
+                    continue;
+                }
+                candidates[alive++] = t;
+
+                const unsigned int added = newVerticesCount(t, clusterIndex);
+                if (clusterVertices.size() + added > MAX_CLUSTER_VERTICES)
+                {
+                    continue;
+                }
+
+                const glm::vec3 offset = triangleCenters[t] - centroid;
+                const float score = static_cast<float>(added) * 1e6f + glm::dot(offset, offset) / (1.0f + glm::dot(offset, offset));
+                if (score < bestScore)
+                {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+            candidates.resize(alive);
+
+            // disconnected parts continue with the next triangle in the original, cache optimized, order
+            if (best == trianglesCount)
+            {
+                while (nextSeed < trianglesCount && isEmitted[nextSeed])
+                {
+                    nextSeed++;
+                }
+                if (nextSeed == trianglesCount || clusterVertices.size() + newVerticesCount(nextSeed, clusterIndex) > MAX_CLUSTER_VERTICES)
+                {
+                    break;
+                }
+                best = nextSeed;
+            }
+
+            emit(best);
+        }
+
+        cluster.indicesCount = static_cast<uint32_t>(result.size()) - cluster.indexOffset;
+
+        // bounding sphere around the box center, good enough for the small clusters
+        BoundingBox bounds;
+        for (unsigned int v : clusterVertices)
+        {
+            bounds.Extend(vertices[v].Position);
+        }
+        cluster.center = bounds.GetCenter();
+        for (unsigned int v : clusterVertices)
+        {
+            cluster.radius = std::max(cluster.radius, glm::length(vertices[v].Position - cluster.center));
+        }
+
+        // normal cone of the face normals
+        std::vector<glm::vec3> normals;
+        glm::vec3 axis(0.0f);
+        for (uint32_t i = cluster.indexOffset; i < cluster.indexOffset + cluster.indicesCount; i += 3)
+        {
+            const glm::vec3& p0 = vertices[result[i]].Position;
+            const glm::vec3 normal = glm::cross(vertices[result[i + 1]].Position - p0, vertices[result[i + 2]].Position - p0);
+            const float length = glm::length(normal);
+            if (length > 0.0f)
+            {
+                normals.push_back(normal / length);
+                axis += normals.back();
+            }
+        }
+
+        if (glm::length(axis) > 1e-6f)
+        {
+            axis = glm::normalize(axis);
+            float minDot = 1.0f;
+            for (const auto& normal : normals)
+            {
+                minDot = std::min(minDot, glm::dot(normal, axis));
+            }
+
+            // cones wider than ~85 degrees would almost never reject anything
+            if (minDot > 0.1f)
+            {
+                cluster.coneAxis = axis;
+                cluster.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+            }
+        }
+
+        clusters.push_back(cluster);
+    }
+
+    indices = std::move(result);
+    return clusters;
+}
+
+float MeshOptimizer::ComputeUvDensity(const std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices)
+{
+    double surfaceArea = 0.0, uvArea = 0.0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const Vertex& a = vertices[indices[i]];
+        const Vertex& b = vertices[indices[i + 1]];
+        const Vertex& c = vertices[indices[i + 2]];
+
+        surfaceArea += 0.5 * glm::length(glm::cross(b.Position - a.Position, c.Position - a.Position));
+
+        const glm::vec2 u = b.TexCoords - a.TexCoords, v = c.TexCoords - a.TexCoords;
+        uvArea += 0.5 * std::abs(u.x * v.y - u.y * v.x);
+    }
+
+    // areas scale quadratically, densities linearly
+    return surfaceArea > 0.0 ? static_cast<float>(std::sqrt(uvArea / surfaceArea)) : 0.0f;
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t verticesCount, unsigned int cacheSize)
+{
+    VertexCacheStats stats;
+    if (indices.empty())
+    {
+        return stats;
+    }
+
+    std::vector<unsigned int> cacheTime(verticesCount, 0);
+    std::vector<bool> isUsed(verticesCount, false);
+    unsigned int time = cacheSize + 1;
+    size_t misses = 0, usedVertices = 0;
+
+    for (unsigned int index : indices)
+    {
+        if (time - cacheTime[index] > cacheSize)
+        {
+            cacheTime[index] = time++;
+            misses++;
+        }
+        if (!isUsed[index])
+        {
+            isUsed[index] = true;
+            usedVertices++;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(usedVertices);
+    return stats;
+}
@@ -0,0 +1,152 @@
+#ifndef GRAPHICS_MESHOPTIMIZER_H
+#define GRAPHICS_MESHOPTIMIZER_H
+
+#include "VertexLayout.h"
+#include "glm/glm.hpp"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Post-transform vertex cache efficiency of an index buffer
+ */
+struct VertexCacheStats
+{
+    /* Average cache miss ratio: transformed vertices per triangle, 0.5 is the best possible, 3 is the worst */
+    float acmr = 0.0f;
+    /* Average transform to vertex ratio: transformed vertices per unique vertex, 1 is the best possible */
+    float atvr = 0.0f;
+};
+
+constexpr int MAX_MESH_LODS = 5;
+
+/**
+ * Single level of detail of a mesh. All levels share vertices, each of them is a range of the mesh index buffer
+ */
+struct MeshLod
+{
+    uint32_t indexOffset = 0;
+    uint32_t indicesCount = 0;
+    /* Geometric error of the level, in model space units */
+    float error = 0.0f;
+};
+
+/* Cluster size limits, small enough for tight bounds and large enough to keep the culling cost low */
+constexpr unsigned int MAX_CLUSTER_VERTICES = 64;
+constexpr unsigned int MAX_CLUSTER_TRIANGLES = 124;
+
+/**
+ * Small group of connected triangles, a range of the full detail level of the mesh index buffer
+ */
+struct MeshCluster
+{
+    uint32_t indexOffset = 0;
+    uint32_t indicesCount = 0;
+
+    /* Bounding sphere, in model space */
+    glm::vec3 center { 0.0f };
+    float radius = 0.0f;
+
+    /* Normal cone: cluster is backfacing if viewed from inside of the cone, cutoff of 1 disables the test */
+    glm::vec3 coneAxis { 0.0f };
+    float coneCutoff = 1.0f;
+};
+
+/**
+ * Import time mesh optimizations. All of them work on the full precision vertices, before they are packed
+ */
+class MeshOptimizer
+{
+public:
+    /* Restriction to create an instance of this class */
+    MeshOptimizer() = delete;
+    MeshOptimizer(MeshOptimizer&&) = delete;
+    MeshOptimizer(const MeshOptimizer&) = delete;
+
+    /**
+     * Runs the whole optimization pipeline: welding, vertex cache and overdraw ordering of the triangles and
+     * fetch ordering of the vertices
+     * @param vertices mesh vertices
+     * @param indices mesh triangles
+     */
+    static void Optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+    /**
+     * Merges bitwise identical vertices and removes degenerate triangles
+     * @param vertices mesh vertices
+     * @param indices mesh triangles
+     */
+    static void WeldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+    /**
+     * Reorders triangles for the post-transform vertex cache (Tom Forsyth's linear-speed algorithm)
+     * @param indices mesh triangles, must not contain degenerate triangles
+     * @param verticesCount number of vertices
+     */
+    static void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t verticesCount);
+
+    /**
+     * Reorders clusters of cache coherent triangles, so the outer facing ones are drawn first, reducing overdraw
+     * without losing much of the vertex cache efficiency
+     * @param indices mesh triangles, optimized for the vertex cache
+     * @param vertices mesh vertices
+     */
+    static void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices);
+
+    /**
+     * Reorders vertices in the order of their first use and drops unused ones, so vertex fetch reads memory linearly
+     * @param vertices mesh vertices
+     * @param indices mesh triangles
+     */
+    static void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+    /**
+     * Simplifies mesh with the quadric error metric edge collapses. Vertices are never moved, they are collapsed onto
+     * their neighbours; open borders and attribute seams are locked, so simplification never opens cracks in the mesh
+     * @param indices mesh triangles
+     * @param vertices mesh vertices
+     * @param targetIndicesCount desired number of indices
+     * @param targetError maximum allowed error, in model space units
+     * @param resultError error of the simplified mesh, in model space units
+     * @return simplified mesh triangles, referencing the same vertices
+     */
+    static std::vector<unsigned int> Simplify(const std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, size_t targetIndicesCount, float targetError, float& resultError);
+
+    /**
+     * Builds chain of the levels of detail, halving triangles count with each level. Levels are appended to the index
+     * buffer, every one of them is optimized for the vertex cache
+     * @param indices mesh triangles, contain the full detail level on input and all levels on output
+     * @param vertices mesh vertices
+     * @return levels of detail, the first one is the original mesh
+     */
+    static std::vector<MeshLod> GenerateLods(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices);
+
+    /**
+     * Splits mesh into clusters of connected triangles and reorders the triangles, so every cluster is a contiguous
+     * range of the index buffer. Vertices are neither duplicated nor moved
+     * @param indices mesh triangles, reordered in place
+     * @param vertices mesh vertices
+     * @return clusters with their bounding spheres and normal cones
+     */
+    static std::vector<MeshCluster> BuildClusters(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices);
+
+    /**
+     * Measures how densely texture coordinates are spread over the mesh surface
+     * @param indices mesh triangles
+     * @param vertices mesh vertices
+     * @return texture coordinates units per model space unit, 0 if mesh has no area
+     */
+    static float ComputeUvDensity(const std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices);
+
+    /**
+     * Simulates FIFO post-transform vertex cache
+     * @param indices mesh triangles
+     * @param verticesCount number of vertices
+     * @param cacheSize simulated cache size
+     * @return cache statistics
+     */
+    static VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t verticesCount, unsigned int cacheSize = 16);
+};
+
+#endif //GRAPHICS_MESHOPTIMIZER_H
@@ -0,0 +1,305 @@
+#include "MipGenerator.h"
+
+#include <cmath>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_GENERATOR_SSE
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX__)
+#define MIP_GENERATOR_AVX
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    /* Resolution of the linear to sRGB table, high enough to keep the dark values intact */
+    constexpr int srgbTableSize = 4096;
+
+    /**
+     * Per channel byte to float conversion tables, so converting pixels never calls pow
+     */
+    struct ConversionTables
+    {
+        /* Byte to [0; 1] */
+        float unorm[256];
+        /* Byte to [-1; 1] */
+        float snorm[256];
+        /* sRGB encoded byte to linear [0; 1] */
+        float srgbToLinear[256];
+        /* Linear [0; 1], quantized to the table size, to sRGB encoded byte */
+        uint8_t linearToSrgb[srgbTableSize];
+
+        ConversionTables()
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                const float value = static_cast<float>(i) / 255.0f;
+                unorm[i] = value;
+                snorm[i] = value * 2.0f - 1.0f;
+                srgbToLinear[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+            }
+            for (int i = 0; i < srgbTableSize; i++)
+            {
+                const float value = static_cast<float>(i) / static_cast<float>(srgbTableSize - 1);
+                const float encoded = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+                linearToSrgb[i] = static_cast<uint8_t>(std::clamp(encoded, 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+        }
+    };
+
+    const ConversionTables& GetTables()
+    {
+        // constructed once, thread safe since C++11
+        static const ConversionTables tables;
+        return tables;
+    }
+
+    inline bool IsAlphaChannel(int channel, int components)
+    {
+        return (components == 4 && channel == 3) || (components == 2 && channel == 1);
+    }
+
+    inline bool IsNormalFilter(MipFilter filter, int components)
+    {
+        // vectors need at least three channels
+        return filter == MipFilter::Normal && components >= 3;
+    }
+
+    /**
+     * Converts row of pixels to floats, in the space where they are averaged
+     */
+    void DecodeRow(const uint8_t * pixels, int width, int components, MipFilter filter, float * destination)
+    {
+        const auto& tables = GetTables();
+
+        const float * channelTables[4];
+        for (int c = 0; c < components; c++)
+        {
+            channelTables[c] = tables.unorm;
+            if (filter == MipFilter::Srgb && !IsAlphaChannel(c, components))
+            {
+                channelTables[c] = tables.srgbToLinear;
+            }
+            else if (IsNormalFilter(filter, components) && c < 3)
+            {
+                channelTables[c] = tables.snorm;
+            }
+        }
+
+        for (int x = 0; x < width; x++)
+        {
+            for (int c = 0; c < components; c++)
+            {
+                destination[x * components + c] = channelTables[c][pixels[x * components + c]];
+            }
+        }
+    }
+
+    /**
+     * Adds source row to the destination one
+     */
+    void AddRows(float * destination, const float * source, size_t count)
+    {
+        size_t i = 0;
+#ifdef MIP_GENERATOR_AVX
+        for (; i + 8 <= count; i += 8)
+        {
+            _mm256_storeu_ps(destination + i, _mm256_add_ps(_mm256_loadu_ps(destination + i), _mm256_loadu_ps(source + i)));
+        }
+#endif
+#ifdef MIP_GENERATOR_SSE
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i), _mm_loadu_ps(source + i)));
+        }
+#endif
+        for (; i < count; i++)
+        {
+            destination[i] += source[i];
+        }
+    }
+
+    inline uint8_t EncodeUnorm(float value)
+    {
+        return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    inline uint8_t EncodeSrgb(float value)
+    {
+        return GetTables().linearToSrgb[static_cast<int>(std::clamp(value, 0.0f, 1.0f) * (srgbTableSize - 1) + 0.5f)];
+    }
+
+    /**
+     * Converts averaged pixel back to bytes
+     */
+    void EncodePixel(float * pixel, int components, MipFilter filter, uint8_t * destination)
+    {
+        if (IsNormalFilter(filter, components))
+        {
+            const float length = std::sqrt(pixel[0] * pixel[0] + pixel[1] * pixel[1] + pixel[2] * pixel[2]);
+            const float scale = length > 1e-6f ? 0.5f / length : 0.0f;
+            for (int c = 0; c < 3; c++)
+            {
+                pixel[c] = pixel[c] * scale + 0.5f;
+            }
+        }
+
+        for (int c = 0; c < components; c++)
+        {
+            const bool isSrgb = filter == MipFilter::Srgb && !IsAlphaChannel(c, components);
+            destination[c] = isSrgb ? EncodeSrgb(pixel[c]) : EncodeUnorm(pixel[c]);
+        }
+    }
+
+    /**
+     * Averages pairs of pixels of the summed rows and writes the output row
+     */
+    void ReduceRow(const float * row, int width, int levelWidth, int components, MipFilter filter, uint8_t * destination)
+    {
+#ifdef MIP_GENERATOR_SSE
+        if (components == 4)
+        {
+            const __m128 quarter = _mm_set1_ps(0.25f);
+            const __m128 scale = _mm_set1_ps(255.0f);
+            for (int x = 0; x < levelWidth; x++)
+            {
+                const int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+                __m128 pixel = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(row + x0 * 4), _mm_loadu_ps(row + x1 * 4)), quarter);
+
+                if (filter == MipFilter::Srgb)
+                {
+                    alignas(16) float values[4];
+                    _mm_store_ps(values, pixel);
+                    EncodePixel(values, components, filter, destination + x * 4);
+                    continue;
+                }
+
+                if (filter == MipFilter::Normal)
+                {
+                    // renormalizing xyz, alpha is kept as is
+                    const __m128 squared = _mm_mul_ps(pixel, pixel);
+                    const float lengthSquared = _mm_cvtss_f32(squared) +
+                                                _mm_cvtss_f32(_mm_shuffle_ps(squared, squared, _MM_SHUFFLE(1, 1, 1, 1))) +
+                                                _mm_cvtss_f32(_mm_shuffle_ps(squared, squared, _MM_SHUFFLE(2, 2, 2, 2)));
+                    const float lengthScale = lengthSquared > 1e-12f ? 0.5f / std::sqrt(lengthSquared) : 0.0f;
+                    pixel = _mm_add_ps(_mm_mul_ps(pixel, _mm_setr_ps(lengthScale, lengthScale, lengthScale, 1.0f)),
+                                       _mm_setr_ps(0.5f, 0.5f, 0.5f, 0.0f));
+                }
+
+                // conversion rounds to the nearest, packing saturates to [0; 255]
+                const __m128i integers = _mm_cvtps_epi32(_mm_mul_ps(pixel, scale));
+                const __m128i words = _mm_packs_epi32(integers, integers);
+                const int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+                std::memcpy(destination + x * 4, &bytes, 4);
+            }
+            return;
+        }
+#endif
+        for (int x = 0; x < levelWidth; x++)
+        {
+            const int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+            float pixel[4];
+            for (int c = 0; c < components; c++)
+            {
+                pixel[c] = (row[x0 * components + c] + row[x1 * components + c]) * 0.25f;
+            }
+            EncodePixel(pixel, components, filter, destination + x * components);
+        }
+    }
+}
+
+MipFilter MipGenerator::SelectFilter(TextureType type)
+{
+    switch (type)
+    {
+        case Diffuse:
+            return MipFilter::Srgb;
+        case Normal:
+            return MipFilter::Normal;
+        default:
+            return MipFilter::Linear;
+    }
+}
+
+int MipGenerator::GetLevelsCount(int width, int height)
+{
+    int levels = 1;
+    while ((std::max(width, height) >> levels) > 0)
+    {
+        levels++;
+    }
+    return levels;
+}
+
+void MipGenerator::Downsample(const uint8_t * pixels, int width, int height, int components, MipFilter filter, uint8_t * destination)
+{
+    const int levelWidth = std::max(width / 2, 1), levelHeight = std::max(height / 2, 1);
+    const size_t rowSize = static_cast<size_t>(width) * components;
+
+    std::vector<float> rows(rowSize * 2);
+    float * top = rows.data();
+    float * bottom = rows.data() + rowSize;
+
+    for (int y = 0; y < levelHeight; y++)
+    {
+        const int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+        DecodeRow(pixels + y0 * rowSize, width, components, filter, top);
+        DecodeRow(pixels + y1 * rowSize, width, components, filter, bottom);
+        AddRows(top, bottom, rowSize);
+        ReduceRow(top, width, levelWidth, components, filter, destination + static_cast<size_t>(y) * levelWidth * components);
+    }
+}
+
+std::shared_ptr<TextureData> MipGenerator::Generate(const ImageData& image, MipFilter filter)
+{
+    auto data = std::make_shared<TextureData>();
+    switch (image.components)
+    {
+        case 1:
+            data->pixelFormat = GL_RED;
+            data->internalFormat = GL_R8;
+            break;
+        case 2:
+            data->pixelFormat = GL_RG;
+            data->internalFormat = GL_RG8;
+            break;
+        case 3:
+            data->pixelFormat = GL_RGB;
+            data->internalFormat = GL_RGB8;
+            break;
+        default:
+            data->pixelFormat = GL_RGBA;
+            data->internalFormat = GL_RGBA8;
+            break;
+    }
+
+    // laying out all the levels in a single allocation
+    size_t size = 0;
+    int width = image.width, height = image.height;
+    for (int i = 0; i < GetLevelsCount(image.width, image.height); i++)
+    {
+        const size_t levelSize = static_cast<size_t>(width) * height * image.components;
+        data->levels.push_back({ width, height, size, levelSize });
+        size += levelSize;
+
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+    data->storage.resize(size);
+
+    std::memcpy(data->storage.data(), image.pixels.get(), data->levels.front().size);
+    for (size_t i = 1; i < data->levels.size(); i++)
+    {
+        const auto& previous = data->levels[i - 1];
+        Downsample(data->storage.data() + previous.offset, previous.width, previous.height, image.components, filter,
+                   data->storage.data() + data->levels[i].offset);
+    }
+
+    data->pixels = data->storage.data();
+    return data;
+}
@@ -0,0 +1,67 @@
+#ifndef GRAPHICS_MIPGENERATOR_H
+#define GRAPHICS_MIPGENERATOR_H
+
+#include "Material.h"
+
+#include <memory>
+#include <cstdint>
+
+/**
+ * How the pixels are averaged when the level is halved
+ */
+enum class MipFilter : uint32_t
+{
+    /* Channels are averaged as is */
+    Linear = 0,
+    /* Color channels are converted to the linear space before averaging and back after it, alpha is averaged as is */
+    Srgb = 1,
+    /* Pixels are unpacked to vectors, averaged and renormalized, so the normals never get shorter in the distance */
+    Normal = 2
+};
+
+/**
+ * CPU mip chain generator. Levels are produced with a 2x2 box filter, rows are processed with SSE (or AVX, when the
+ * compiler targets it). Never touches OpenGL, so it is safe to use from the worker threads
+ */
+class MipGenerator
+{
+public:
+    /* Restriction to create an instance of this class */
+    MipGenerator() = delete;
+    MipGenerator(MipGenerator&&) = delete;
+    MipGenerator(const MipGenerator&) = delete;
+
+    /**
+     * @param type how texture is sampled by the shaders
+     * @return filter to generate the mips of the texture with
+     */
+    static MipFilter SelectFilter(TextureType type);
+
+    /**
+     * @param width base level width
+     * @param height base level height
+     * @return number of levels in the full mip chain, including the base one
+     */
+    static int GetLevelsCount(int width, int height);
+
+    /**
+     * Halves the image, odd dimensions are rounded down
+     * @param pixels image pixels
+     * @param width image width
+     * @param height image height
+     * @param components number of the components per pixel, 1 to 4
+     * @param filter how pixels are averaged
+     * @param destination output pixels, max(width / 2, 1) x max(height / 2, 1)
+     */
+    static void Downsample(const uint8_t * pixels, int width, int height, int components, MipFilter filter, uint8_t * destination);
+
+    /**
+     * Generates the whole uncompressed mip chain of the image
+     * @param image decoded image
+     * @param filter how pixels are averaged
+     * @return texture data with all the levels, ready to be uploaded
+     */
+    static std::shared_ptr<TextureData> Generate(const ImageData& image, MipFilter filter);
+};
+
+#endif //GRAPHICS_MIPGENERATOR_H
@@ -1,10 +1,13 @@
 //
 // Created by Anton on 19.08.2022.
 //
+#include <chrono>
 #include <iomanip>
 #include <utility>
 #include <filesystem>
 #include "Model.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
 
 
 Model::Model(std::string loadPath) : gammaCorrection(false), path(std::move(loadPath))
@@ -12,7 +15,42 @@ Model::Model(std::string loadPath) : gammaCorrection(false), path(std::move(load
     LoadModel(path);
 }
 
+Model::Model(const ModelData& data) : path(data.path), gammaCorrection(false)
+{
+    Upload(data);
+}
+
+Model::~Model()
+{
+    (residentData ? Profiler::meshCpuMemory : Profiler::meshCpuMemoryDropped) -= cpuDataSize;
+}
+
 void Model::LoadModel(const std::string& loadPath)
+{
+    Upload(* LoadData(loadPath));
+}
+
+std::unique_ptr<ModelData> Model::LoadData(const std::string& loadPath)
+{
+    auto loadStart = std::chrono::high_resolution_clock::now();
+
+    // warm start: mapping the cached binary file, no parsing is required
+    std::unique_ptr<ModelData> data = MeshCache::Load(loadPath);
+    bool isCached = data != nullptr;
+
+    if (!isCached)
+    {
+        data = Import(loadPath);
+        MeshCache::Save(loadPath, * data);
+    }
+
+    LOG(INFO) << "Model " << loadPath << (isCached ? " loaded from the mesh cache (warm) in " : " imported (cold) in ")
+              << std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(std::chrono::high_resolution_clock::now() - loadStart).count() << " ms";
+
+    return data;
+}
+
+std::unique_ptr<ModelData> Model::Import(const std::string& loadPath)
 {
     Assimp::Importer importer;
     const aiScene * scene = importer.ReadFile(loadPath, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
@@ -24,6 +62,7 @@ void Model::LoadModel(const std::string& loadPath)
     }
 
     // retrieve the directory path of the filepath
+    std::string directory;
     if(loadPath.find('/') != std::string::npos)
     {
         directory = loadPath.substr(0, loadPath.find_last_of('/'));
@@ -38,12 +77,102 @@ void Model::LoadModel(const std::string& loadPath)
         directory = fpath.parent_path().string();
     }
 
+    auto data = std::make_unique<ModelData>();
+    data->path = loadPath;
+
+    for(unsigned int i = 0; i < scene->mNumMaterials; i++)
+    {
+        data->materials.push_back(Material::ReadMaterialData(scene->mMaterials[i], directory));
+    }
 
     // process ASSIMP's root node recursively
-    ProcessNode(scene->mRootNode, scene);
+    ProcessNode(* data, scene->mRootNode, scene);
+
+    size_t verticesCount = 0, packedSize = 0;
+    for (const auto& mesh : data->meshes)
+    {
+        verticesCount += mesh.verticesCount;
+        packedSize += mesh.vertices.size();
+    }
+    LOG(INFO) << "Model " << loadPath << ": " << verticesCount << " vertices packed into " << packedSize << " bytes ("
+              << verticesCount * sizeof(Vertex) << " bytes unpacked)";
+
+    return data;
 }
 
-void Model::ProcessNode(aiNode * node, const aiScene * scene)
+void Model::Upload(const ModelData& data)
+{
+    // materials are shared between the meshes, so each of them is only created once
+    std::vector<std::unique_ptr<Material>> materials(data.materials.size());
+
+    for (const auto& meshData : data.meshes)
+    {
+        auto& material = materials.at(meshData.materialIndex);
+        if (!material)
+        {
+            material = std::make_unique<Material>(data.materials.at(meshData.materialIndex), &data.images);
+        }
+        meshes.push_back(std::make_shared<Mesh>(meshData, * material));
+    }
+    bounds = data.bounds;
+
+    for (const auto& meshData : data.meshes)
+    {
+        cpuDataSize += meshData.verticesCount * VertexLayout::GetSize(meshData.vertexFormat) + meshData.indicesCount * VertexLayout::GetIndexSize(meshData.indexFormat);
+    }
+
+    // GPU buffers are the only copy of the geometry unless told otherwise, the rest is read back on demand
+    if (keepCpuData)
+    {
+        auto resident = std::make_shared<ModelData>(data);
+        resident->images.clear();
+        for (auto& meshData : resident->meshes)
+        {
+            if (!meshData.vertices.empty())
+            {
+                meshData.UseOwnedStorage();
+            }
+        }
+        residentData = std::move(resident);
+        loadedData = residentData;
+        Profiler::meshCpuMemory += cpuDataSize;
+    }
+    else
+    {
+        Profiler::meshCpuMemoryDropped += cpuDataSize;
+    }
+
+    size_t lodsCount = 1;
+    for (const auto& mesh : meshes)
+    {
+        lodsCount = std::max(lodsCount, mesh->GetLods().size());
+    }
+
+    // meshes with shorter chains keep drawing their last level
+    lodErrors.assign(lodsCount, 0.0f);
+    for (const auto& mesh : meshes)
+    {
+        for (size_t i = 0; i < lodsCount; i++)
+        {
+            lodErrors[i] = std::max(lodErrors[i], mesh->GetLod(static_cast<int>(i)).error);
+        }
+    }
+}
+
+std::shared_ptr<const ModelData> Model::GetCpuData() const
+{
+    if (auto data = loadedData.lock())
+    {
+        return data;
+    }
+
+    std::shared_ptr<ModelData> data = LoadData(path);
+    data->images.clear();
+    loadedData = data;
+    return data;
+}
+
+void Model::ProcessNode(ModelData& data, aiNode * node, const aiScene * scene)
 {
     // process each mesh located at the current node
     for(unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -51,32 +180,38 @@ void Model::ProcessNode(aiNode * node, const aiScene * scene)
         // the node object only contains indices to index the actual objects in the scene.
         // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
         aiMesh * mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(ProcessMesh(mesh, scene));
+        data.meshes.push_back(ProcessMesh(mesh));
+        data.bounds.Extend(data.meshes.back().bounds);
     }
     // after we've processed all the meshes (if any) we then recursively process each of the children nodes
     for(unsigned int i = 0; i < node->mNumChildren; i++)
     {
-        ProcessNode(node->mChildren[i], scene);
+        ProcessNode(data, node->mChildren[i], scene);
     }
 }
 
-std::shared_ptr<Mesh> Model::ProcessMesh(aiMesh * mesh, const aiScene * scene)
+MeshData Model::ProcessMesh(aiMesh * mesh)
 {
     // data to fill
+    MeshData data;
+    data.name = mesh->mName.C_Str();
+    data.materialIndex = mesh->mMaterialIndex;
+
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
-    std::vector<Texture> textures;
+    vertices.reserve(mesh->mNumVertices);
 
     // walk through each of the mesh's vertices
     for(unsigned int i = 0; i < mesh->mNumVertices; i++)
     {
-        Vertex vertex;
+        Vertex vertex {};
         glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
         // positions
         vector.x = mesh->mVertices[i].x;
         vector.y = mesh->mVertices[i].y;
         vector.z = mesh->mVertices[i].z;
         vertex.Position = vector;
+        data.bounds.Extend(vector);
         // normals
         if (mesh->HasNormals())
         {
@@ -123,6 +258,71 @@ std::shared_ptr<Mesh> Model::ProcessMesh(aiMesh * mesh, const aiScene * scene)
         }
     }
 
-    // return a mesh object created from the extracted mesh data
-    return std::make_shared<Mesh>(vertices, indices, Material(scene->mMaterials[mesh->mMaterialIndex], directory), mesh->mName.C_Str());
+    // bone influences, only the strongest MAX_BONE_INFLUENCE per vertex are kept
+    for (unsigned int boneId = 0; boneId < mesh->mNumBones; boneId++)
+    {
+        const aiBone * bone = mesh->mBones[boneId];
+        for (unsigned int i = 0; i < bone->mNumWeights; i++)
+        {
+            Vertex& vertex = vertices.at(bone->mWeights[i].mVertexId);
+
+            int weakest = 0;
+            for (int slot = 1; slot < MAX_BONE_INFLUENCE; slot++)
+            {
+                weakest = vertex.m_Weights[slot] < vertex.m_Weights[weakest] ? slot : weakest;
+            }
+            if (vertex.m_Weights[weakest] < bone->mWeights[i].mWeight)
+            {
+                vertex.m_BoneIDs[weakest] = static_cast<int>(boneId);
+                vertex.m_Weights[weakest] = bone->mWeights[i].mWeight;
+            }
+        }
+    }
+
+    if (mesh->mNumBones > 256)
+    {
+        LOG(WARNING) << "Mesh " << data.name << " has " << mesh->mNumBones << " bones, only first 256 are addressable";
+    }
+
+    // centered in the box, the sphere is tighter than the box diagonal for the most of the meshes
+    if (data.bounds.IsValid())
+    {
+        data.sphere.center = data.bounds.GetCenter();
+        data.sphere.radius = 0.0f;
+        for (const auto& vertex : vertices)
+        {
+            data.sphere.radius = std::max(data.sphere.radius, glm::length(vertex.Position - data.sphere.center));
+        }
+    }
+
+    const size_t importedVertices = vertices.size();
+    const VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+
+    MeshOptimizer::Optimize(vertices, indices);
+
+    const VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+    LOG(INFO) << "Mesh " << data.name << " optimized: vertices " << importedVertices << " -> " << vertices.size()
+              << ", ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr;
+
+    data.uvDensity = MeshOptimizer::ComputeUvDensity(indices, vertices);
+
+    // clusters reorder the full detail triangles only, so they go before the levels of detail are appended
+    data.clusters = MeshOptimizer::BuildClusters(indices, vertices);
+    LOG(INFO) << "Mesh " << data.name << " split into " << data.clusters.size() << " clusters";
+
+    data.lods = MeshOptimizer::GenerateLods(indices, vertices);
+    for (size_t i = 1; i < data.lods.size(); i++)
+    {
+        LOG(INFO) << "Mesh " << data.name << " LOD" << i << ": " << data.lods[i].indicesCount / 3 << " triangles, error " << data.lods[i].error;
+    }
+
+    // meshes without bones do not pay for the skinning attributes
+    data.vertexFormat = mesh->HasBones() ? VertexFormat::Skinned : VertexFormat::Static;
+    data.vertices = VertexLayout::Pack(vertices.data(), vertices.size(), data.vertexFormat);
+
+    data.indexFormat = VertexLayout::SelectIndexFormat(vertices.size());
+    data.indices = VertexLayout::PackIndices(indices.data(), indices.size(), data.indexFormat);
+
+    data.UseOwnedStorage();
+    return data;
 }
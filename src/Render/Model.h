@@ -21,6 +21,25 @@
 #include <sstream>
 #include <iostream>
 
+class MappedFile;
+
+/**
+ * CPU side model data: everything needed to create the model meshes and materials without touching the source file
+ */
+struct ModelData
+{
+    std::string path;
+    BoundingBox bounds;
+    std::vector<MeshData> meshes;
+    std::vector<MaterialData> materials;
+
+    /* Textures, loaded ahead of time on the worker threads; missing ones are loaded by the texture streamer */
+    ImageMap images;
+
+    /* Mesh cache file the mesh views point into, if model was loaded from the cache */
+    std::shared_ptr<MappedFile> cacheFile;
+};
+
 class Model
 {
 public:
@@ -35,57 +54,193 @@ public:
     explicit Model(std::string  path);
 
     /**
-     * Draws all model meshes to the color buffer
-     * @param model model model (transform) matrix
-     * @param shader shader to apply
-     * @param shadowMap directional light shadow map texture
+     * Creates model from already loaded data. Only OpenGL objects are created here, so it is the part of the model
+     * loading that must run on the main thread
+     * @param data model data
      */
-    void Draw(const std::shared_ptr<Shader> &shader, const glm::mat4& model) const
+    explicit Model(const ModelData& data);
+
+    Model(Model&&) = delete;
+    Model(const Model&) = delete;
+
+    ~Model();
+
+    /**
+     * Records draws of all model meshes with their materials
+     * @param draws draws of the pass
+     * @param drawIndex index of the per draw data of this model instance
+     * @param lod level of detail to draw
+     * @param culling camera in the model space, to cull the meshes clusters; no culling is done if null
+     * @param visibility byte per mesh, meshes with zero are skipped; all meshes are drawn if null
+     * @return number of recorded indices
+     */
+    size_t AddDraws(DrawCommandBuffer& draws, uint32_t drawIndex, int lod = 0, const ClusterCullingData * culling = nullptr, const uint8_t * visibility = nullptr) const
     {
-        shader->setMat4("model", model);
-        shader->setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(model))));
-        for(const auto& mesh : meshes)
+        size_t indices = 0;
+        for(size_t i = 0; i < meshes.size(); i++)
         {
-            mesh->Draw(shader);
+            if (visibility == nullptr || visibility[i] != 0)
+            {
+                indices += draws.AddMesh(* meshes[i], drawIndex, lod, culling);
+            }
         }
+        return indices;
     };
 
     /**
-     * Draws all model meshes to the depth buffer
-     * @param model model model (transform) matrix
-     * @param shader shader to apply
+     * Records depth only draws of all model meshes
+     * @param draws draws of the pass
+     * @param drawIndex index of the per draw data of this model instance
+     * @param usePositionStream if true, meshes position only streams are used instead of the full vertices
+     * @param lod level of detail to draw
+     * @param layerMasks mask per mesh of the layers to draw it into; all meshes are drawn into the first layer if null
+     * @return number of recorded indices
      */
-    void DrawIntoDepth(const Shader& shader, const glm::mat4& model) const
+    size_t AddDepthDraws(DrawCommandBuffer& draws, uint32_t drawIndex, bool usePositionStream = true, int lod = 0, const uint32_t * layerMasks = nullptr) const
     {
-        shader.setMat4("model", model);
-        for(const auto& mesh : meshes)
+        size_t indices = 0;
+        for(size_t i = 0; i < meshes.size(); i++)
         {
-            mesh->DrawIntoDepth();
+            indices += draws.AddDepthMesh(* meshes[i], drawIndex, lod, usePositionStream, layerMasks != nullptr ? layerMasks[i] : 1);
         }
+        return indices;
     };
 
+    /**
+     * Requests resolution of the meshes textures, at which a texel covers a single pixel on the screen
+     * @param pixelsPerUnit screen pixels per model space unit
+     * @param tilingFactor how many times textures are repeated
+     */
+    void RequestTextureResolution(float pixelsPerUnit, int tilingFactor) const
+    {
+        for (const auto& mesh : meshes)
+        {
+            // meshes without texture coordinates sample a single texel
+            const float uvDensity = mesh->GetUvDensity() * static_cast<float>(std::max(tilingFactor, 1));
+            mesh->material.RequestTextureResolution(uvDensity > 0.0f ? pixelsPerUnit / uvDensity : 1.0f);
+        }
+    }
+
+    /**
+     * @return number of the model levels of detail
+     */
+    [[nodiscard]] inline int GetLodsCount() const { return static_cast<int>(lodErrors.size()); }
+
+    /**
+     * Selects the coarsest level of detail, which error stays within the threshold on the screen
+     * @param errorToPixels model space error to the screen pixels scale
+     * @param pixelThreshold maximum allowed error, in pixels
+     * @return level of detail
+     */
+    [[nodiscard]] int SelectLod(float errorToPixels, float pixelThreshold) const
+    {
+        int lod = 0;
+        while (lod + 1 < GetLodsCount() && lodErrors[lod + 1] * errorToPixels <= pixelThreshold)
+        {
+            lod++;
+        }
+        return lod;
+    }
+
+    /**
+     * @param lod level of detail
+     * @return triangles count of the whole model at the given level of detail
+     */
+    [[nodiscard]] size_t GetTrianglesCount(int lod = 0) const
+    {
+        size_t triangles = 0;
+        for (const auto& mesh : meshes)
+        {
+            triangles += mesh->GetTrianglesCount(lod);
+        }
+        return triangles;
+    }
+
     void LoadModel() { LoadModel(path); }
 
+    /**
+     * @return model bounding box, in model space
+     */
+    [[nodiscard]] inline const BoundingBox& GetBounds() const { return bounds; }
+
+    /**
+     * @return size of all model meshes buffers, in bytes
+     */
+    [[nodiscard]] size_t GetMemoryUsage() const
+    {
+        size_t memory = 0;
+        for (const auto& mesh : meshes)
+        {
+            memory += mesh->GetMemoryUsage();
+        }
+        return memory;
+    }
+
+    /**
+     * Returns CPU side vertices and indices of the model. Resident copy is returned if it is kept, otherwise data is read
+     * back from the mesh cache (or the source file) and shared between the callers while any of them holds it
+     * @return model data, without decoded images
+     */
+    [[nodiscard]] std::shared_ptr<const ModelData> GetCpuData() const;
+
+    /**
+     * @return true if CPU side vertices and indices are kept in memory after the upload
+     */
+    [[nodiscard]] inline bool IsCpuDataResident() const { return residentData != nullptr; }
+
+    /**
+     * @return size of the CPU side vertices and indices, both resident and dropped ones, in bytes
+     */
+    [[nodiscard]] inline size_t GetCpuDataSize() const { return cpuDataSize; }
+
+    /**
+     * Sets whether models keep CPU side copies of their vertices and indices after the upload. Dropping them roughly
+     * halves geometry memory, at the cost of reading them back from disk when they are needed
+     * @param keep true to keep the copies
+     */
+    static void SetKeepCpuData(bool keep) { keepCpuData = keep; }
+
+    /**
+     * Reads model file with assimp, without creating any OpenGL objects
+     * @param path path to the model
+     * @return imported model data
+     */
+    static std::unique_ptr<ModelData> Import(const std::string& path);
+
+    /**
+     * Loads model data either from the mesh cache or from the source file, writing the cache in the latter case.
+     * Does not touch OpenGL, so it is safe to call from the worker threads
+     * @param path path to the model
+     * @return model data
+     */
+    static std::unique_ptr<ModelData> LoadData(const std::string& path);
+
 private:
     /**
-     * Loads model
+     * Loads model, either from the mesh cache or from the source file
      * @param path path to the model
      */
     void LoadModel(std::string const &path);
 
+    /**
+     * Creates meshes and materials from the CPU side model data
+     * @param data model data
+     */
+    void Upload(const ModelData& data);
+
     /**
      * Recursively checks all sub nodes
+     * @param data model data to fill
      * @param node current node
      * @param scene current scene
      */
-    void ProcessNode(aiNode *node, const aiScene *scene);
+    static void ProcessNode(ModelData& data, aiNode *node, const aiScene *scene);
     /**
-     * Precedes mesh into given scene
+     * Reads mesh from the given scene
      * @param mesh current mesh
-     * @param scene current scene
-     * @return new Mesh new loaded mesh
+     * @return mesh data
      */
-    std::shared_ptr<Mesh> ProcessMesh(aiMesh *mesh, const aiScene *scene);
+    static MeshData ProcessMesh(aiMesh *mesh);
 
 public:
     std::string path;
@@ -93,6 +248,16 @@ public:
 
 private:
     bool gammaCorrection;
-    std::string directory;
+    BoundingBox bounds;
+
+    /* Error of each level of detail, the largest one among the meshes */
+    std::vector<float> lodErrors { 0.0f };
+
+    /* CPU side geometry: kept copy, or the one read back on demand, alive while any caller holds it */
+    std::shared_ptr<const ModelData> residentData;
+    mutable std::weak_ptr<const ModelData> loadedData;
+    size_t cpuDataSize = 0;
+
+    inline static bool keepCpuData = false;
 };
 #endif
@@ -0,0 +1,84 @@
+#include "ModelCache.h"
+
+#include <algorithm>
+
+std::shared_ptr<Model> ModelCache::Get(const std::string& path)
+{
+    auto it = models.find(path);
+    if (it != models.end())
+    {
+        it->second.lastUsed = ++usageCounter;
+        return it->second.model;
+    }
+    return Store(path, std::make_shared<Model>(path));
+}
+
+std::shared_ptr<Model> ModelCache::Get(const ModelData& data)
+{
+    auto it = models.find(data.path);
+    if (it != models.end())
+    {
+        it->second.lastUsed = ++usageCounter;
+        return it->second.model;
+    }
+    return Store(data.path, std::make_shared<Model>(data));
+}
+
+std::shared_ptr<Model> ModelCache::Reload(const std::string& path)
+{
+    return Store(path, std::make_shared<Model>(path));
+}
+
+std::shared_ptr<Model>& ModelCache::Store(const std::string& path, std::shared_ptr<Model> model)
+{
+    auto& entry = models[path];
+    entry.model = std::move(model);
+    entry.lastUsed = ++usageCounter;
+    return entry.model;
+}
+
+void ModelCache::Trim()
+{
+    // only the cache itself references these models
+    std::vector<std::pair<uint64_t, std::string>> unreferenced;
+    size_t unreferencedMemory = 0;
+    for (const auto& [path, entry] : models)
+    {
+        if (entry.model.use_count() == 1)
+        {
+            unreferenced.emplace_back(entry.lastUsed, path);
+            unreferencedMemory += entry.model->GetMemoryUsage();
+        }
+    }
+
+    std::sort(unreferenced.begin(), unreferenced.end());
+
+    for (const auto& [lastUsed, path] : unreferenced)
+    {
+        if (unreferencedMemory <= budget)
+        {
+            break;
+        }
+
+        size_t memory = models.at(path).model->GetMemoryUsage();
+        unreferencedMemory -= memory;
+        models.erase(path);
+
+        LOG(INFO) << "Model " << path << " evicted from the model cache, releasing " << memory << " bytes";
+    }
+}
+
+void ModelCache::Clear()
+{
+    models.clear();
+}
+
+size_t ModelCache::GetMemoryUsage()
+{
+    size_t memory = 0;
+    for (const auto& [path, entry] : models)
+    {
+        memory += entry.model->GetMemoryUsage();
+    }
+    return memory;
+}
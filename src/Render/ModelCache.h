@@ -0,0 +1,97 @@
+#ifndef GRAPHICS_MODELCACHE_H
+#define GRAPHICS_MODELCACHE_H
+
+#include "Model.h"
+
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+/**
+ * Shared models storage. Every model path is loaded once, all components referencing the same path share its meshes
+ * and GPU buffers. Models, no longer referenced by any component, are kept in memory while they fit into the budget,
+ * so switching between the scenes, which share assets, does not reload them; least recently used ones are evicted first
+ */
+class ModelCache
+{
+public:
+    /* Restriction to create an instance of this class */
+    ModelCache() = delete;
+    ModelCache(ModelCache&&) = delete;
+    ModelCache(const ModelCache&) = delete;
+
+    /**
+     * Returns shared model, loading it if it is not in the cache yet
+     * @param path path to the model
+     * @return shared model
+     */
+    static std::shared_ptr<Model> Get(const std::string& path);
+
+    /**
+     * Returns shared model, creating it from the already loaded data if it is not in the cache yet
+     * @param data model data
+     * @return shared model
+     */
+    static std::shared_ptr<Model> Get(const ModelData& data);
+
+    /**
+     * Loads model once again, replacing the cached one. Components, holding the old model, keep using it
+     * @param path path to the model
+     * @return freshly loaded model
+     */
+    static std::shared_ptr<Model> Reload(const std::string& path);
+
+    /**
+     * @param path path to the model
+     * @return true if model is cached
+     */
+    static bool Contains(const std::string& path) { return models.find(path) != models.end(); }
+
+    /**
+     * Evicts least recently used unreferenced models until the rest of them fits into the budget
+     */
+    static void Trim();
+
+    /**
+     * Releases all cached models, must be called before the OpenGL context is destroyed
+     */
+    static void Clear();
+
+    /**
+     * Sets memory budget for the unreferenced models
+     * @param bytes budget, in bytes
+     */
+    static void SetBudget(size_t bytes) { budget = bytes; }
+
+    /**
+     * @return number of cached models, both referenced and unreferenced
+     */
+    static size_t GetModelsCount() { return models.size(); }
+
+    /**
+     * @return GPU memory, taken by all cached models, in bytes
+     */
+    static size_t GetMemoryUsage();
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<Model> model;
+        uint64_t lastUsed = 0;
+    };
+
+    /**
+     * Puts model into the cache and marks it as used
+     * @param path path to the model
+     * @param model model to store
+     * @return stored model
+     */
+    static std::shared_ptr<Model>& Store(const std::string& path, std::shared_ptr<Model> model);
+
+    inline static uint64_t usageCounter = 0;
+    inline static size_t budget = 256 * 1024 * 1024;
+    inline static std::unordered_map<std::string, Entry> models;
+};
+
+#endif //GRAPHICS_MODELCACHE_H
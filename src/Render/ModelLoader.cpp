@@ -0,0 +1,102 @@
+#include "ModelLoader.h"
+#include "TextureRegistry.h"
+#include "../Core/ThreadPool.hpp"
+
+#include <chrono>
+
+ModelLoader::ModelLoader()
+{
+    for (const auto& [path, texture] : TextureRegistry::GetTextures())
+    {
+        loadedTextures.insert(texture->GetPath());
+    }
+}
+
+ModelLoader::~ModelLoader()
+{
+    for (const auto& [path, future] : models)
+    {
+        future.wait();
+    }
+}
+
+void ModelLoader::Request(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(m);
+    if (models.find(path) != models.end())
+    {
+        return;
+    }
+
+    models[path] = ThreadPool::Submit([this, path]() -> std::shared_ptr<const ModelData>
+    {
+        std::shared_ptr<ModelData> data = Model::LoadData(path);
+
+        for (const auto& material : data->materials)
+        {
+            for (const auto& texture : material.textures)
+            {
+                const std::string& texturePath = texture.second;
+                if (loadedTextures.find(texturePath) == loadedTextures.end() && data->images.find(texturePath) == data->images.end())
+                {
+                    data->images[texturePath] = LoadTexture(texturePath, texture.first);
+                }
+            }
+        }
+        return data;
+    }).share();
+}
+
+std::shared_ptr<const ModelData> ModelLoader::Get(const std::string& path)
+{
+    Request(path);
+
+    std::shared_future<std::shared_ptr<const ModelData>> future;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        future = models.at(path);
+    }
+    return future.get();
+}
+
+std::shared_ptr<TextureData> ModelLoader::LoadTexture(const std::string& path, TextureType usage)
+{
+    std::promise<std::shared_ptr<TextureData>> promise;
+    std::shared_future<std::shared_ptr<TextureData>> loaded;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        auto it = images.find(path);
+        if (it != images.end())
+        {
+            loaded = it->second;
+        }
+        else
+        {
+            images[path] = promise.get_future().share();
+        }
+    }
+
+    // texture is shared with the model, already being loaded by another worker
+    if (loaded.valid())
+    {
+        return loaded.get();
+    }
+
+    auto loadStart = std::chrono::high_resolution_clock::now();
+
+    std::shared_ptr<TextureData> data = nullptr;
+    try
+    {
+        data = Texture::LoadData(path, usage);
+        LOG(INFO) << "Texture " << path << " loaded in "
+                  << std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(std::chrono::high_resolution_clock::now() - loadStart).count() << " ms";
+    }
+    catch (const std::exception& e)
+    {
+        // failed texture is loaded once again by the texture streamer, which keeps the placeholder if it fails again
+        LOG(WARNING) << "Failed to load texture " << path << " on the worker thread. Reason: " << e.what();
+    }
+
+    promise.set_value(data);
+    return data;
+}
@@ -0,0 +1,65 @@
+#ifndef GRAPHICS_MODELLOADER_H
+#define GRAPHICS_MODELLOADER_H
+
+#include "Model.h"
+
+#include <mutex>
+#include <future>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+
+/**
+ * Loads models in parallel on the thread pool. Workers read the mesh cache (or import the model with assimp) and
+ * load all textures (from the texture cache, or decoding and compressing them), each unique texture only once; the
+ * main thread then only creates OpenGL objects
+ */
+class ModelLoader
+{
+public:
+    /**
+     * Creates loader. Must be created on the main thread, as it takes a snapshot of the already loaded textures
+     */
+    ModelLoader();
+
+    /**
+     * Waits for all queued models, as workers reference the loader
+     */
+    ~ModelLoader();
+
+    ModelLoader(ModelLoader&&) = delete;
+    ModelLoader(const ModelLoader&) = delete;
+
+    /**
+     * Queues model loading, repeated requests of the same path are ignored
+     * @param path path to the model
+     */
+    void Request(const std::string& path);
+
+    /**
+     * Waits for the model data to be loaded. Requests the model first if it was not requested before
+     * @param path path to the model
+     * @return loaded model data, rethrows loading exceptions
+     */
+    std::shared_ptr<const ModelData> Get(const std::string& path);
+
+private:
+    /**
+     * Loads texture data, or waits for it to be loaded by another worker
+     * @param path texture path
+     * @param usage how texture is sampled by the shaders
+     * @return texture data, or nullptr if loading failed
+     */
+    std::shared_ptr<TextureData> LoadTexture(const std::string& path, TextureType usage);
+
+private:
+    std::mutex m;
+
+    /* Textures, that already exist on GPU and must not be loaded again */
+    std::unordered_set<std::string> loadedTextures;
+
+    std::unordered_map<std::string, std::shared_future<std::shared_ptr<const ModelData>>> models;
+    std::unordered_map<std::string, std::shared_future<std::shared_ptr<TextureData>>> images;
+};
+
+#endif //GRAPHICS_MODELLOADER_H
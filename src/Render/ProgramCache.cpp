@@ -0,0 +1,161 @@
+#define GLEW_STATIC
+#include "glew.h"
+
+#include "ProgramCache.h"
+#include "../Core/Hash.hpp"
+#include "../Core/CacheFile.h"
+#include "../Logging/easylogging++.h"
+
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+namespace
+{
+    constexpr char cacheMagic[4] = { 'O', 'G', 'P', 'C' };
+
+    struct ProgramCacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+
+        uint64_t sourceHash;
+        uint64_t driverHash;
+
+        uint32_t binaryFormat;
+        uint32_t binarySize;
+    };
+
+    std::string GetString(GLenum name)
+    {
+        const auto * value = reinterpret_cast<const char *>(glGetString(name));
+        return value == nullptr ? "" : value;
+    }
+}
+
+bool ProgramCache::IsSupported()
+{
+    GLint formatsCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatsCount);
+    return formatsCount > 0;
+}
+
+uint64_t ProgramCache::GetDriverHash()
+{
+    // binaries produced by one driver are never valid for the other ones
+    const std::string driver = GetString(GL_VENDOR) + '\n' + GetString(GL_RENDERER) + '\n' + GetString(GL_VERSION);
+    return Hash::Fnv1a(driver);
+}
+
+std::string ProgramCache::GetCachePath(uint64_t sourceHash)
+{
+    return (std::filesystem::path(cacheDirectory) / (Hash::ToHex(sourceHash) + ".bin")).string();
+}
+
+bool ProgramCache::Load(unsigned int program, uint64_t sourceHash)
+{
+    if (!isEnabled || !IsSupported())
+    {
+        missesCount++;
+        return false;
+    }
+
+    const std::string cachePath = GetCachePath(sourceHash);
+    std::ifstream is(cachePath, std::ios::binary);
+    if (!is.is_open())
+    {
+        missesCount++;
+        return false;
+    }
+
+    ProgramCacheHeader header {};
+    is.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!is || std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != version ||
+        header.sourceHash != sourceHash || header.driverHash != GetDriverHash())
+    {
+        LOG(INFO) << "Program cache " << cachePath << " is outdated";
+        missesCount++;
+        return false;
+    }
+
+    // format has to be one of the currently supported ones, otherwise glProgramBinary raises an error
+    GLint formatsCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatsCount);
+    std::vector<GLint> formats(static_cast<size_t>(formatsCount));
+    glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+    if (std::find(formats.begin(), formats.end(), static_cast<GLint>(header.binaryFormat)) == formats.end())
+    {
+        LOG(INFO) << "Program cache " << cachePath << " has an unsupported binary format";
+        missesCount++;
+        return false;
+    }
+
+    std::vector<char> binary(header.binarySize);
+    is.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+    if (!is)
+    {
+        LOG(WARNING) << "Program cache " << cachePath << " is corrupted";
+        missesCount++;
+        return false;
+    }
+
+    glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    GLint isLinked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+    if (isLinked != GL_TRUE)
+    {
+        LOG(INFO) << "Program cache " << cachePath << " was rejected by the driver";
+        missesCount++;
+        return false;
+    }
+
+    hitsCount++;
+    return true;
+}
+
+void ProgramCache::Save(unsigned int program, uint64_t sourceHash)
+{
+    if (!isEnabled || !IsSupported())
+    {
+        return;
+    }
+
+    GLint binarySize = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    if (binarySize <= 0)
+    {
+        LOG(WARNING) << "Failed to cache program. Reason: driver returned no binary";
+        return;
+    }
+
+    std::vector<char> binary(static_cast<size_t>(binarySize));
+    GLenum binaryFormat = 0;
+    GLsizei length = 0;
+    glGetProgramBinary(program, binarySize, &length, &binaryFormat, binary.data());
+
+    ProgramCacheHeader header {};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = version;
+    header.sourceHash = sourceHash;
+    header.driverHash = GetDriverHash();
+    header.binaryFormat = binaryFormat;
+    header.binarySize = static_cast<uint32_t>(length);
+
+    const std::string cachePath = GetCachePath(sourceHash);
+    const bool isWritten = CacheFile::Write(cachePath, [&](std::ostream& os)
+    {
+        os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        os.write(binary.data(), length);
+    });
+
+    if (!isWritten)
+    {
+        LOG(WARNING) << "Failed to write program cache " << cachePath;
+        return;
+    }
+
+    LOG(INFO) << "Program cache written to " << cachePath;
+}
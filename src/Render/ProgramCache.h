@@ -0,0 +1,89 @@
+#ifndef GRAPHICS_PROGRAMCACHE_H
+#define GRAPHICS_PROGRAMCACHE_H
+
+#include <string>
+#include <cstdint>
+
+/**
+ * Binary cache of the linked shader programs. Every program is written, as returned by glGetProgramBinary, into a
+ * versioned binary file named after the hash of its final sources, so the programs are loaded on the next launches
+ * without compiling and linking.
+ *
+ * File layout:
+ *  - ProgramCacheHeader
+ *  - ProgramCacheHeader::binarySize bytes of the program binary
+ *
+ * Binaries are only valid for the driver, which produced them, so the cache is invalidated by the format version, the
+ * source hash and the hash of the driver vendor, renderer and version strings. Drivers may still reject the binary,
+ * e.g. after an update which did not change the version string, programs are compiled from the sources then
+ */
+class ProgramCache
+{
+public:
+    /* Restriction to create an instance of this class */
+    ProgramCache() = delete;
+    ProgramCache(ProgramCache&&) = delete;
+    ProgramCache(const ProgramCache&) = delete;
+
+    /**
+     * Loads the program binary into the program
+     * @param program program object, nothing attached to it yet
+     * @param sourceHash hash of the program final sources
+     * @return true if the binary was loaded and accepted by the driver, false if program has to be compiled
+     */
+    static bool Load(unsigned int program, uint64_t sourceHash);
+
+    /**
+     * Writes the binary of the linked program into the cache. Failures are logged, but never thrown
+     * @param program linked program, created with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+     * @param sourceHash hash of the program final sources
+     */
+    static void Save(unsigned int program, uint64_t sourceHash);
+
+    /**
+     * Sets directory, where cache files are stored
+     * @param directory cache directory
+     */
+    static void SetCacheDirectory(const std::string& directory) { cacheDirectory = directory; }
+
+    /**
+     * @param enabled if false, programs are always compiled from the sources and never written to the cache
+     */
+    static void SetEnabled(bool enabled) { isEnabled = enabled; }
+
+    /**
+     * @return number of the programs loaded from the cache since the launch
+     */
+    static size_t GetHitsCount() { return hitsCount; }
+
+    /**
+     * @return number of the programs, which had to be compiled since the launch
+     */
+    static size_t GetMissesCount() { return missesCount; }
+
+    /* Format version, must be incremented each time the layout changes */
+    static constexpr uint32_t version = 1;
+
+private:
+    /**
+     * @return true if the driver supports at least a single program binary format
+     */
+    static bool IsSupported();
+
+    /**
+     * @return hash of the driver vendor, renderer and version strings
+     */
+    static uint64_t GetDriverHash();
+
+    /**
+     * @param sourceHash hash of the program final sources
+     * @return path to the cache file of the program
+     */
+    static std::string GetCachePath(uint64_t sourceHash);
+
+    inline static std::string cacheDirectory = "../res/cache/programs";
+    inline static bool isEnabled = true;
+    inline static size_t hitsCount = 0, missesCount = 0;
+};
+
+#endif //GRAPHICS_PROGRAMCACHE_H
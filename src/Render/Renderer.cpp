@@ -4,9 +4,59 @@
 
 #include "UBO.hpp"
 #include "Renderer.h"
+#include "TextureStreamer.h"
+#include "TextureRegistry.h"
+#include "MaterialTable.h"
 #include "RendererIniSerializer.hpp"
 #include "../Core/Profiler.hpp"
 
+#include <limits>
+#include <algorithm>
+
+/* Names of the uniforms, set by the renderer every frame, hashed at compile time */
+namespace Uniforms
+{
+    constexpr UniformId view("view");
+    constexpr UniformId projection("projection");
+    constexpr UniformId skybox("skybox");
+    constexpr UniformId projPos("ProjPos");
+    constexpr UniformId dLightMapShadow("dLight.mapShadow");
+    constexpr UniformId farPlane("farPlane");
+    constexpr UniformId cascadeCount("cascadeCount");
+    constexpr UniformId cascadePlaneDistances("cascadePlaneDistances");
+    constexpr UniformId pointLightsCount("pointLightsCount");
+    constexpr UniformId gPosition("gPosition");
+    constexpr UniformId gNormal("gNormal");
+    constexpr UniformId gAlbedoSpec("gAlbedoSpec");
+    constexpr UniformId gMetallic("gMetallic");
+    constexpr UniformId gRoughness("gRoughness");
+    constexpr UniformId layer("layer");
+}
+
+/* Keywords of the shader variants, selected by the renderer */
+namespace Keywords
+{
+    constexpr ShaderKeyword directionalLight("DIRECTIONAL_LIGHT");
+    constexpr ShaderKeyword shadows("SHADOWS");
+    constexpr ShaderKeyword layerPerPass("LAYER_PER_PASS");
+
+    /* Debug views by the draw mode, starting from the "Lighting only" one */
+    constexpr ShaderKeyword debugViews[] =
+    {
+        ShaderKeyword("DEBUG_LIGHTING"), ShaderKeyword("DEBUG_DIRECTIONAL_LIGHTING"), ShaderKeyword("DEBUG_POINT_LIGHTING"),
+        ShaderKeyword("DEBUG_DIFFUSE"), ShaderKeyword("DEBUG_NORMALS"), ShaderKeyword("DEBUG_SPECULAR"),
+        ShaderKeyword("DEBUG_SHADOWS"), ShaderKeyword("DEBUG_ROUGHNESS")
+    };
+    constexpr int firstDebugViewMode = 2;
+
+    /* Material maps by the texture type */
+    constexpr ShaderKeyword materialMaps[MATERIAL_TEXTURES_COUNT] =
+    {
+        ShaderKeyword("DIFFUSE_MAP"), ShaderKeyword("NORMAL_MAP"), ShaderKeyword("SPECULAR_MAP"),
+        ShaderKeyword("METALLIC_MAP"), ShaderKeyword("ROUGHNESS_MAP")
+    };
+}
+
 
 constexpr float quadVertices[] = {
         // positions   // texCoords
@@ -22,6 +72,33 @@ void Renderer::Initialize()
     lightMatricesUBO = std::make_unique<UBO<glm::mat4x4, 16>>();
     pointLightsUBO = std::make_unique<UBO<PointLight, 1024>>(1);
 
+    // cascades are selected by the vertex shader, if it can write gl_Layer
+    isVertexLayerSupported = GLEW_ARB_shader_viewport_layer_array || GLEW_AMD_vertex_shader_layer;
+    if (!isVertexLayerSupported)
+    {
+        LOG(WARNING) << "Vertex shader layer output is not supported, shadow cascades are drawn one by one";
+    }
+
+    gPassDraws = std::make_unique<DrawCommandBuffer>();
+    shadowPassDraws = std::make_unique<DrawCommandBuffer>();
+
+    // compute culling needs the draw counts, written by the GPU, to be read by the draw calls
+    if (GpuCuller::IsSupported())
+    {
+        try
+        {
+            gpuCuller = std::make_unique<GpuCuller>();
+        }
+        catch (const EngineException& e)
+        {
+            LOG(WARNING) << "GPU culling is disabled. Reason: " << e.what();
+        }
+    }
+    else
+    {
+        LOG(WARNING) << "Indirect draw counts are not supported, GPU culling is disabled";
+    }
+
     viewportFBO    = std::make_unique<FBO>();
     postProcessFBO = std::make_unique<FBO>();
 
@@ -155,15 +232,20 @@ void Renderer::Initialize()
 void Renderer::ShutDown()
 {
     RendererIniSerializer::SerializeRendererSettings();
+
+    gPassDraws = nullptr;
+    shadowPassDraws = nullptr;
+    gpuCuller = nullptr;
 }
 
 void Renderer::Prepare(Scene &scene)
 {
     Clear(glm::vec3(0, 0, 0));
 
+    TextureStreamer::Update(static_cast<size_t>(std::max(textureUploadBudget, 1)) * 1024);
+    TextureRegistry::Update(static_cast<size_t>(std::max(textureMemoryBudget, 1)) * 1024 * 1024);
+
     std::shared_ptr<Shader>& sShader = ResourcesManager::GetShader("skyboxShader");
-    std::shared_ptr<Shader>& gShader = ResourcesManager::GetShader("gBufferShader");
-    std::shared_ptr<Shader>& lShader = ResourcesManager::GetShader("lBufferShader");
 
     auto primaryCamera = scene.GetPrimaryCamera();
 
@@ -179,42 +261,51 @@ void Renderer::Prepare(Scene &scene)
     cameraComponent.UpdateCamera(cameraTransform.rotation);
     const auto cameraView = cameraComponent.GetCameraView(cameraTransform.translation);
 
-    gShader->Use();
-    gShader->setMat4("view", cameraView);
-    gShader->setMat4("projection", cameraComponent.GetCameraInfiniteProjection());
+    // pixels per model space unit at the unit distance
+    cameraPosition = cameraTransform.translation;
+    lodPixelsScale = static_cast<float>(fboHeight) / (2.0f * std::tan(camera.GetFieldOfView() * 0.5f));
+    cameraViewProjection = cameraComponent.GetCameraInfiniteProjection() * cameraView;
 
-    sShader->Use();
-    sShader->setMat4("view", glm::mat4(glm::mat3(cameraView)));
-    sShader->setMat4("projection", cameraComponent.GetCameraInfiniteProjection());
-    sShader->setInt("skybox", 0);
+    // G-buffer shader variants are selected per material, they get the camera once bound
+    cameraViewMatrix = cameraView;
+    cameraProjection = cameraComponent.GetCameraInfiniteProjection();
 
-    lShader->Use();
-    lShader->setInt("drawMode", drawMode);
-    lShader->setMat4("view", cameraView);
-    lShader->setVec3("ProjPos", cameraTransform.translation);
+    sShader->Use();
+    sShader->setMat4(Uniforms::view, glm::mat4(glm::mat3(cameraView)));
+    sShader->setMat4(Uniforms::projection, cameraComponent.GetCameraInfiniteProjection());
+    sShader->setInt(Uniforms::skybox, 0);
 
     auto sceneDirLight = scene.GetDirectionalLight();
 
+    // the view is selected at compile time, so the lit frames never branch on it
+    lightingKeywords = ShaderKeywords {};
+    lightingKeywords.Enable(Keywords::directionalLight, sceneDirLight != nullptr);
+    lightingKeywords.Enable(Keywords::shadows, sceneDirLight != nullptr && areShadowsEnabled);
+    if (drawMode >= Keywords::firstDebugViewMode && drawMode < Keywords::firstDebugViewMode + static_cast<int>(std::size(Keywords::debugViews)))
+    {
+        lightingKeywords.Enable(Keywords::debugViews[drawMode - Keywords::firstDebugViewMode]);
+    }
+
+    auto& lShader = ResourcesManager::GetShader("lBufferShader")->GetVariant(lightingKeywords);
+    lShader.Use();
+    lShader.setMat4(Uniforms::view, cameraView);
+    lShader.setVec3(Uniforms::projPos, cameraTransform.translation);
+
     if(sceneDirLight)
     {
         const auto& dLight = sceneDirLight->GetComponent<DirectionalLightComponent>().directionalLight;
         const auto& dlRotation = scene.GetDirectionalLight()->GetComponent<TransformComponent>().rotation;
 
-        auto lightMatrices = getLightSpaceMatrices(camera.GetNearPlane(), camera.GetFarPlane(), camera.GetFieldOfView(), camera.GetAspectRatioFloat(), DirectionalLight::GetDirection(dlRotation), cameraView, cascadeLevels);
+        lightSpaceMatrices = getLightSpaceMatrices(camera.GetNearPlane(), camera.GetFarPlane(), camera.GetFieldOfView(), camera.GetAspectRatioFloat(), DirectionalLight::GetDirection(dlRotation), cameraView, cascadeLevels);
 
-        lShader->setBool("dLight.isPresent", true);
-        lShader->setDirLight(dLight, dlRotation);
+        lShader.setDirLight(dLight, dlRotation);
 
-        lShader->setFloat("farPlane", camera.GetFarPlane());
-        lShader->setInt("cascadeCount", (int) cascadeLevels.size());
-
-        for (size_t i = 0; i < cascadeLevels.size(); ++i)
-        {
-            lShader->setFloat("cascadePlaneDistances[" + std::to_string(i) + "]", cascadeLevels[i]);
-        }
+        lShader.setFloat(Uniforms::farPlane, camera.GetFarPlane());
+        lShader.setInt(Uniforms::cascadeCount, (int) cascadeLevels.size());
+        lShader.setFloatArray(Uniforms::cascadePlaneDistances, cascadeLevels.data(), cascadeLevels.size());
 
         lightMatricesUBO->Bind();
-        lightMatricesUBO->FillData(lightMatrices);
+        lightMatricesUBO->FillData(lightSpaceMatrices);
         lightMatricesUBO->Reset();
     }
 
@@ -224,9 +315,9 @@ void Renderer::Prepare(Scene &scene)
     {
         idx++;
         auto [t, p] = view.get<TransformComponent, PointLightComponent>(entity);
-        lShader->setPointLight(idx, p.pointLight, t.translation);
+        lShader.setPointLight(idx, p.pointLight, t.translation);
     }
-    lShader->setInt("pointLightsCount", idx + 1);
+    lShader.setInt(Uniforms::pointLightsCount, idx + 1);
 }
 
 void Renderer::Render(Scene &scene)
@@ -242,13 +333,20 @@ void Renderer::Render(Scene &scene)
     }
 
     Profiler::StartGPass();
+    if (IsGpuCullingActive())
+    {
+        CullOnGpu(scene);
+    }
     GeometryPass(scene);
     Profiler::EndGPass();
 
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
     Profiler::StartSPass();
-    RenderShadowMaps(scene);
+    if (areShadowsEnabled && scene.GetDirectionalLight())
+    {
+        RenderShadowMaps(scene);
+    }
     Profiler::EndSPass();
 
     Profiler::StartLPass();
@@ -275,7 +373,6 @@ void Renderer::Render(Scene &scene)
 
 void Renderer::GeometryPass(Scene &scene)
 {
-    const auto& view = scene.registry.view<TransformComponent, Model3DComponent>();
     auto& shader = ResourcesManager::GetShader("gBufferShader");
     auto& sShader = ResourcesManager::GetShader("skyboxShader");
 
@@ -284,15 +381,31 @@ void Renderer::GeometryPass(Scene &scene)
 
     glViewport(0, 0, static_cast<int>(fboWidth), static_cast<int>(fboHeight));
 
-    shader->Use();
-
-    for (const auto& entity : view)
+    // materials are drawn with the variants sampling only their resident maps
+    const auto bindVariant = [&shader](uint32_t textureMask)
     {
-        auto [t, m] = view.get<TransformComponent, Model3DComponent>(entity);
+        ShaderKeywords keywords;
+        for (size_t i = 0; i < MATERIAL_TEXTURES_COUNT; i++)
+        {
+            keywords.Enable(Keywords::materialMaps[i], (textureMask & (1u << i)) != 0);
+        }
 
-        shader->setInt("material.tilingFactor", m.tilingFactor);
-        shader->setBool("material.shouldBeLit", m.shouldBeLit);
-        m.model.Draw(shader, t.GetTransform());
+        const auto& variant = shader->GetVariant(keywords);
+        variant.Use();
+        variant.setMat4(Uniforms::view, cameraViewMatrix);
+        variant.setMat4(Uniforms::projection, cameraProjection);
+    };
+
+    if (IsGpuCullingActive())
+    {
+        // draws were written by the compute shader, materials were updated along with the instances
+        Profiler::gPassDrawCalls = gpuCuller->SubmitGeometry(bindVariant);
+    }
+    else
+    {
+        RecordGeometryDraws(scene);
+        MaterialTable::Update();
+        Profiler::gPassDrawCalls = gPassDraws->Submit(useMultiDrawIndirect, isInstancingEnabled, bindVariant);
     }
 
     sShader->Use();
@@ -304,6 +417,60 @@ void Renderer::GeometryPass(Scene &scene)
     }
 }
 
+void Renderer::RecordGeometryDraws(Scene &scene)
+{
+    const auto& view = scene.registry.view<TransformComponent, Model3DComponent>();
+
+    gPassDraws->Clear();
+    gPassDraws->SetViewPoint(cameraPosition);
+
+    // world bounds of all the meshes are tested at once, so only the visible ones reach the draw loop
+    gPassCuller.Clear();
+    for (const auto& entity : view)
+    {
+        auto [t, m] = view.get<TransformComponent, Model3DComponent>(entity);
+        m.UpdateWorldBounds(t.GetTransform());
+        for (size_t i = 0; i < m.worldBoxes.size(); i++)
+        {
+            gPassCuller.Add(m.worldBoxes[i], m.worldSpheres[i]);
+        }
+    }
+    Profiler::visibleMeshes = gPassCuller.Cull(Frustum(cameraViewProjection));
+    Profiler::culledMeshes = gPassCuller.GetCount() - Profiler::visibleMeshes;
+
+    size_t firstMesh = 0;
+    for (const auto& entity : view)
+    {
+        auto [t, m] = view.get<TransformComponent, Model3DComponent>(entity);
+
+        const uint8_t * visibility = gPassCuller.GetVisibility() + firstMesh;
+        firstMesh += m.worldBoxes.size();
+        if (std::none_of(visibility, visibility + m.worldBoxes.size(), [](uint8_t isVisible) { return isVisible != 0; }))
+        {
+            continue;
+        }
+
+        const glm::mat4& transform = m.worldTransform;
+        m.lod = SelectLod(* m.model, transform, lodPixelThreshold);
+        m.model->RequestTextureResolution(GetPixelsPerUnit(* m.model, transform) * textureResolutionScale, m.tilingFactor);
+
+        // clusters exist for the full detail level only
+        ClusterCullingData culling;
+        const bool isCullingClusters = isClusterCullingEnabled && m.lod == 0;
+        if (isCullingClusters)
+        {
+            const glm::vec3 scale(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])));
+            culling.frustum = Frustum(cameraViewProjection * transform);
+            culling.cameraPosition = glm::vec3(glm::inverse(transform) * glm::vec4(cameraPosition, 1.0f));
+            const float maxScale = std::max({ scale.x, scale.y, scale.z });
+            culling.isConeCullingEnabled = maxScale - std::min({ scale.x, scale.y, scale.z }) <= maxScale * 1e-3f;
+        }
+
+        const uint32_t drawIndex = gPassDraws->AddDrawData(transform, m.tilingFactor, m.shouldBeLit);
+        Profiler::gPassTriangles += m.model->AddDraws(* gPassDraws, drawIndex, m.lod, isCullingClusters ? &culling : nullptr, visibility) / 3;
+    }
+}
+
 void Renderer::LightingPass(Scene &scene)
 {
     if(!shouldDrawFinalToFBO && !isPostProcessingActivated)
@@ -319,16 +486,16 @@ void Renderer::LightingPass(Scene &scene)
 
     Clear(glm::vec3(0, 0, 0));
 
-    auto& lShader = ResourcesManager::GetShader("lBufferShader");
+    auto& lShader = ResourcesManager::GetShader("lBufferShader")->GetVariant(lightingKeywords);
 
-    lShader->Use();
-    lShader->setInt("gPosition",        0);
-    lShader->setInt("gNormal",          1);
-    lShader->setInt("gAlbedoSpec",      2);
-    lShader->setInt("gMetallic",        3);
-    lShader->setInt("gRoughness",       4);
-    lShader->setInt("dLight.mapShadow", 5);
-    lShader->setInt("skybox",           6);
+    lShader.Use();
+    lShader.setInt(Uniforms::gPosition,       0);
+    lShader.setInt(Uniforms::gNormal,         1);
+    lShader.setInt(Uniforms::gAlbedoSpec,     2);
+    lShader.setInt(Uniforms::gMetallic,       3);
+    lShader.setInt(Uniforms::gRoughness,      4);
+    lShader.setInt(Uniforms::dLightMapShadow, 5);
+    lShader.setInt(Uniforms::skybox,          6);
 
     glActiveTexture(GL_TEXTURE0);
     gBufferFBO->GetTexture(GL_COLOR_ATTACHMENT0)->Bind();
@@ -397,16 +564,163 @@ void Renderer::RenderShadowMaps(Scene &scene)
 void Renderer::RenderToDepthBuffer(Scene &scene)
 {
     auto& shader = ResourcesManager::GetShader("shadowShader");
+
+    // compute culling writes an instance per visible cascade, so it needs the cascades to be drawn at once
+    if (!IsGpuCullingActive() || !isVertexLayerSupported)
+    {
+        RecordShadowDraws(scene);
+    }
+
+    const size_t cascades = std::min(lightSpaceMatrices.size(), static_cast<size_t>(cascadesCount));
+    if (isVertexLayerSupported)
+    {
+        // each instance writes the layer of its cascade, all the cascades are drawn at once
+        shader->Use();
+        Profiler::shadowPassDrawCalls = IsGpuCullingActive() ? gpuCuller->SubmitShadows() : shadowPassDraws->Submit(useMultiDrawIndirect, isInstancingEnabled);
+        return;
+    }
+
+    // without the vertex shader layer output the cascades are attached and drawn one by one
+    auto& variant = shader->GetVariant(ShaderKeywords {}.Enable(Keywords::layerPerPass));
+    variant.Use();
+    Profiler::shadowPassDrawCalls = 0;
+    for (size_t cascade = 0; cascade < cascades; cascade++)
+    {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowTexture->GetId(), 0, static_cast<GLint>(cascade));
+        variant.setInt(Uniforms::layer, static_cast<int>(cascade));
+        Profiler::shadowPassDrawCalls += shadowPassDraws->Submit(useMultiDrawIndirect, isInstancingEnabled);
+    }
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowTexture->GetId(), 0);
+}
+
+void Renderer::RecordShadowDraws(Scene &scene)
+{
     const auto& view = scene.registry.view<TransformComponent, Model3DComponent>();
-    shader->Use();
+    shadowPassDraws->Clear();
+
+    // casters are culled against each cascade separately, so they are drawn only into the cascades they can shadow
+    shadowCuller.Clear();
+    for (const auto& entity : view)
+    {
+        auto [t, m] = view.get<TransformComponent, Model3DComponent>(entity);
+        if(m.castsShadow)
+        {
+            m.UpdateWorldBounds(t.GetTransform());
+            for (size_t i = 0; i < m.worldBoxes.size(); i++)
+            {
+                shadowCuller.Add(m.worldBoxes[i], m.worldSpheres[i]);
+            }
+        }
+    }
+
+    const size_t cascades = std::min(lightSpaceMatrices.size(), static_cast<size_t>(cascadesCount));
+    casterCascades.assign(shadowCuller.GetCount(), 0);
+    for (size_t cascade = 0; cascade < cascades; cascade++)
+    {
+        shadowCuller.Cull(Frustum(lightSpaceMatrices[cascade]));
+        const uint8_t * visibility = shadowCuller.GetVisibility();
+        for (size_t i = 0; i < casterCascades.size(); i++)
+        {
+            casterCascades[i] |= static_cast<uint32_t>(visibility[i] != 0) << cascade;
+        }
+    }
+
+    size_t firstMesh = 0;
     for (const auto& entity : view)
     {
         auto [t, m] = view.get<TransformComponent, Model3DComponent>(entity);
         if(m.castsShadow)
         {
-            m.model.DrawIntoDepth(* shader, t.GetTransform());
+            const uint32_t * cascadeMasks = casterCascades.data() + firstMesh;
+            firstMesh += m.worldBoxes.size();
+            if (std::none_of(cascadeMasks, cascadeMasks + m.worldBoxes.size(), [](uint32_t mask) { return mask != 0; }))
+            {
+                continue;
+            }
+
+            // shadow casters tolerate much coarser geometry
+            const glm::mat4& transform = m.worldTransform;
+            m.shadowLod = SelectLod(* m.model, transform, lodPixelThreshold * shadowLodBias);
+
+            const uint32_t drawIndex = shadowPassDraws->AddDrawData(transform);
+            Profiler::shadowPassTriangles += m.model->AddDepthDraws(* shadowPassDraws, drawIndex, usePositionOnlyDepthStream, m.shadowLod, cascadeMasks) / 3;
         }
     }
+
+    Profiler::shadowCasterInstances = 0;
+    for (const uint32_t mask : casterCascades)
+    {
+        for (uint32_t bits = mask; bits != 0; bits &= bits - 1)
+        {
+            Profiler::shadowCasterInstances++;
+        }
+    }
+    Profiler::culledShadowCasterInstances = casterCascades.size() * cascades - Profiler::shadowCasterInstances;
+}
+
+void Renderer::CullOnGpu(Scene &scene)
+{
+    const auto& view = scene.registry.view<TransformComponent, Model3DComponent>();
+
+    // levels of detail and texture resolutions are still selected per model, only the changed instances are uploaded
+    gpuCuller->Begin();
+    for (const auto& entity : view)
+    {
+        auto [t, m] = view.get<TransformComponent, Model3DComponent>(entity);
+        m.UpdateWorldBounds(t.GetTransform());
+
+        const glm::mat4& transform = m.worldTransform;
+        m.lod = SelectLod(* m.model, transform, lodPixelThreshold);
+        m.shadowLod = SelectLod(* m.model, transform, lodPixelThreshold * shadowLodBias);
+        m.model->RequestTextureResolution(GetPixelsPerUnit(* m.model, transform) * textureResolutionScale, m.tilingFactor);
+
+        gpuCuller->AddModel(m.model, transform, m.worldBoxes, m.lod, m.shadowLod, m.tilingFactor, m.shouldBeLit, m.castsShadow);
+    }
+
+    gpuCuller->InternMaterials();
+    MaterialTable::Update();
+    gpuCuller->Update(usePositionOnlyDepthStream);
+
+    // without the vertex shader layer output the casters are recorded on the CPU, cascade by cascade
+    const bool isCullingShadows = areShadowsEnabled && isVertexLayerSupported && scene.GetDirectionalLight();
+    const size_t cascades = isCullingShadows ? std::min(lightSpaceMatrices.size(), static_cast<size_t>(cascadesCount)) : 0;
+    gpuCuller->Cull(Frustum(cameraViewProjection), lightSpaceMatrices.data(), cascades);
+
+    Profiler::gpuCulledObjects = gpuCuller->GetObjectsCount();
+}
+
+int Renderer::SelectLod(const Model& model, const glm::mat4& transform, float pixelThreshold)
+{
+    if (!isLodEnabled || model.GetLodsCount() < 2)
+    {
+        return 0;
+    }
+
+    // camera inside of the bounding sphere always gets the full detail
+    const float pixelsPerUnit = GetPixelsPerUnit(model, transform);
+    return std::isinf(pixelsPerUnit) ? 0 : model.SelectLod(pixelsPerUnit, pixelThreshold);
+}
+
+float Renderer::GetPixelsPerUnit(const Model& model, const glm::mat4& transform)
+{
+    const BoundingBox& bounds = model.GetBounds();
+    if (!bounds.IsValid())
+    {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    const float scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])) });
+    const glm::vec3 center = glm::vec3(transform * glm::vec4(bounds.GetCenter(), 1.0f));
+    const float radius = glm::length(bounds.GetExtents()) * scale;
+
+    // distance to the closest point of the bounding sphere
+    const float distance = glm::length(center - cameraPosition) - radius;
+    if (distance <= 0.0f)
+    {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    return scale * lodPixelsScale / distance;
 }
 
 std::vector<glm::mat4>
@@ -16,6 +16,9 @@
 #include "../Core/ResourcesManager.h"
 #include "UBO.hpp"
 #include "FBO.hpp"
+#include "DrawCommandBuffer.h"
+#include "FrustumCuller.h"
+#include "GpuCuller.h"
 
 /**
  * Not implemented so far
@@ -206,11 +209,83 @@ private:
     static std::vector<glm::mat4> getLightSpaceMatrices(float cameraNearPlane, float cameraFarPlane, float zoom, float aspectRatio, const glm::vec3 &lightDir, const glm::mat4 &viewMatrix, std::vector<float> &shadowCascadeLevels);
 
     static glm::mat4 getLightSpaceMatrix(float nearPlane, float farPlane, float zoom, float aspectRatio, const glm::vec3 &lightDir, const glm::mat4 &viewMatrix);
+
+    /**
+     * Selects model level of detail by its projected size from the primary camera
+     * @param model model to draw
+     * @param transform model transform matrix
+     * @param pixelThreshold maximum allowed error on the screen, in pixels
+     * @return level of detail
+     */
+    static int SelectLod(const Model& model, const glm::mat4& transform, float pixelThreshold);
+
+    /**
+     * @param model model
+     * @param transform model transform
+     * @return screen pixels per model space unit at the closest point of the model bounding sphere, infinity if camera
+     * is inside of it
+     */
+    static float GetPixelsPerUnit(const Model& model, const glm::mat4& transform);
+
+    /**
+     * Records model instances into the GPU culler and culls their meshes for both geometry and shadow passes
+     * @param scene scene to draw
+     */
+    static void CullOnGpu(Scene& scene);
+
+    /**
+     * Culls the meshes against the camera frustum and records the G-pass draws of the visible ones
+     * @param scene scene to draw
+     */
+    static void RecordGeometryDraws(Scene& scene);
+
+    /**
+     * Culls the shadow casters against each cascade and records their depth draws
+     * @param scene scene to draw
+     */
+    static void RecordShadowDraws(Scene& scene);
+
+    /**
+     * @return true if draws of both passes are culled and written by the compute shader
+     */
+    static bool IsGpuCullingActive() { return isGpuCullingEnabled && gpuCuller != nullptr; }
 public:
     inline static int drawMode = 1;
     inline static glm::vec3 clearColor;
     inline static bool isPostProcessingActivated = true, shouldDrawFinalToFBO = true;
 
+    // shadow casters are drawn with the position only vertex stream
+    inline static bool usePositionOnlyDepthStream = true;
+
+    // levels of detail: allowed error on the screen in pixels, and its multiplier for the shadow casters
+    inline static bool isLodEnabled = true;
+    inline static float lodPixelThreshold = 1.0f;
+    inline static float shadowLodBias = 4.0f;
+
+    // directional light shadows, if disabled, shadow maps are not rendered and the lighting variant without them is used
+    inline static bool areShadowsEnabled = true;
+
+    // G-pass meshes skip clusters outside of the camera frustum and facing away from the camera
+    inline static bool isClusterCullingEnabled = true;
+
+    // draws are batched into the multi draw indirect calls, one per VAO and material, instead of a call per mesh
+    inline static bool useMultiDrawIndirect = true;
+
+    // draws of the same mesh and material are merged into a single instanced draw, no matter which entities they belong to
+    inline static bool isInstancingEnabled = true;
+
+    // meshes are culled and their draws are written by a compute shader, so the CPU uploads only the changed instances
+    inline static bool isGpuCullingEnabled = false;
+
+    // texture bytes streamed into the GPU per frame, in kilobytes
+    inline static int textureUploadBudget = 8192;
+
+    // video memory taken by the textures, in megabytes, the coldest ones are dropped to the lower mips above it
+    inline static int textureMemoryBudget = 1024;
+
+    // multiplier of the texture resolution, requested from the screen space texel density, 2 streams in one level more
+    inline static float textureResolutionScale = 1.0f;
+
     // way to calculate shadows
     inline static LightingType::Type lightingType = LightingType::Dynamic;
 
@@ -233,8 +308,36 @@ private:
     inline static std::unique_ptr<UBO<glm::mat4x4, 16>> lightMatricesUBO;
     inline static std::unique_ptr<UBO<PointLight, 1024>> pointLightsUBO;
 
+    // draws of the geometry and shadow passes, rebuilt every frame
+    inline static std::unique_ptr<DrawCommandBuffer> gPassDraws, shadowPassDraws;
+
+    // persistent instances of both passes, culled on the GPU; null if not supported
+    inline static std::unique_ptr<GpuCuller> gpuCuller;
+
+    // world bounds of the G-pass meshes, tested against the primary camera frustum
+    inline static FrustumCuller gPassCuller;
+
+    // world bounds of the shadow casters, and bit per cascade each of them is visible in
+    inline static FrustumCuller shadowCuller;
+    inline static std::vector<uint32_t> casterCascades;
+
+    // light space matrices of the cascades for the current frame
+    inline static std::vector<glm::mat4> lightSpaceMatrices;
+
+    // whether the vertex shader can write gl_Layer, so all the cascades are drawn at once
+    inline static bool isVertexLayerSupported = false;
+
     inline static int shadowMapResolution = 2048, cascadesCount = 5;
 
+    // primary camera data for the levels of detail selection
+    inline static glm::vec3 cameraPosition { 0.0f };
+    inline static float lodPixelsScale = 0.0f;
+    inline static glm::mat4 cameraViewProjection { 1.0f };
+    inline static glm::mat4 cameraViewMatrix { 1.0f }, cameraProjection { 1.0f };
+
+    // keywords of the lighting shader variant, selected for the current frame
+    inline static ShaderKeywords lightingKeywords {};
+
     friend class RendererIniSerializer;
 };
 
@@ -43,6 +43,18 @@ public:
         AddVariable(fos, "deltaOffset", Renderer::deltaOffset);
         AddVariable(fos, "factorMultiplier", Renderer::factorMultiplier);
         AddVariable(fos, "shadowMapResolution", Renderer::shadowMapResolution);
+        AddVariable(fos, "usePositionOnlyDepthStream", Renderer::usePositionOnlyDepthStream);
+        AddVariable(fos, "isLodEnabled", Renderer::isLodEnabled);
+        AddVariable(fos, "lodPixelThreshold", Renderer::lodPixelThreshold);
+        AddVariable(fos, "shadowLodBias", Renderer::shadowLodBias);
+        AddVariable(fos, "areShadowsEnabled", Renderer::areShadowsEnabled);
+        AddVariable(fos, "isClusterCullingEnabled", Renderer::isClusterCullingEnabled);
+        AddVariable(fos, "useMultiDrawIndirect", Renderer::useMultiDrawIndirect);
+        AddVariable(fos, "isInstancingEnabled", Renderer::isInstancingEnabled);
+        AddVariable(fos, "isGpuCullingEnabled", Renderer::isGpuCullingEnabled);
+        AddVariable(fos, "textureUploadBudget", Renderer::textureUploadBudget);
+        AddVariable(fos, "textureMemoryBudget", Renderer::textureMemoryBudget);
+        AddVariable(fos, "textureResolutionScale", Renderer::textureResolutionScale);
 
         LOG(INFO) << "Renderer info serialized";
     }
@@ -81,6 +93,18 @@ public:
         LoadVariable(section, "deltaOffset", Renderer::deltaOffset);
         LoadVariable(section, "factorMultiplier", Renderer::factorMultiplier);
         LoadVariable(section, "shadowMapResolution", Renderer::shadowMapResolution);
+        LoadVariable(section, "usePositionOnlyDepthStream", Renderer::usePositionOnlyDepthStream);
+        LoadVariable(section, "isLodEnabled", Renderer::isLodEnabled);
+        LoadVariable(section, "lodPixelThreshold", Renderer::lodPixelThreshold);
+        LoadVariable(section, "shadowLodBias", Renderer::shadowLodBias);
+        LoadVariable(section, "areShadowsEnabled", Renderer::areShadowsEnabled);
+        LoadVariable(section, "isClusterCullingEnabled", Renderer::isClusterCullingEnabled);
+        LoadVariable(section, "useMultiDrawIndirect", Renderer::useMultiDrawIndirect);
+        LoadVariable(section, "isInstancingEnabled", Renderer::isInstancingEnabled);
+        LoadVariable(section, "isGpuCullingEnabled", Renderer::isGpuCullingEnabled);
+        LoadVariable(section, "textureUploadBudget", Renderer::textureUploadBudget);
+        LoadVariable(section, "textureMemoryBudget", Renderer::textureMemoryBudget);
+        LoadVariable(section, "textureResolutionScale", Renderer::textureResolutionScale);
 
         is.close();
 
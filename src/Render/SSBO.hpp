@@ -11,6 +11,8 @@
 #include "glm/glm.hpp"
 #include <iostream>
 #include <vector>
+#include <cstddef>
+#include <algorithm>
 
 class SSBO
 {
@@ -45,6 +47,26 @@ public:
         }
     }
 
+    /**
+     * Grows storage of the buffer bound to GL_SHADER_STORAGE_BUFFER, if it is smaller than required. Storage grows
+     * geometrically, so adding elements one by one does not reallocate the buffer every frame. Contents are not kept
+     * @param capacity current storage size, in bytes
+     * @param size required size, in bytes
+     * @param usage usage hint of the storage
+     * @return true if the storage was reallocated
+     */
+    static bool Grow(size_t& capacity, size_t size, GLenum usage)
+    {
+        if (capacity >= size)
+        {
+            return false;
+        }
+
+        capacity = std::max(size, capacity * 2);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(capacity), nullptr, usage);
+        return true;
+    }
+
     /**
      * Binds UBO to 0
      */
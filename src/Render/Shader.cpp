@@ -3,223 +3,463 @@
 //
 
 #include "Shader.h"
+#include "ProgramCache.h"
+#include "ShaderPreprocessor.h"
 #include "../Core/EngineException.h"
 #include "../Logging/easylogging++.h"
+#include "../Core/Profiler.hpp"
 
-Shader::Shader(const char *vertexPath, const char *fragmentPath, const char *geometryPath)
+#include <algorithm>
+
+namespace
 {
-    // 1. retrieve the vertex/fragment source code from filePath
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::string geometryCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-    std::ifstream gShaderFile;
+    /* Shader types of the stages, in the order they are stored */
+    constexpr GLenum stageTypes[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER, GL_COMPUTE_SHADER };
+    constexpr const char * stageNames[] = { "VERTEX", "FRAGMENT", "GEOMETRY", "COMPUTE" };
+}
 
-    // ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-    gShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-    try
+Shader::Shader(const char *vertexPath, const char *fragmentPath, const char *geometryPath, const std::vector<std::string>& defines, bool deferLinking)
+{
+    // 1. retrieve the sources with their includes resolved, variant keywords are collected from all the stages
+    shaderPath = { vertexPath, fragmentPath, geometryPath == nullptr ? "" : geometryPath, "" };
+    std::array<std::string, stagesCount> codes;
+    codes[0] = ShaderPreprocessor::Process(vertexPath, keywords);
+    codes[1] = ShaderPreprocessor::Process(fragmentPath, keywords);
+    codes[2] = geometryPath != nullptr ? ShaderPreprocessor::Process(geometryPath, keywords) : "";
+    Build(codes, defines, deferLinking);
+}
+
+Shader::Shader(const std::string& computePath, const std::vector<std::string>& defines)
+{
+    shaderPath = { "", "", "", computePath };
+    std::array<std::string, stagesCount> codes;
+    codes[3] = ShaderPreprocessor::Process(computePath, keywords);
+    Build(codes, defines, false);
+}
+
+void Shader::Build(std::array<std::string, stagesCount>& codes, const std::vector<std::string>& defines, bool deferLinking)
+{
+    ASSERT(keywords.size() <= maxKeywordsCount, "Shader " + GetName() + " declares too many keywords");
+
+    variantDefines = defines;
+    for (const auto& keyword : keywords)
+    {
+        keywordHashes.push_back(Hash::Fnv1a(keyword));
+    }
+
+    std::vector<std::string> shaderDefines = globalDefines;
+    shaderDefines.insert(shaderDefines.end(), defines.begin(), defines.end());
+    for (auto& code : codes)
+    {
+        InjectDefines(code, shaderDefines);
+    }
+
+    // binary depends on the final sources only, so the defines are hashed along with them
+    sourceHash = Hash::fnvOffsetBasis;
+    for (const auto& code : codes)
+    {
+        const uint64_t size = code.size();
+        sourceHash = Hash::Fnv1a(code, Hash::Fnv1a(&size, sizeof(size), sourceHash));
+    }
+
+    id = glCreateProgram();
+    if (ProgramCache::Load(id, sourceHash))
     {
-        // open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        // read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-        // convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-        // if geometry shader path is present, also load a geometry shader
-
-        if(geometryPath != nullptr)
+        isLinked = true;
+        ReflectUniforms();
+        return;
+    }
+
+    // 2. compile shaders, compilation status is checked once the program is linked
+    for (size_t i = 0; i < stagesCount; i++)
+    {
+        if (!codes[i].empty())
         {
-            gShaderFile.open(geometryPath);
-            std::stringstream gShaderStream;
-            gShaderStream << gShaderFile.rdbuf();
-            gShaderFile.close();
-            geometryCode = gShaderStream.str();
+            stages[i] = CompileStage(stageTypes[i], codes[i]);
         }
     }
-    catch (std::ifstream::failure& e)
+
+    // shader Program
+    for (const auto stage : stages)
     {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << e.what() << std::endl;
+        if (stage != 0)
+        {
+            glAttachShader(id, stage);
+        }
     }
-    shaderPath = { vertexPath, fragmentPath, geometryPath == nullptr ? "" : geometryPath };
+    glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(id);
 
-    const char* vShaderCode = vertexCode.c_str();
-    const char * fShaderCode = fragmentCode.c_str();
-    // 2. compile shaders
-    unsigned int vertex, fragment;
-    // vertex shader
+    if (!deferLinking)
+    {
+        FinishLinking();
+    }
+}
 
-    vertex = glCreateShader(GL_VERTEX_SHADER);
+unsigned int Shader::CompileStage(GLenum type, const std::string& code)
+{
+    const char * source = code.c_str();
+    const unsigned int stage = glCreateShader(type);
+    glShaderSource(stage, 1, &source, nullptr);
+    glCompileShader(stage);
+    return stage;
+}
+
+void Shader::FinishLinking()
+{
+    if (isLinked)
+    {
+        return;
+    }
 
-    glShaderSource(vertex, 1, &vShaderCode, nullptr);
-    glCompileShader(vertex);
+    // querying the status waits for the driver, so with the parallel compilation it is done as late as possible
+    auto deleteStages = [this]()
+    {
+        for (auto& stage : stages)
+        {
+            glDeleteShader(stage);
+            stage = 0;
+        }
+    };
 
-    checkCompileErrors(vertex, "VERTEX");
-    // fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, nullptr);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
-    // if geometry shader is given, compile geometry shader
-    unsigned int geometry;
-    if(geometryPath != nullptr)
+    try
     {
-        const char * gShaderCode = geometryCode.c_str();
-        geometry = glCreateShader(GL_GEOMETRY_SHADER);
-        glShaderSource(geometry, 1, &gShaderCode, nullptr);
-        glCompileShader(geometry);
-        checkCompileErrors(geometry, "GEOMETRY");
+        for (size_t i = 0; i < stages.size(); i++)
+        {
+            if (stages[i] != 0)
+            {
+                checkCompileErrors(stages[i], stageNames[i]);
+            }
+        }
+        checkCompileErrors(id, "PROGRAM");
     }
-    // shader Program
-    id = glCreateProgram();
-    glAttachShader(id, vertex);
-    glAttachShader(id, fragment);
-    if(geometryPath != nullptr)
+    catch (const EngineException&)
     {
-        glAttachShader(id, geometry);
+        deleteStages();
+        throw;
     }
-    glLinkProgram(id);
-    checkCompileErrors(id, "PROGRAM");
+
     // delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
-    if(geometryPath != nullptr)
+    deleteStages();
+    isLinked = true;
+
+    ProgramCache::Save(id, sourceHash);
+    ReflectUniforms();
+}
+
+bool Shader::EnableParallelCompile()
+{
+    if (GLEW_KHR_parallel_shader_compile)
     {
-        glDeleteShader(geometry);
+        // letting the driver pick the number of the threads
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+        return true;
+    }
+    if (GLEW_ARB_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+        return true;
+    }
+    return false;
+}
+
+Shader& Shader::GetVariant(const ShaderKeywords& enabled)
+{
+    // keywords the shader does not declare do not affect it, so they map to the same variant
+    uint32_t mask = 0;
+    for (size_t i = 0; i < enabled.count; i++)
+    {
+        const auto it = std::find(keywordHashes.begin(), keywordHashes.end(), enabled.hashes[i]);
+        if (it != keywordHashes.end())
+        {
+            mask |= 1u << (it - keywordHashes.begin());
+        }
     }
 
+    if (mask == 0)
+    {
+        return * this;
+    }
+
+    auto it = variants.find(mask);
+    if (it == variants.end())
+    {
+        std::vector<std::string> defines = variantDefines;
+        std::string names;
+        for (size_t i = 0; i < keywords.size(); i++)
+        {
+            if (mask & (1u << i))
+            {
+                defines.push_back(keywords[i]);
+                names += " " + keywords[i];
+            }
+        }
+
+        // a variant, which failed to compile, is not retried until the shader is reloaded
+        std::unique_ptr<Shader> variant;
+        try
+        {
+            variant = IsCompute() ? std::make_unique<Shader>(shaderPath[3], defines)
+                                  : std::make_unique<Shader>(shaderPath[0].c_str(), shaderPath[1].c_str(), shaderPath[2].empty() ? nullptr : shaderPath[2].c_str(), defines);
+            LOG(INFO) << "Compiled variant" << names << " of the shader " << GetName();
+        }
+        catch (const EngineException& e)
+        {
+            LOG(WARNING) << "Failed to compile variant" << names << " of the shader " << GetName() << ". Reason: " << e.what();
+        }
+        it = variants.emplace(mask, std::move(variant)).first;
+    }
+    return it->second ? * it->second : * this;
+}
+
+void Shader::InjectDefines(std::string& code, const std::vector<std::string>& defines)
+{
+    if (defines.empty() || code.empty())
+    {
+        return;
+    }
+
+    std::string directives;
+    for (const auto& define : defines)
+    {
+        directives += "#define " + define + "\n";
+    }
+
+    const size_t version = code.find("#version");
+    const size_t lineEnd = version == std::string::npos ? std::string::npos : code.find('\n', version);
+    if (version == std::string::npos)
+    {
+        code.insert(0, directives);
+    }
+    else if (lineEnd == std::string::npos)
+    {
+        code += "\n" + directives;
+    }
+    else
+    {
+        code.insert(lineEnd + 1, directives);
+    }
+}
+
+void Shader::ReflectUniforms()
+{
+    GLint uniformsCount = 0, maxNameLength = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &uniformsCount);
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<char> buffer(static_cast<size_t>(std::max(maxNameLength, 1)));
+    auto add = [this](const std::string& name, int location)
+    {
+        locations.emplace_back(Hash::Fnv1a(name), location);
+    };
+
+    for (GLint i = 0; i < uniformsCount; i++)
+    {
+        GLint size = 0;
+        GLenum type = 0;
+        GLsizei length = 0;
+        glGetActiveUniform(id, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()), &length, &size, &type, buffer.data());
+
+        const std::string name(buffer.data(), static_cast<size_t>(length));
+        const int location = glGetUniformLocation(id, name.c_str());
+
+        // members of the uniform blocks have no locations
+        if (location < 0)
+        {
+            continue;
+        }
+
+        // arrays of the basic types are reported once, by their first element
+        const size_t arraySuffix = name.size() >= 3 ? name.size() - 3 : std::string::npos;
+        if (arraySuffix != std::string::npos && name.compare(arraySuffix, 3, "[0]") == 0)
+        {
+            const std::string arrayName = name.substr(0, arraySuffix);
+            add(arrayName, location);
+            for (GLint e = 0; e < size; e++)
+            {
+                const std::string element = arrayName + "[" + std::to_string(e) + "]";
+                add(element, glGetUniformLocation(id, element.c_str()));
+            }
+        }
+        else
+        {
+            add(name, location);
+        }
+    }
+
+    std::sort(locations.begin(), locations.end());
+    for (size_t i = 1; i < locations.size(); i++)
+    {
+        if (locations[i].first == locations[i - 1].first && locations[i].second != locations[i - 1].second)
+        {
+            LOG(WARNING) << "Uniform name hash collision in shader " << GetName();
+        }
+    }
 }
 
 void Shader::Use() const
 {
+    if (id == usedProgram)
+    {
+        Profiler::skippedBinds++;
+        return;
+    }
+
     glUseProgram(id);
+    usedProgram = id;
+    Profiler::programBinds++;
 }
 
-void Shader::setBool(const std::string &name, bool value) const
+int Shader::GetLocation(UniformId uniform) const
 {
-    auto location = glGetUniformLocation(id, name.c_str());
-   //  if (location == -1 ) { LOG(WARNING) << "Failed to locate shader uniform " + name; }
+    auto it = std::lower_bound(locations.begin(), locations.end(), std::make_pair(uniform.hash, INT32_MIN));
+    return it != locations.end() && it->first == uniform.hash ? it->second : -1;
+}
 
-    glUniform1i(location, (int)value);
+int Shader::GetLocation(const std::string& name) const
+{
+    Profiler::uniformRuntimeLookups++;
+    return GetLocation(UniformId(name));
 }
 
-void Shader::setInt(const std::string &name, int value) const
+void Shader::setBool(UniformId uniform, bool value) const
+{
+    glUniform1i(GetLocation(uniform), (int)value);
+}
+
+void Shader::setInt(UniformId uniform, int value) const
+{
+    glUniform1i(GetLocation(uniform), value);
+}
+
+void Shader::setFloat(UniformId uniform, float value) const
 {
-    auto location = glGetUniformLocation(id, name.c_str());
-   //  if (location == -1 ) { LOG(WARNING) << "Failed to locate shader uniform " + name; }
+    glUniform1f(GetLocation(uniform), value);
+}
+
+void Shader::setFloatArray(UniformId uniform, const float * values, size_t count) const
+{
+    glUniform1fv(GetLocation(uniform), static_cast<GLsizei>(count), values);
+}
 
-    glUniform1i(location, value);
+void Shader::setVec2(UniformId uniform, const glm::vec2 &value) const
+{
+    glUniform2fv(GetLocation(uniform), 1, &value[0]);
+}
+
+void Shader::setVec3(UniformId uniform, const glm::vec3 &value) const
+{
+    glUniform3fv(GetLocation(uniform), 1, &value[0]);
+}
+
+void Shader::setVec4(UniformId uniform, const glm::vec4 &value) const
+{
+    glUniform4fv(GetLocation(uniform), 1, &value[0]);
+}
+
+void Shader::setMat2(UniformId uniform, const glm::mat2 &mat) const
+{
+    glUniformMatrix2fv(GetLocation(uniform), 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setMat3(UniformId uniform, const glm::mat3 &mat) const
+{
+    glUniformMatrix3fv(GetLocation(uniform), 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setMat4(UniformId uniform, const glm::mat4 &mat) const
+{
+    glUniformMatrix4fv(GetLocation(uniform), 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setHandle(UniformId uniform, uint64_t handle) const
+{
+    glUniformHandleui64ARB(GetLocation(uniform), handle);
+}
+
+void Shader::setBool(const std::string &name, bool value) const
+{
+    glUniform1i(GetLocation(name), (int)value);
+}
+
+void Shader::setInt(const std::string &name, int value) const
+{
+    glUniform1i(GetLocation(name), value);
 }
 
 void Shader::setFloat(const std::string &name, float value) const
 {
-    auto location = glGetUniformLocation(id, name.c_str());
-   //  if (location == -1 ) { LOG(WARNING) << "Failed to locate shader uniform " + name; }
-    glUniform1f(location, value);
+    glUniform1f(GetLocation(name), value);
 }
 
 void Shader::setVec2(const std::string &name, const glm::vec2 &value) const
 {
-    auto location = glGetUniformLocation(id, name.c_str());
-   //  if (location == -1 ) { LOG(WARNING) << "Failed to locate shader uniform " + name; }
-
-    glUniform2fv(location, 1, &value[0]);
+    glUniform2fv(GetLocation(name), 1, &value[0]);
 }
 
 void Shader::setVec2(const std::string &name, float x, float y) const
 {
-    auto location = glGetUniformLocation(id, name.c_str());
-   //  if (location == -1 ) { LOG(WARNING) << "Failed to locate shader uniform " + name; }
-
-    glUniform2f(location, x, y);
+    glUniform2f(GetLocation(name), x, y);
 }
 
 void Shader::setVec3(const std::string &name, const glm::vec3 &value) const
 {
-    auto location = glGetUniformLocation(id, name.c_str());
-   //  if (location == -1 ) { LOG(WARNING) << "Failed to locate shader uniform " + name; }
-
-    glUniform3fv(location, 1, &value[0]);
+    glUniform3fv(GetLocation(name), 1, &value[0]);
 }
 
 void Shader::setVec3(const std::string &name, float x, float y, float z) const
 {
-    auto location = glGetUniformLocation(id, name.c_str());
-   //  if (location == -1 ) { LOG(WARNING) << "Failed to locate shader uniform " + name; }
-
-    glUniform3f(location, x, y, z);
+    glUniform3f(GetLocation(name), x, y, z);
 }
 
 void Shader::setVec4(const std::string &name, const glm::vec4 &value) const
 {
-    auto location = glGetUniformLocation(id, name.c_str());
-   //  if (location == -1 ) { LOG(WARNING) << "Failed to locate shader uniform " + name; }
-
-    glUniform4fv(location, 1, &value[0]);
+    glUniform4fv(GetLocation(name), 1, &value[0]);
 }
 
 void Shader::setVec4(const std::string &name, float x, float y, float z, float w) const
 {
-    auto location = glGetUniformLocation(id, name.c_str());
-   //  if (location == -1 ) { LOG(WARNING) << "Failed to locate shader uniform " + name; }
-
-    glUniform4f(location, x, y, z, w);
+    glUniform4f(GetLocation(name), x, y, z, w);
 }
 
 void Shader::setMat2(const std::string &name, const glm::mat2 &mat) const
 {
-    auto location = glGetUniformLocation(id, name.c_str());
-   //  if (location == -1 ) { LOG(WARNING) << "Failed to locate shader uniform " + name; }
-
-    glUniformMatrix2fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix2fv(GetLocation(name), 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setMat3(const std::string &name, const glm::mat3 &mat) const
 {
-    auto location = glGetUniformLocation(id, name.c_str());
-   //  if (location == -1 ) { LOG(WARNING) << "Failed to locate shader uniform " + name; }
-
-    glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix3fv(GetLocation(name), 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const
 {
-    auto location = glGetUniformLocation(id, name.c_str());
-   //  if (location == -1 ) { LOG(WARNING) << "Failed to locate shader uniform " + name; }
-
-    glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(GetLocation(name), 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setDirLight(const DirectionalLight& dLight, const glm::vec3& rotation) const
 {
-    setVec3("dLight.diffuse", dLight.diffuse);
-    setVec3("dLight.ambient", dLight.ambient);
-    setVec3("dLight.specular", dLight.specular);
-    setVec3("dLight.direction", DirectionalLight::GetDirection(rotation));
+    static constexpr UniformId diffuse("dLight.diffuse"), ambient("dLight.ambient"), specular("dLight.specular"), direction("dLight.direction");
+
+    setVec3(diffuse, dLight.diffuse);
+    setVec3(ambient, dLight.ambient);
+    setVec3(specular, dLight.specular);
+    setVec3(direction, DirectionalLight::GetDirection(rotation));
 }
 
 void Shader::setPointLight(int idx, const PointLight& pointLight, const glm::vec3& position) const
 {
-    std::ostringstream pointLightName;
-    pointLightName << "pointLights[" << idx << "].";
-    std::string strName = pointLightName.str();
-
-    setVec3(strName + "position", position);
-    setFloat(strName + "linear", pointLight.linear);
-    setVec3(strName + "ambient", pointLight.ambient);
-    setVec3(strName + "diffuse", pointLight.diffuse);
-    setVec3(strName + "specular", pointLight.specular);
-    setFloat(strName + "constant", pointLight.constant);
-    setFloat(strName + "quadratic", pointLight.quadratic);
+    static constexpr UniformId pointLights("pointLights");
+
+    // only the index is hashed at runtime, the rest of the name continues the hash
+    const UniformId light = pointLights.Index(static_cast<unsigned int>(idx));
+    setVec3(light.Member("position"), position);
+    setFloat(light.Member("linear"), pointLight.linear);
+    setVec3(light.Member("ambient"), pointLight.ambient);
+    setVec3(light.Member("diffuse"), pointLight.diffuse);
+    setVec3(light.Member("specular"), pointLight.specular);
+    setFloat(light.Member("constant"), pointLight.constant);
+    setFloat(light.Member("quadratic"), pointLight.quadratic);
 }
 
 
@@ -7,6 +7,7 @@
 #include "glm/glm.hpp"
 #include "../Lighting/DirectionalLight.h"
 #include "../Lighting/PointLight.h"
+#include "../Core/Hash.hpp"
 
 #include <string>
 #include <fstream>
@@ -15,6 +16,93 @@
 #include <vector>
 #include <memory>
 #include <array>
+#include <cstdint>
+#include <utility>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * Uniform name, hashed at compile time, if declared constexpr. Setters, taking it, find the uniform location in the
+ * table, reflected once the program is linked, so they never build strings or ask the driver
+ */
+struct UniformId
+{
+    explicit constexpr UniformId(std::string_view name) : hash(Hash::Fnv1aConstexpr(name)) {}
+
+    /**
+     * @param index element index
+     * @return id of the array element, as if named "name[index]"
+     */
+    [[nodiscard]] constexpr UniformId Index(unsigned int index) const
+    {
+        char digits[10] {};
+        int count = 0;
+        do
+        {
+            digits[count++] = static_cast<char>('0' + index % 10);
+            index /= 10;
+        } while (index > 0);
+
+        uint64_t result = Hash::Fnv1aConstexpr("[", hash);
+        while (count > 0)
+        {
+            result = Hash::Fnv1aConstexpr(std::string_view(&digits[--count], 1), result);
+        }
+        return FromHash(Hash::Fnv1aConstexpr("]", result));
+    }
+
+    /**
+     * @param member struct member name
+     * @return id of the struct member, as if named "name.member"
+     */
+    [[nodiscard]] constexpr UniformId Member(std::string_view member) const
+    {
+        return FromHash(Hash::Fnv1aConstexpr(member, Hash::Fnv1aConstexpr(".", hash)));
+    }
+
+    uint64_t hash;
+
+private:
+    static constexpr UniformId FromHash(uint64_t hash)
+    {
+        UniformId id("");
+        id.hash = hash;
+        return id;
+    }
+};
+
+/**
+ * Shader variant keyword, hashed at compile time, if declared constexpr
+ */
+struct ShaderKeyword
+{
+    explicit constexpr ShaderKeyword(std::string_view name) : hash(Hash::Fnv1aConstexpr(name)) {}
+
+    uint64_t hash;
+};
+
+/**
+ * Keywords, enabled for the shader variant
+ */
+struct ShaderKeywords
+{
+    /**
+     * @param keyword keyword to enable
+     * @param isEnabled if false, keyword is left disabled
+     * @return this
+     */
+    constexpr ShaderKeywords& Enable(ShaderKeyword keyword, bool isEnabled = true)
+    {
+        if (isEnabled && count < std::size(hashes))
+        {
+            hashes[count++] = keyword.hash;
+        }
+        return * this;
+    }
+
+    uint64_t hashes[16] {};
+    size_t count = 0;
+};
 
 class Shader {
 public:
@@ -27,18 +115,98 @@ public:
      * @param vertexPath path to the vertex shader
      * @param fragmentPath path to the fragment shader
      * @param geometryPath path to the geometry shader
+     * @param defines macros, defined in every stage right after the #version directive, either "NAME" or "NAME VALUE"
+     * @param deferLinking if true, compilation and linking results are not waited for until FinishLinking is called,
+     * so the driver can compile several programs in parallel
+     */
+    Shader(const char *vertexPath, const char *fragmentPath, const char *geometryPath = nullptr, const std::vector<std::string>& defines = {}, bool deferLinking = false);
+
+    /**
+     * Compiles and links compute shader program
+     * @param computePath path to the compute shader
+     * @param defines macros, defined right after the #version directive, either "NAME" or "NAME VALUE"
      */
-    Shader(const char *vertexPath, const char *fragmentPath, const char *geometryPath = nullptr);
+    explicit Shader(const std::string& computePath, const std::vector<std::string>& defines = {});
 
     ~Shader() {
+        if (usedProgram == id)
+        {
+            usedProgram = 0;
+        }
         glDeleteProgram(id);
     }
 
     /**
-     * Binds this shader
+     * Waits for the compilation and linking to finish, checks their results, writes the program into the program cache
+     * and reflects its uniforms. Does nothing if program was loaded from the cache or is already linked
+     */
+    void FinishLinking();
+
+    /**
+     * @return true once program is linked and ready to use
+     */
+    [[nodiscard]] bool IsLinked() const { return isLinked; }
+
+    /**
+     * @return true if this is a compute shader program
+     */
+    [[nodiscard]] bool IsCompute() const { return !shaderPath[3].empty(); }
+
+    /**
+     * Lets the driver compile shaders on its own threads, if KHR_parallel_shader_compile is supported
+     * @return true if shaders are compiled in parallel
+     */
+    static bool EnableParallelCompile();
+
+    /**
+     * Returns the shader variant, compiled with the macros of the enabled keywords defined, compiling it on the first
+     * request. Keywords the shader does not declare with #pragma keywords are ignored
+     * @param enabled enabled keywords
+     * @return the variant, or this shader, if no declared keyword is enabled or the variant failed to compile
+     */
+    Shader& GetVariant(const ShaderKeywords& enabled);
+
+    /**
+     * Binds this shader, unless it is bound already
      */
     void Use() const;
 
+    void setBool(UniformId uniform, bool value) const;
+
+    void setInt(UniformId uniform, int value) const;
+
+    void setFloat(UniformId uniform, float value) const;
+
+    /**
+     * Sets the whole array of floats at once
+     * @param uniform array uniform
+     * @param values array values
+     * @param count number of the values
+     */
+    void setFloatArray(UniformId uniform, const float * values, size_t count) const;
+
+    void setVec2(UniformId uniform, const glm::vec2 &value) const;
+
+    void setVec3(UniformId uniform, const glm::vec3 &value) const;
+
+    void setVec4(UniformId uniform, const glm::vec4 &value) const;
+
+    void setMat2(UniformId uniform, const glm::mat2 &mat) const;
+
+    void setMat3(UniformId uniform, const glm::mat3 &mat) const;
+
+    void setMat4(UniformId uniform, const glm::mat4 &mat) const;
+
+    /**
+     * Sets sampler uniform to the bindless texture handle, shader has to be compiled with the bindless samplers
+     * @param uniform uniform
+     * @param handle resident texture handle
+     */
+    void setHandle(UniformId uniform, uint64_t handle) const;
+
+    /* Setters taking the names, hashed at runtime. Each call is counted by the profiler, so should be kept out of the
+     * hot path */
+
     void setBool(const std::string &name, bool value) const;
 
     void setInt(const std::string &name, int value) const;
@@ -67,20 +235,103 @@ public:
 
     void setPointLight(int idx, const PointLight &pointLight, const glm::vec3 &position) const;
 
-    std::array<std::string, 3> GetShaderPath()
+    std::array<std::string, 4> GetShaderPath()
     {
         return shaderPath;
     }
 
+    /**
+     * Adds macro, defined in all the shaders compiled after this call
+     * @param define either "NAME" or "NAME VALUE"
+     */
+    static void AddGlobalDefine(const std::string& define) { globalDefines.push_back(define); }
+
 private:
+    /* Vertex, fragment, geometry and compute stages */
+    static constexpr size_t stagesCount = 4;
+
     /**
      * Checks if there were any compilation errors
      * @param shader shader to check
-     * @param type type of the shader ("VERTEX", "FRAGMENT", "GEOMETRY")
+     * @param type type of the shader ("VERTEX", "FRAGMENT", "GEOMETRY", "COMPUTE")
      */
     static void checkCompileErrors(GLuint shader, const std::string& type);
 
+    /**
+     * Inserts #define directives after the #version one, which has to stay the first directive of the source
+     * @param code shader source
+     * @param defines macros to define
+     */
+    static void InjectDefines(std::string& code, const std::vector<std::string>& defines);
+
+    /**
+     * Injects the defines into the preprocessed sources, then either loads the program from the cache or starts
+     * compiling and linking it
+     * @param codes sources of the stages, empty for the absent ones
+     * @param defines macros to define in every stage
+     * @param deferLinking if true, results are not checked until FinishLinking is called
+     */
+    void Build(std::array<std::string, stagesCount>& codes, const std::vector<std::string>& defines, bool deferLinking);
+
+    /**
+     * @return path of the fragment or the compute shader, to identify the shader in the logs
+     */
+    [[nodiscard]] const std::string& GetName() const { return IsCompute() ? shaderPath[3] : shaderPath[1]; }
+
+    /**
+     * Creates shader object and starts its compilation, without waiting for the result
+     * @param type shader type
+     * @param code shader source
+     * @return shader object
+     */
+    static unsigned int CompileStage(GLenum type, const std::string& code);
+
+    /**
+     * Fills the location table with all active uniforms of the linked program. Arrays of the basic types are
+     * reflected both by their name and by the name of each element
+     */
+    void ReflectUniforms();
+
+    /**
+     * @param uniform uniform
+     * @return uniform location, -1 if there is no such an active uniform, so setting it is ignored
+     */
+    [[nodiscard]] int GetLocation(UniformId uniform) const;
+
+    /**
+     * Hashes the name at runtime and counts the lookup
+     * @param name uniform name
+     * @return uniform location, -1 if there is no such an active uniform
+     */
+    [[nodiscard]] int GetLocation(const std::string& name) const;
+
     unsigned int id;
-    std::array<std::string, 3> shaderPath;
+    std::array<std::string, stagesCount> shaderPath;
+
+    /* Shader objects, kept until the program is linked, 0 for the absent stages */
+    std::array<unsigned int, stagesCount> stages {};
+    uint64_t sourceHash = 0;
+    bool isLinked = false;
+
+    /* Keywords, declared by the shader sources, and their hashes */
+    std::vector<std::string> keywords;
+    std::vector<uint64_t> keywordHashes;
+
+    /* Defines, the shader was created with, variants add the keywords to them */
+    std::vector<std::string> variantDefines;
+
+    /* Compiled variants by the mask of the enabled keywords, null if variant failed to compile */
+    std::unordered_map<uint32_t, std::unique_ptr<Shader>> variants;
+
+    /* Keywords are identified by the bits of the 32 bit mask */
+    static constexpr size_t maxKeywordsCount = 32;
+
+    /* Uniform locations, sorted by the name hashes */
+    std::vector<std::pair<uint64_t, int>> locations;
+
+    inline static std::vector<std::string> globalDefines;
+
+    /* Program bound by the last Use call, programs must not be bound with glUseProgram directly */
+    inline static unsigned int usedProgram = 0;
 };
 #endif
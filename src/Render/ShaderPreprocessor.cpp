@@ -0,0 +1,93 @@
+#include "ShaderPreprocessor.h"
+#include "../Core/EngineException.h"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+namespace
+{
+    /**
+     * @param line source line
+     * @param directive directive name, without the #
+     * @return rest of the line after the directive, or nullptr if the line is not the directive
+     */
+    const char * MatchDirective(const std::string& line, const std::string& directive)
+    {
+        size_t i = line.find_first_not_of(" \t");
+        if (i == std::string::npos || line[i] != '#')
+        {
+            return nullptr;
+        }
+
+        i = line.find_first_not_of(" \t", i + 1);
+        if (i == std::string::npos || line.compare(i, directive.size(), directive) != 0)
+        {
+            return nullptr;
+        }
+
+        i += directive.size();
+        if (i < line.size() && line[i] != ' ' && line[i] != '\t')
+        {
+            return nullptr;
+        }
+        return line.c_str() + i;
+    }
+}
+
+std::string ShaderPreprocessor::Process(const std::string& path, std::vector<std::string>& keywords)
+{
+    std::string output;
+    std::vector<std::filesystem::path> included;
+    ProcessFile(path, output, keywords, included, 0);
+    return output;
+}
+
+void ShaderPreprocessor::ProcessFile(const std::filesystem::path& path, std::string& output, std::vector<std::string>& keywords,
+                                     std::vector<std::filesystem::path>& included, size_t depth)
+{
+    ASSERT(depth <= maxIncludeDepth, "Failed to preprocess shader " + path.string() + ". Reason: includes are nested too deep");
+
+    std::ifstream is(path);
+    ASSERT(is.is_open(), "Failed to preprocess shader. Reason: unable to open " + path.string());
+    included.push_back(path.lexically_normal());
+
+    std::string line;
+    while (std::getline(is, line))
+    {
+        if (const char * rest = MatchDirective(line, "include"))
+        {
+            const std::string argument(rest);
+            const size_t begin = argument.find('"');
+            const size_t end = begin == std::string::npos ? std::string::npos : argument.find('"', begin + 1);
+            ASSERT(end != std::string::npos, "Failed to preprocess shader " + path.string() + ". Reason: malformed directive " + line);
+
+            const auto includePath = (path.parent_path() / argument.substr(begin + 1, end - begin - 1)).lexically_normal();
+            if (std::find(included.begin(), included.end(), includePath) == included.end())
+            {
+                ProcessFile(includePath, output, keywords, included, depth + 1);
+            }
+            continue;
+        }
+
+        if (const char * rest = MatchDirective(line, "pragma"))
+        {
+            std::istringstream arguments(rest);
+            std::string pragma;
+            if (arguments >> pragma && pragma == "keywords")
+            {
+                for (std::string keyword; arguments >> keyword;)
+                {
+                    if (std::find(keywords.begin(), keywords.end(), keyword) == keywords.end())
+                    {
+                        keywords.push_back(keyword);
+                    }
+                }
+                continue;
+            }
+        }
+
+        output += line;
+        output += '\n';
+    }
+}
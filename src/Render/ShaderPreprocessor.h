@@ -0,0 +1,48 @@
+#ifndef GRAPHICS_SHADERPREPROCESSOR_H
+#define GRAPHICS_SHADERPREPROCESSOR_H
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+/**
+ * Resolves the directives GLSL compilers do not know about, before the source is handed to the driver:
+ *  - #include "path" - replaced with the content of the file, path is relative to the including file. Every file is
+ *    included only once, so the shared declarations need no include guards
+ *  - #pragma keywords NAME... - declares keywords, the shader variants are compiled with. Each enabled keyword is
+ *    defined as a macro in the variant, the directive itself is removed
+ */
+class ShaderPreprocessor
+{
+public:
+    /* Restriction to create an instance of this class */
+    ShaderPreprocessor() = delete;
+    ShaderPreprocessor(ShaderPreprocessor&&) = delete;
+    ShaderPreprocessor(const ShaderPreprocessor&) = delete;
+
+    /**
+     * Reads shader source with all its includes resolved
+     * @param path path to the shader file
+     * @param keywords keywords declared by the file and its includes are appended to it, unless already present
+     * @return shader source
+     * @throws EngineException if file or any of its includes can not be read
+     */
+    static std::string Process(const std::string& path, std::vector<std::string>& keywords);
+
+private:
+    /**
+     * Appends file content to the output, recursively resolving its includes
+     * @param path path to the file
+     * @param output processed source
+     * @param keywords declared keywords
+     * @param included files already included into the output
+     * @param depth include depth of the file
+     */
+    static void ProcessFile(const std::filesystem::path& path, std::string& output, std::vector<std::string>& keywords,
+                            std::vector<std::filesystem::path>& included, size_t depth);
+
+    /* Nesting deeper than this is treated as the include cycle */
+    static constexpr size_t maxIncludeDepth = 16;
+};
+
+#endif //GRAPHICS_SHADERPREPROCESSOR_H
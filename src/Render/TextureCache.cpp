@@ -0,0 +1,164 @@
+#include "TextureCache.h"
+#include "TextureRegistry.h"
+#include "../Core/Hash.hpp"
+#include "../Core/CacheFile.h"
+#include "../Core/MappedFile.h"
+#include "../Logging/easylogging++.h"
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+    constexpr char cacheMagic[4] = { 'O', 'G', 'T', 'C' };
+
+    struct TextureCacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+
+        uint64_t sourceSize;
+        int64_t  sourceTime;
+        uint64_t sourceHash;
+
+        uint32_t internalFormat;
+        uint32_t pixelFormat;
+        uint32_t type;
+        uint32_t levelsCount;
+
+        uint64_t levelsOffset;
+    };
+
+    struct TextureCacheLevel
+    {
+        uint64_t offset;
+        uint64_t size;
+        uint32_t width;
+        uint32_t height;
+    };
+}
+
+std::string TextureCache::GetCachePath(const std::string& sourcePath, TextureType type)
+{
+    const uint64_t hash = Hash::Fnv1a(&type, sizeof(type), Hash::Fnv1a(TextureRegistry::NormalizePath(sourcePath)));
+    return (std::filesystem::path(cacheDirectory) / (Hash::ToHex(hash) + ".tex")).string();
+}
+
+std::shared_ptr<TextureData> TextureCache::Load(const std::string& sourcePath, TextureType type)
+{
+    const std::string cachePath = GetCachePath(sourcePath, type);
+
+    uint64_t sourceSize = 0;
+    int64_t sourceTime  = 0;
+    if (!CacheFile::GetSourceStamp(sourcePath, sourceSize, sourceTime) || !std::filesystem::exists(cachePath))
+    {
+        return nullptr;
+    }
+
+    auto file = std::make_shared<MappedFile>(cachePath);
+    if (!file->IsOpen() || file->GetSize() < sizeof(TextureCacheHeader))
+    {
+        LOG(WARNING) << "Texture cache " << cachePath << " can not be read, ignoring it";
+        return nullptr;
+    }
+
+    const uint8_t * base = file->GetData();
+    const uint64_t fileSize = file->GetSize();
+    const auto * header = reinterpret_cast<const TextureCacheHeader *>(base);
+
+    if (std::memcmp(header->magic, cacheMagic, sizeof(cacheMagic)) != 0 || header->version != version || header->type != static_cast<uint32_t>(type))
+    {
+        LOG(INFO) << "Texture cache of " << sourcePath << " has an outdated format";
+        return nullptr;
+    }
+
+    if (header->sourceSize != sourceSize || (header->sourceTime != sourceTime && header->sourceHash != Hash::HashFile(sourcePath)))
+    {
+        LOG(INFO) << "Texture cache of " << sourcePath << " is outdated";
+        return nullptr;
+    }
+    const bool isSourceTimeOutdated = header->sourceTime != sourceTime;
+
+    if (header->levelsCount == 0 || !CacheFile::IsInRange(header->levelsOffset, uint64_t(header->levelsCount) * sizeof(TextureCacheLevel), fileSize))
+    {
+        LOG(WARNING) << "Texture cache " << cachePath << " is corrupted";
+        return nullptr;
+    }
+
+    auto data = std::make_shared<TextureData>();
+    data->internalFormat = header->internalFormat;
+    data->pixelFormat = header->pixelFormat;
+    data->cacheFile = file;
+
+    // pointing straight into the mapped pages, no copies are made
+    data->pixels = base;
+
+    const auto * levels = reinterpret_cast<const TextureCacheLevel *>(base + header->levelsOffset);
+    for (uint32_t i = 0; i < header->levelsCount; i++)
+    {
+        if (!CacheFile::IsInRange(levels[i].offset, levels[i].size, fileSize) || levels[i].width == 0 || levels[i].height == 0)
+        {
+            LOG(WARNING) << "Texture cache " << cachePath << " is corrupted";
+            return nullptr;
+        }
+        data->levels.push_back({ static_cast<int>(levels[i].width), static_cast<int>(levels[i].height), levels[i].offset, levels[i].size });
+    }
+
+    // content hash matched, so the new time is stored to skip hashing the source on the next launches
+    if (isSourceTimeOutdated && !CacheFile::UpdateSourceTime(cachePath, offsetof(TextureCacheHeader, sourceTime), sourceTime))
+    {
+        LOG(WARNING) << "Failed to update source time of texture cache " << cachePath;
+    }
+
+    return data;
+}
+
+void TextureCache::Save(const std::string& sourcePath, TextureType type, const TextureData& data)
+{
+    const std::string cachePath = GetCachePath(sourcePath, type);
+
+    TextureCacheHeader header {};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = version;
+    header.internalFormat = data.internalFormat;
+    header.pixelFormat = data.pixelFormat;
+    header.type = static_cast<uint32_t>(type);
+    header.levelsCount = static_cast<uint32_t>(data.levels.size());
+
+    if (!CacheFile::GetSourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+    {
+        LOG(WARNING) << "Failed to cache " << sourcePath << ". Reason: source file is not accessible";
+        return;
+    }
+    header.sourceHash = Hash::HashFile(sourcePath);
+
+    // laying out the sections
+    header.levelsOffset = CacheFile::Align(sizeof(TextureCacheHeader));
+
+    std::vector<TextureCacheLevel> levels;
+    uint64_t offset = CacheFile::Align(header.levelsOffset + data.levels.size() * sizeof(TextureCacheLevel));
+    for (const auto& level : data.levels)
+    {
+        levels.push_back({ offset, level.size, static_cast<uint32_t>(level.width), static_cast<uint32_t>(level.height) });
+        offset = CacheFile::Align(offset + level.size);
+    }
+
+    const bool isWritten = CacheFile::Write(cachePath, [&](std::ostream& os)
+    {
+        CacheFile::WriteAt(os, 0, &header, sizeof(header));
+        CacheFile::WriteAt(os, header.levelsOffset, levels.data(), levels.size() * sizeof(TextureCacheLevel));
+        for (size_t i = 0; i < levels.size(); i++)
+        {
+            CacheFile::WriteAt(os, levels[i].offset, data.pixels + data.levels[i].offset, data.levels[i].size);
+        }
+    });
+
+    if (!isWritten)
+    {
+        LOG(WARNING) << "Failed to write texture cache of " << sourcePath;
+        return;
+    }
+
+    LOG(INFO) << "Texture cache of " << sourcePath << " written to " << cachePath;
+}
@@ -0,0 +1,68 @@
+#ifndef GRAPHICS_TEXTURECACHE_H
+#define GRAPHICS_TEXTURECACHE_H
+
+#include "Material.h"
+
+#include <memory>
+#include <string>
+#include <cstdint>
+
+/**
+ * Binary cache of the textures. Every texture is written with its whole mip chain, either block compressed or not, into
+ * a versioned binary file, which is memory mapped on the next launches, so levels are uploaded straight from the mapped
+ * pages, skipping the image decoding, the mips generation and the compression.
+ *
+ * File layout (all offsets are relative to the beginning of the file):
+ *  - TextureCacheHeader
+ *  - TextureCacheHeader::levelsCount x TextureCacheLevel
+ *  - pixels or blocks of every level, each level aligned to the 16 bytes
+ *
+ * Texture is cached per usage type, as it defines the compression format and the mips filter. Cache is invalidated
+ * the same way the mesh cache is: by the format version, source file size and modification time, falling back to the
+ * content hash
+ */
+class TextureCache
+{
+public:
+    /* Restriction to create an instance of this class */
+    TextureCache() = delete;
+    TextureCache(TextureCache&&) = delete;
+    TextureCache(const TextureCache&) = delete;
+
+    /**
+     * Loads texture from the cache
+     * @param sourcePath path to the source image
+     * @param type how texture is sampled by the shaders
+     * @return texture data, which levels point into the mapped cache file, or nullptr if there is no valid cache
+     */
+    static std::shared_ptr<TextureData> Load(const std::string& sourcePath, TextureType type);
+
+    /**
+     * Writes texture into the cache. Failures are logged, but never thrown
+     * @param sourcePath path to the source image
+     * @param type how texture is sampled by the shaders
+     * @param data texture data
+     */
+    static void Save(const std::string& sourcePath, TextureType type, const TextureData& data);
+
+    /**
+     * @param sourcePath path to the source image
+     * @param type how texture is sampled by the shaders
+     * @return path to the cache file of the given texture
+     */
+    static std::string GetCachePath(const std::string& sourcePath, TextureType type);
+
+    /**
+     * Sets directory, where cache files are stored
+     * @param directory cache directory
+     */
+    static void SetCacheDirectory(const std::string& directory) { cacheDirectory = directory; }
+
+    /* Format version, must be incremented each time the layout or the encoders change */
+    static constexpr uint32_t version = 2;
+
+private:
+    inline static std::string cacheDirectory = "../res/cache/textures";
+};
+
+#endif //GRAPHICS_TEXTURECACHE_H
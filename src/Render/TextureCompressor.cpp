@@ -0,0 +1,484 @@
+#include "TextureCompressor.h"
+#include "MipGenerator.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+    /* BC7 interpolation weights of the 4-bit indices */
+    constexpr int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    /**
+     * Writes bits into the block, starting from the least significant bit of the first byte
+     */
+    struct BitWriter
+    {
+        uint8_t * block;
+        int position = 0;
+
+        void Write(uint32_t value, int bitsCount)
+        {
+            for (int i = 0; i < bitsCount; i++, position++)
+            {
+                if ((value >> i) & 1u)
+                {
+                    block[position >> 3] |= static_cast<uint8_t>(1u << (position & 7));
+                }
+            }
+        }
+    };
+
+    /**
+     * Finds endpoints of the block colors along their principal axis
+     * @param pixels 16 block pixels, RGBA
+     * @param channels number of the channels to fit, 3 or 4
+     * @param start first endpoint, written
+     * @param end second endpoint, written
+     */
+    void FitEndpoints(const uint8_t pixels[16][4], int channels, float start[4], float end[4])
+    {
+        float mean[4] = {};
+        for (int p = 0; p < 16; p++)
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                mean[c] += pixels[p][c] / 16.0f;
+            }
+        }
+
+        float covariance[4][4] = {};
+        for (int p = 0; p < 16; p++)
+        {
+            for (int a = 0; a < channels; a++)
+            {
+                for (int b = 0; b < channels; b++)
+                {
+                    covariance[a][b] += (pixels[p][a] - mean[a]) * (pixels[p][b] - mean[b]);
+                }
+            }
+        }
+
+        // power iteration converges to the principal axis in a handful of steps
+        float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for (int iteration = 0; iteration < 8; iteration++)
+        {
+            float next[4] = {};
+            float length = 0.0f;
+            for (int a = 0; a < channels; a++)
+            {
+                for (int b = 0; b < channels; b++)
+                {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                length = std::max(length, std::abs(next[a]));
+            }
+            if (length < 1e-6f)
+            {
+                break;
+            }
+            for (int c = 0; c < channels; c++)
+            {
+                axis[c] = next[c] / length;
+            }
+        }
+
+        float axisLength = 0.0f;
+        for (int c = 0; c < channels; c++)
+        {
+            axisLength += axis[c] * axis[c];
+        }
+        axisLength = std::sqrt(axisLength);
+
+        float minProjection = 0.0f, maxProjection = 0.0f;
+        if (axisLength > 1e-6f)
+        {
+            minProjection = 1e9f;
+            maxProjection = -1e9f;
+            for (int p = 0; p < 16; p++)
+            {
+                float projection = 0.0f;
+                for (int c = 0; c < channels; c++)
+                {
+                    projection += (pixels[p][c] - mean[c]) * axis[c] / axisLength;
+                }
+                minProjection = std::min(minProjection, projection);
+                maxProjection = std::max(maxProjection, projection);
+            }
+        }
+
+        for (int c = 0; c < 4; c++)
+        {
+            const float direction = c < channels && axisLength > 1e-6f ? axis[c] / axisLength : 0.0f;
+            start[c] = std::clamp(mean[c] + direction * maxProjection, 0.0f, 255.0f);
+            end[c] = std::clamp(mean[c] + direction * minProjection, 0.0f, 255.0f);
+        }
+    }
+
+    inline int SquaredDistance(const uint8_t a[4], const int b[4], int channels)
+    {
+        int distance = 0;
+        for (int c = 0; c < channels; c++)
+        {
+            const int delta = a[c] - b[c];
+            distance += delta * delta;
+        }
+        return distance;
+    }
+
+    inline uint16_t PackRgb565(const float color[4])
+    {
+        const auto r = static_cast<uint16_t>(std::lround(color[0] * 31.0f / 255.0f));
+        const auto g = static_cast<uint16_t>(std::lround(color[1] * 63.0f / 255.0f));
+        const auto b = static_cast<uint16_t>(std::lround(color[2] * 31.0f / 255.0f));
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    inline void UnpackRgb565(uint16_t packed, int color[4])
+    {
+        const int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+        color[3] = 255;
+    }
+
+    void EncodeBC1(const uint8_t pixels[16][4], uint8_t * block)
+    {
+        float start[4], end[4];
+        FitEndpoints(pixels, 3, start, end);
+
+        uint16_t color0 = PackRgb565(start), color1 = PackRgb565(end);
+
+        // four color mode requires the first endpoint to be the larger one
+        if (color0 < color1)
+        {
+            std::swap(color0, color1);
+        }
+
+        uint32_t indices = 0;
+        if (color0 != color1)
+        {
+            int palette[4][4];
+            UnpackRgb565(color0, palette[0]);
+            UnpackRgb565(color1, palette[1]);
+            for (int c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            for (int p = 0; p < 16; p++)
+            {
+                uint32_t best = 0;
+                int bestDistance = SquaredDistance(pixels[p], palette[0], 3);
+                for (uint32_t i = 1; i < 4; i++)
+                {
+                    const int distance = SquaredDistance(pixels[p], palette[i], 3);
+                    if (distance < bestDistance)
+                    {
+                        best = i;
+                        bestDistance = distance;
+                    }
+                }
+                indices |= best << (2 * p);
+            }
+        }
+
+        std::memcpy(block, &color0, 2);
+        std::memcpy(block + 2, &color1, 2);
+        std::memcpy(block + 4, &indices, 4);
+    }
+
+    void EncodeBC4(const uint8_t values[16], uint8_t * block)
+    {
+        const uint8_t maxValue = * std::max_element(values, values + 16);
+        const uint8_t minValue = * std::min_element(values, values + 16);
+
+        // eight value mode requires the first endpoint to be the larger one
+        block[0] = maxValue;
+        block[1] = minValue;
+
+        int palette[8] = { maxValue, minValue };
+        for (int i = 1; i < 7; i++)
+        {
+            palette[i + 1] = ((7 - i) * maxValue + i * minValue + 3) / 7;
+        }
+
+        uint64_t indices = 0;
+        if (maxValue != minValue)
+        {
+            for (int p = 0; p < 16; p++)
+            {
+                uint64_t best = 0;
+                int bestDistance = std::abs(values[p] - palette[0]);
+                for (uint64_t i = 1; i < 8; i++)
+                {
+                    const int distance = std::abs(values[p] - palette[i]);
+                    if (distance < bestDistance)
+                    {
+                        best = i;
+                        bestDistance = distance;
+                    }
+                }
+                indices |= best << (3 * p);
+            }
+        }
+
+        for (int i = 0; i < 6; i++)
+        {
+            block[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+        }
+    }
+
+    /**
+     * Quantizes BC7 mode 6 endpoint to 7 bits per channel and a shared parity bit, picking the closer parity
+     */
+    void QuantizeBC7Endpoint(const float color[4], uint32_t quantized[4], uint32_t& parity)
+    {
+        float bestError = 1e9f;
+        for (uint32_t p = 0; p < 2; p++)
+        {
+            uint32_t candidate[4];
+            float error = 0.0f;
+            for (int c = 0; c < 4; c++)
+            {
+                candidate[c] = static_cast<uint32_t>(std::clamp(std::lround((color[c] - static_cast<float>(p)) / 2.0f), 0L, 127L));
+                const float delta = static_cast<float>(candidate[c] * 2 + p) - color[c];
+                error += delta * delta;
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                parity = p;
+                std::copy(candidate, candidate + 4, quantized);
+            }
+        }
+    }
+
+    void EncodeBC7(const uint8_t pixels[16][4], uint8_t * block)
+    {
+        float start[4], end[4];
+        FitEndpoints(pixels, 4, start, end);
+
+        uint32_t endpoints[2][4], parity[2];
+        QuantizeBC7Endpoint(start, endpoints[0], parity[0]);
+        QuantizeBC7Endpoint(end, endpoints[1], parity[1]);
+
+        int palette[16][4];
+        for (int c = 0; c < 4; c++)
+        {
+            const int e0 = static_cast<int>(endpoints[0][c] * 2 + parity[0]);
+            const int e1 = static_cast<int>(endpoints[1][c] * 2 + parity[1]);
+            for (int i = 0; i < 16; i++)
+            {
+                palette[i][c] = ((64 - bc7Weights[i]) * e0 + bc7Weights[i] * e1 + 32) >> 6;
+            }
+        }
+
+        uint32_t indices[16];
+        for (int p = 0; p < 16; p++)
+        {
+            indices[p] = 0;
+            int bestDistance = SquaredDistance(pixels[p], palette[0], 4);
+            for (uint32_t i = 1; i < 16; i++)
+            {
+                const int distance = SquaredDistance(pixels[p], palette[i], 4);
+                if (distance < bestDistance)
+                {
+                    indices[p] = i;
+                    bestDistance = distance;
+                }
+            }
+        }
+
+        // the most significant bit of the first index is implicit zero, swapping endpoints guarantees that
+        if (indices[0] >= 8)
+        {
+            std::swap(endpoints[0], endpoints[1]);
+            std::swap(parity[0], parity[1]);
+            for (auto& index : indices)
+            {
+                index = 15 - index;
+            }
+        }
+
+        std::memset(block, 0, 16);
+        BitWriter writer { block };
+        writer.Write(1u << 6, 7);
+        for (int c = 0; c < 4; c++)
+        {
+            writer.Write(endpoints[0][c], 7);
+            writer.Write(endpoints[1][c], 7);
+        }
+        writer.Write(parity[0], 1);
+        writer.Write(parity[1], 1);
+        writer.Write(indices[0], 3);
+        for (int p = 1; p < 16; p++)
+        {
+            writer.Write(indices[p], 4);
+        }
+    }
+}
+
+std::shared_ptr<TextureData> TextureCompressor::Compress(const ImageData& image, TextureType type)
+{
+    // expanding to RGBA, grey images are replicated into all color channels
+    const size_t pixelsCount = static_cast<size_t>(image.width) * image.height;
+    std::vector<uint8_t> level(pixelsCount * 4);
+    bool hasAlpha = false;
+    for (size_t p = 0; p < pixelsCount; p++)
+    {
+        const uint8_t * source = image.pixels.get() + p * image.components;
+        uint8_t * pixel = &level[p * 4];
+        switch (image.components)
+        {
+            case 1:
+                pixel[0] = pixel[1] = pixel[2] = source[0];
+                pixel[3] = 255;
+                break;
+            case 2:
+                pixel[0] = pixel[1] = pixel[2] = source[0];
+                pixel[3] = source[1];
+                break;
+            case 3:
+                std::memcpy(pixel, source, 3);
+                pixel[3] = 255;
+                break;
+            default:
+                std::memcpy(pixel, source, 4);
+                break;
+        }
+        hasAlpha |= pixel[3] != 255;
+    }
+
+    const TextureCompression format = SelectFormat(type, hasAlpha);
+    const MipFilter filter = MipGenerator::SelectFilter(type);
+
+    auto data = std::make_shared<TextureData>();
+    data->internalFormat = GetInternalFormat(format);
+
+    int width = image.width, height = image.height;
+    while (true)
+    {
+        const size_t size = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+        data->levels.push_back({ width, height, data->storage.size(), size });
+        data->storage.resize(data->storage.size() + size);
+        CompressLevel(level.data(), width, height, format, data->storage.data() + data->levels.back().offset);
+
+        if (width == 1 && height == 1)
+        {
+            break;
+        }
+        std::vector<uint8_t> nextLevel(static_cast<size_t>(std::max(width / 2, 1)) * std::max(height / 2, 1) * 4);
+        MipGenerator::Downsample(level.data(), width, height, 4, filter, nextLevel.data());
+        level = std::move(nextLevel);
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+
+    data->pixels = data->storage.data();
+    return data;
+}
+
+void TextureCompressor::CompressLevel(const uint8_t * pixels, int width, int height, TextureCompression format, uint8_t * destination)
+{
+    const size_t blockSize = GetBlockSize(format);
+    for (int by = 0; by < height; by += 4)
+    {
+        for (int bx = 0; bx < width; bx += 4)
+        {
+            // edge blocks replicate the last row and column
+            uint8_t block[16][4];
+            for (int y = 0; y < 4; y++)
+            {
+                for (int x = 0; x < 4; x++)
+                {
+                    const int sx = std::min(bx + x, width - 1), sy = std::min(by + y, height - 1);
+                    std::memcpy(block[y * 4 + x], pixels + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+                }
+            }
+
+            uint8_t channel[16];
+            switch (format)
+            {
+                case TextureCompression::BC1:
+                    EncodeBC1(block, destination);
+                    break;
+                case TextureCompression::BC3:
+                    for (int p = 0; p < 16; p++)
+                    {
+                        channel[p] = block[p][3];
+                    }
+                    EncodeBC4(channel, destination);
+                    EncodeBC1(block, destination + 8);
+                    break;
+                case TextureCompression::BC4:
+                    for (int p = 0; p < 16; p++)
+                    {
+                        channel[p] = block[p][0];
+                    }
+                    EncodeBC4(channel, destination);
+                    break;
+                case TextureCompression::BC5:
+                    for (int c = 0; c < 2; c++)
+                    {
+                        for (int p = 0; p < 16; p++)
+                        {
+                            channel[p] = block[p][c];
+                        }
+                        EncodeBC4(channel, destination + 8 * c);
+                    }
+                    break;
+                case TextureCompression::BC7:
+                    EncodeBC7(block, destination);
+                    break;
+            }
+            destination += blockSize;
+        }
+    }
+}
+
+TextureCompression TextureCompressor::SelectFormat(TextureType type, bool hasAlpha)
+{
+    switch (type)
+    {
+        case Normal:
+            return TextureCompression::BC5;
+        case Specular:
+        case Metallic:
+        case Roughness:
+        case Translucency:
+            return TextureCompression::BC4;
+        default:
+            // S3TC is an extension, unlike BPTC, which is core since OpenGL 4.2
+            if (useBC7 || !GLEW_EXT_texture_compression_s3tc)
+            {
+                return TextureCompression::BC7;
+            }
+            return hasAlpha ? TextureCompression::BC3 : TextureCompression::BC1;
+    }
+}
+
+size_t TextureCompressor::GetBlockSize(TextureCompression format)
+{
+    return format == TextureCompression::BC1 || format == TextureCompression::BC4 ? 8 : 16;
+}
+
+unsigned int TextureCompressor::GetInternalFormat(TextureCompression format)
+{
+    switch (format)
+    {
+        case TextureCompression::BC1:
+            return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case TextureCompression::BC3:
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case TextureCompression::BC4:
+            return GL_COMPRESSED_RED_RGTC1;
+        case TextureCompression::BC5:
+            return GL_COMPRESSED_RG_RGTC2;
+        default:
+            return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef GRAPHICS_TEXTURECOMPRESSOR_H
+#define GRAPHICS_TEXTURECOMPRESSOR_H
+
+#include "Material.h"
+
+#include <memory>
+#include <cstdint>
+
+/**
+ * Block compression formats, each block encodes 4x4 pixels
+ */
+enum class TextureCompression : uint32_t
+{
+    /* RGB, 8 bytes per block, opaque color textures */
+    BC1 = 0,
+    /* RGBA, 16 bytes per block, color textures with alpha */
+    BC3 = 1,
+    /* R, 8 bytes per block, single channel textures */
+    BC4 = 2,
+    /* RG, 16 bytes per block, normal maps */
+    BC5 = 3,
+    /* RGBA, 16 bytes per block, high quality color textures */
+    BC7 = 4
+};
+
+/**
+ * CPU block compression encoder. Never touches OpenGL, so it is safe to use from the worker threads.
+ * Encoders aim for a reasonable quality at a speed acceptable for the first load: endpoints are fitted along the
+ * principal axis of the block colors, BC7 only uses the single subset mode 6
+ */
+class TextureCompressor
+{
+public:
+    /* Restriction to create an instance of this class */
+    TextureCompressor() = delete;
+    TextureCompressor(TextureCompressor&&) = delete;
+    TextureCompressor(const TextureCompressor&) = delete;
+
+    /**
+     * Compresses image and its whole mip chain
+     * @param image decoded image
+     * @param type how texture is sampled by the shaders, defines the compression format
+     * @return compressed texture data
+     */
+    static std::shared_ptr<TextureData> Compress(const ImageData& image, TextureType type);
+
+    /**
+     * @param type how texture is sampled by the shaders
+     * @param hasAlpha whether texture has non opaque pixels
+     * @return compression format to use
+     */
+    static TextureCompression SelectFormat(TextureType type, bool hasAlpha);
+
+    /**
+     * @param format compression format
+     * @return size of a single 4x4 block, in bytes
+     */
+    static size_t GetBlockSize(TextureCompression format);
+
+    /**
+     * @param format compression format
+     * @return OpenGL internal format
+     */
+    static unsigned int GetInternalFormat(TextureCompression format);
+
+    /**
+     * @return true if textures are compressed on load
+     */
+    static bool IsEnabled() { return isEnabled; }
+
+    /**
+     * Sets whether textures are compressed on load, otherwise they are uploaded uncompressed
+     * @param enabled true to compress textures
+     */
+    static void SetEnabled(bool enabled) { isEnabled = enabled; }
+
+    /**
+     * Sets whether color textures are compressed to BC7 instead of BC1/BC3. BC7 is noticeably better looking, but
+     * slower to encode
+     * @param use true to use BC7
+     */
+    static void SetUseBC7(bool use) { useBC7 = use; }
+
+private:
+    /**
+     * Compresses single RGBA8 image
+     * @param pixels image pixels, 4 bytes each
+     * @param width image width
+     * @param height image height
+     * @param format compression format
+     * @param destination output blocks, row by row
+     */
+    static void CompressLevel(const uint8_t * pixels, int width, int height, TextureCompression format, uint8_t * destination);
+
+    inline static bool isEnabled = true;
+    inline static bool useBC7 = true;
+};
+
+#endif //GRAPHICS_TEXTURECOMPRESSOR_H
@@ -0,0 +1,178 @@
+#include "TextureRegistry.h"
+#include "TextureStreamer.h"
+
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <filesystem>
+
+std::shared_ptr<Texture> TextureRegistry::Load(const std::string& path, TextureType usage, const std::shared_ptr<TextureData>& data)
+{
+    const std::string normalized = NormalizePath(path);
+
+    auto it = textures.find(normalized);
+    if (it != textures.end())
+    {
+        return it->second;
+    }
+
+    // returned right away, pixels are loaded and uploaded in the background. Only the smallest levels are loaded,
+    // the larger ones are streamed in once the renderer requests them
+    auto texture = std::make_shared<Texture>(path, usage);
+    texture->lastUsedFrame = frame;
+    TextureStreamer::Request(texture, data, std::numeric_limits<size_t>::max());
+    textures.emplace(normalized, texture);
+    return texture;
+}
+
+std::shared_ptr<Texture> TextureRegistry::Find(const std::string& path)
+{
+    auto it = textures.find(NormalizePath(path));
+    return it != textures.end() ? it->second : nullptr;
+}
+
+void TextureRegistry::Update(size_t budget)
+{
+    frame++;
+
+    memoryUsage = 0;
+    std::vector<std::shared_ptr<Texture>> candidates;
+    for (auto it = textures.begin(); it != textures.end();)
+    {
+        const auto& texture = it->second;
+        const bool isCold = frame - texture->lastUsedFrame > coldFramesCount;
+
+        // nothing references the texture, except the registry itself
+        if (isCold && texture.use_count() == 1)
+        {
+            it = textures.erase(it);
+            continue;
+        }
+
+        texture->desiredLevel = SelectLevel(* texture);
+        texture->requestedResolution = 0.0f;
+
+        memoryUsage += texture->memoryUsage;
+        if (texture->id != 0 && !texture->isStreaming)
+        {
+            candidates.push_back(texture);
+        }
+        ++it;
+    }
+
+    if (memoryUsage > budget)
+    {
+        // the coldest textures go first
+        std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b)
+        {
+            return a->lastUsedFrame < b->lastUsedFrame;
+        });
+
+        for (const auto& texture : candidates)
+        {
+            if (memoryUsage <= budget || frame - texture->lastUsedFrame <= coldFramesCount)
+            {
+                break;
+            }
+
+            memoryUsage -= texture->memoryUsage;
+            if (texture->allocatedLevel < GetLowestLevel(* texture))
+            {
+                texture->Reallocate(texture->allocatedLevel + 1);
+                memoryUsage += texture->memoryUsage;
+            }
+            else
+            {
+                texture->Evict();
+                LOG(INFO) << "Texture " << texture->GetPath() << " evicted";
+            }
+        }
+
+        // textures in use keep the levels they were requested with
+        for (const auto& texture : candidates)
+        {
+            if (memoryUsage <= budget)
+            {
+                break;
+            }
+
+            if (texture->id != 0 && texture->allocatedLevel < texture->desiredLevel)
+            {
+                memoryUsage -= texture->memoryUsage;
+                texture->Reallocate(texture->desiredLevel);
+                memoryUsage += texture->memoryUsage;
+            }
+        }
+        return;
+    }
+
+    // streaming in the levels of the textures, used during the last frame, while there is room for them
+    for (const auto& [path, texture] : textures)
+    {
+        if (texture->isStreaming || texture->GetLevelsCount() == 0 || frame - texture->lastUsedFrame > 1 ||
+            texture->desiredLevel >= texture->allocatedLevel)
+        {
+            continue;
+        }
+
+        // falling back to the smaller levels, evicted textures always get at least the smallest ones
+        size_t level = texture->desiredLevel;
+        const size_t lowestLevel = GetLowestLevel(* texture);
+        while (level < lowestLevel && memoryUsage + texture->GetMemoryUsage(level) - texture->memoryUsage > budget)
+        {
+            level++;
+        }
+
+        if (level < texture->allocatedLevel)
+        {
+            memoryUsage += texture->GetMemoryUsage(level) - texture->memoryUsage;
+            TextureStreamer::Request(texture, nullptr, level);
+        }
+    }
+}
+
+void TextureRegistry::ReleaseUnused()
+{
+    for (auto it = textures.begin(); it != textures.end();)
+    {
+        if (it->second.use_count() == 1)
+        {
+            it = textures.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+std::string TextureRegistry::NormalizePath(const std::string& path)
+{
+    std::string normalized = path;
+    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+    return std::filesystem::path(normalized).lexically_normal().generic_string();
+}
+
+size_t TextureRegistry::SelectLevel(const Texture& texture)
+{
+    // textures used without a request, like the editor icons, are shown in the full resolution
+    if (texture.requestedResolution <= 0.0f)
+    {
+        return 0;
+    }
+
+    const float ratio = static_cast<float>(std::max(texture.width, texture.height)) / texture.requestedResolution;
+    const auto level = static_cast<size_t>(std::max(std::floor(std::log2(std::max(ratio, 1.0f))), 0.0f));
+    return std::min(level, GetLowestLevel(texture));
+}
+
+size_t TextureRegistry::GetLowestLevel(const Texture& texture)
+{
+    size_t level = 0;
+    while (level + 1 < texture.GetLevelsCount() && (std::max(texture.width, texture.height) >> (level + 1)) >= minResidentSize)
+    {
+        level++;
+    }
+    return level;
+}
@@ -0,0 +1,118 @@
+#ifndef GRAPHICS_TEXTUREREGISTRY_H
+#define GRAPHICS_TEXTUREREGISTRY_H
+
+#include "Material.h"
+#include "../Core/Hash.hpp"
+
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+/**
+ * Owns all the textures loaded from the files, each one is loaded only once and found by its normalized path.
+ *
+ * Decides which mip levels of the textures are resident. Textures are loaded with their smallest levels only, the
+ * renderer requests resolution of every texture from the screen space texel density of the meshes using it, and the
+ * registry streams in the levels matching the largest request of the frame.
+ *
+ * Keeps the video memory, taken by the textures, within the budget. Every texture remembers the frame it was used
+ * last time. Once the budget is exceeded, the coldest textures are dropped to the lower mip levels one level at a
+ * time, down to the minimal resident size, and then evicted completely, then textures with levels larger than
+ * requested are dropped to the requested ones. Dropped and evicted textures are streamed back in as soon as they are
+ * requested again and there is room for them. Textures, no longer referenced by anything but the registry, are
+ * released once they go cold
+ */
+class TextureRegistry
+{
+public:
+    /* Restriction to create an instance of this class */
+    TextureRegistry() = delete;
+    TextureRegistry(TextureRegistry&&) = delete;
+    TextureRegistry(const TextureRegistry&) = delete;
+
+    /**
+     * Returns already loaded texture or creates a new one and queues it for the streaming
+     * @param path texture path
+     * @param usage how texture is sampled by the shaders
+     * @param data already loaded texture data, loaded on the thread pool if nullptr
+     * @return pointer to the texture
+     */
+    static std::shared_ptr<Texture> Load(const std::string& path, TextureType usage = Diffuse, const std::shared_ptr<TextureData>& data = nullptr);
+
+    /**
+     * @param path texture path
+     * @return loaded texture or nullptr, if there is no texture with such a path
+     */
+    static std::shared_ptr<Texture> Find(const std::string& path);
+
+    /**
+     * Releases cold textures and keeps the resident ones within the budget, must be called once per frame on the
+     * main thread
+     * @param budget maximum video memory taken by the textures, in bytes
+     */
+    static void Update(size_t budget);
+
+    /**
+     * Releases all textures, unused by materials, no matter how recently they were used
+     */
+    static void ReleaseUnused();
+
+    /**
+     * Releases all textures, must be called before the OpenGL context is destroyed
+     */
+    static void ShutDown() { textures.clear(); }
+
+    /**
+     * Makes path separators uniform and resolves "." and ".." entries, so different spellings of the same path match
+     * @param path path to normalize
+     * @return normalized path
+     */
+    static std::string NormalizePath(const std::string& path);
+
+    /**
+     * @return index of the current frame, incremented on each update
+     */
+    static uint64_t GetFrame() { return frame; }
+
+    /**
+     * @return video memory taken by the resident texture levels, in bytes
+     */
+    static size_t GetMemoryUsage() { return memoryUsage; }
+
+    /**
+     * @return all loaded textures, by their normalized paths
+     */
+    static const auto& GetTextures() { return textures; }
+
+    /**
+     * @param texture texture
+     * @return smallest level, which is always kept resident until texture is evicted
+     */
+    static size_t GetLowestLevel(const Texture& texture);
+
+private:
+    struct PathHash
+    {
+        size_t operator()(const std::string& path) const { return static_cast<size_t>(Hash::Fnv1a(path)); }
+    };
+
+    /**
+     * Converts resolution requested during the last frame into the level, which matches it best
+     * @param texture texture
+     * @return desired level
+     */
+    static size_t SelectLevel(const Texture& texture);
+
+    /* Frames since the last use, after which texture is considered cold */
+    static constexpr uint64_t coldFramesCount = 300;
+
+    /* Textures are never dropped to the levels smaller than this size, in pixels, they are loaded with */
+    static constexpr int minResidentSize = 64;
+
+    inline static uint64_t frame = 1;
+    inline static size_t memoryUsage = 0;
+    inline static std::unordered_map<std::string, std::shared_ptr<Texture>, PathHash> textures;
+};
+
+#endif //GRAPHICS_TEXTUREREGISTRY_H
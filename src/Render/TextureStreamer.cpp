@@ -0,0 +1,203 @@
+#include "TextureStreamer.h"
+#include "TextureRegistry.h"
+#include "../Core/Profiler.hpp"
+#include "../Core/ThreadPool.hpp"
+
+#include <chrono>
+#include <algorithm>
+
+void TextureStreamer::Initialize()
+{
+    for (auto& staging : stagingBuffers)
+    {
+        glGenBuffers(1, &staging.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(stagingBufferSize), nullptr, GL_STREAM_DRAW);
+        staging.fence = nullptr;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    isInitialized = true;
+}
+
+void TextureStreamer::Request(const std::shared_ptr<Texture>& texture, const std::shared_ptr<TextureData>& data, size_t targetLevel)
+{
+    Job job;
+    job.texture = texture;
+    job.targetLevel = targetLevel;
+
+    texture->isStreaming = true;
+
+    if (data)
+    {
+        std::promise<std::shared_ptr<TextureData>> loaded;
+        loaded.set_value(data);
+        job.data = loaded.get_future().share();
+    }
+    else
+    {
+        job.data = ThreadPool::Submit([path = texture->GetPath(), usage = texture->GetUsage()]() -> std::shared_ptr<TextureData>
+        {
+            try
+            {
+                return Texture::LoadData(path, usage);
+            }
+            catch (const std::exception& e)
+            {
+                LOG(WARNING) << "Failed to decode texture " << path << ", placeholder is kept instead. Reason: " << e.what();
+                return nullptr;
+            }
+        }).share();
+    }
+
+    jobs.push_back(std::move(job));
+}
+
+void TextureStreamer::Update(size_t budget)
+{
+    Profiler::textureBytesUploaded = 0;
+
+    if (!isInitialized && !jobs.empty())
+    {
+        Initialize();
+    }
+
+    // uploads are done in the request order, textures still being loaded are skipped
+    for (auto it = jobs.begin(); it != jobs.end() && budget > 0;)
+    {
+        auto texture = it->texture.lock();
+        if (!texture)
+        {
+            // texture was released before it was uploaded
+            it = jobs.erase(it);
+            continue;
+        }
+
+        if (it->data.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++it;
+            continue;
+        }
+
+        const auto& data = it->data.get();
+        if (!data)
+        {
+            texture->FinishStreaming();
+            it = jobs.erase(it);
+            continue;
+        }
+
+        if (!it->isAllocated)
+        {
+            texture->Initialize(* data);
+
+            // the smallest levels are always kept, so the texture never drops to the placeholder once it is loaded
+            it->targetLevel = std::min(it->targetLevel, TextureRegistry::GetLowestLevel(* texture));
+            if (texture->id == 0 || it->targetLevel < texture->allocatedLevel)
+            {
+                texture->Reallocate(it->targetLevel);
+            }
+            it->level = texture->residentLevel - 1;
+            it->isAllocated = true;
+        }
+
+        if (texture->residentLevel > it->targetLevel && !UploadRows(* it, * texture, * data, budget))
+        {
+            break;
+        }
+
+        if (texture->residentLevel <= it->targetLevel)
+        {
+            texture->FinishStreaming();
+            it = jobs.erase(it);
+        }
+    }
+
+    Profiler::texturesPending = jobs.size();
+}
+
+bool TextureStreamer::UploadRows(Job& job, Texture& texture, const TextureData& data, size_t& budget)
+{
+    auto& staging = stagingBuffers[currentStagingBuffer];
+    if (staging.fence != nullptr)
+    {
+        // never waiting for the GPU, the rest is uploaded on the next frames
+        if (glClientWaitSync(staging.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            return false;
+        }
+        glDeleteSync(staging.fence);
+        staging.fence = nullptr;
+    }
+
+    const auto& level = data.levels[job.level];
+    const int rowsCount = data.IsCompressed() ? (level.height + 3) / 4 : level.height;
+    const size_t rowSize = level.size / static_cast<size_t>(rowsCount);
+    ASSERT(rowSize <= stagingBufferSize, "Texture " + texture.GetPath() + " row does not fit into the staging buffer");
+
+    // at least a single row is uploaded, so even the tiny budgets make progress
+    const size_t rows = std::min({ static_cast<size_t>(rowsCount - job.uploadedRows), stagingBufferSize / rowSize, std::max<size_t>(budget / rowSize, 1) });
+    const size_t size = rows * rowSize;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer);
+
+    // the fence guarantees GPU is no longer reading this buffer, so no implicit synchronization is needed
+    void * destination = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size),
+                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    std::memcpy(destination, data.pixels + level.offset + job.uploadedRows * rowSize, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    const auto mipLevel = static_cast<GLint>(job.level - texture.allocatedLevel);
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    if (data.IsCompressed())
+    {
+        const int y = job.uploadedRows * 4;
+        const int height = std::min(static_cast<int>(rows) * 4, level.height - y);
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, mipLevel, 0, y, level.width, height, data.internalFormat, static_cast<GLsizei>(size), nullptr);
+    }
+    else
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, mipLevel, 0, job.uploadedRows, level.width, static_cast<GLsizei>(rows), data.pixelFormat, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    staging.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    currentStagingBuffer = (currentStagingBuffer + 1) % stagingBuffersCount;
+
+    job.uploadedRows += static_cast<int>(rows);
+    if (job.uploadedRows == rowsCount)
+    {
+        // levels are uploaded from the smallest one, so the uploaded chain is always complete
+        texture.SetResidentLevel(job.level);
+        job.level--;
+        job.uploadedRows = 0;
+    }
+    budget -= std::min(budget, size);
+    Profiler::textureBytesUploaded += size;
+    return true;
+}
+
+void TextureStreamer::ShutDown()
+{
+    jobs.clear();
+    Texture::DeletePlaceholder();
+
+    if (!isInitialized)
+    {
+        return;
+    }
+
+    for (auto& staging : stagingBuffers)
+    {
+        if (staging.fence != nullptr)
+        {
+            glDeleteSync(staging.fence);
+        }
+        glDeleteBuffers(1, &staging.buffer);
+        staging = StagingBuffer();
+    }
+    isInitialized = false;
+}
@@ -0,0 +1,98 @@
+#ifndef GRAPHICS_TEXTURESTREAMER_H
+#define GRAPHICS_TEXTURESTREAMER_H
+
+#define GLEW_STATIC
+#include "glew.h"
+
+#include "Material.h"
+
+#include <deque>
+#include <future>
+#include <memory>
+
+/**
+ * Streams textures into the GPU without stalling the frame. Texture data is loaded (read from the texture cache, or
+ * decoded and compressed) on the thread pool, then uploaded a few rows (or rows of blocks) at a time through a ring of
+ * pixel buffer objects, never exceeding the per frame byte budget. Levels are uploaded from the smallest one up to the
+ * requested one, texture becomes resident as soon as its smallest level is uploaded and its sampling is clamped to the
+ * largest uploaded level, so quality converges while the rest is streamed in. Until then a placeholder is bound in
+ * its place
+ */
+class TextureStreamer
+{
+public:
+    /* Restriction to create an instance of this class */
+    TextureStreamer() = delete;
+    TextureStreamer(TextureStreamer&&) = delete;
+    TextureStreamer(const TextureStreamer&) = delete;
+
+    /**
+     * Queues texture for the upload. Texture keeps its current levels, only the missing ones are uploaded
+     * @param texture texture to stream the pixels into
+     * @param data already loaded texture data, loaded on the thread pool if nullptr
+     * @param targetLevel largest level to upload, clamped to the smallest resident level of the texture
+     */
+    static void Request(const std::shared_ptr<Texture>& texture, const std::shared_ptr<TextureData>& data = nullptr, size_t targetLevel = 0);
+
+    /**
+     * Uploads decoded images, must be called once per frame on the main thread
+     * @param budget maximum number of bytes uploaded during this call
+     */
+    static void Update(size_t budget);
+
+    /**
+     * @return number of textures, that are still being decoded or uploaded
+     */
+    static size_t GetPendingCount() { return jobs.size(); }
+
+    /**
+     * Deletes staging buffers and drops unfinished uploads, must be called before the OpenGL context is destroyed
+     */
+    static void ShutDown();
+
+private:
+    struct Job
+    {
+        std::weak_ptr<Texture> texture;
+        std::shared_future<std::shared_ptr<TextureData>> data;
+
+        /* Whether texture storage is created, largest level to upload, level being uploaded and its rows already copied */
+        bool isAllocated = false;
+        size_t targetLevel = 0;
+        size_t level = 0;
+        int uploadedRows = 0;
+    };
+
+    struct StagingBuffer
+    {
+        unsigned int buffer;
+
+        /* Signaled once the GPU has consumed the buffer contents */
+        GLsync fence;
+    };
+
+    static void Initialize();
+
+    /**
+     * Copies next rows of the current level through the staging buffer. Rows of the compressed levels are rows of
+     * the 4x4 blocks
+     * @param job upload to continue
+     * @param texture texture of the job
+     * @param data texture data
+     * @param budget remaining budget of this frame, decreased by the uploaded bytes
+     * @return false if no staging buffer is free yet, so uploads have to wait for the next frame
+     */
+    static bool UploadRows(Job& job, Texture& texture, const TextureData& data, size_t& budget);
+
+    /* Staging buffers are reused in a ring, each one is only written once the GPU is done reading it */
+    static constexpr int stagingBuffersCount = 3;
+    static constexpr size_t stagingBufferSize = 4 * 1024 * 1024;
+
+    inline static bool isInitialized = false;
+    inline static int currentStagingBuffer = 0;
+    inline static StagingBuffer stagingBuffers[stagingBuffersCount] {};
+
+    inline static std::deque<Job> jobs;
+};
+
+#endif //GRAPHICS_TEXTURESTREAMER_H
@@ -0,0 +1,210 @@
+#define GLEW_STATIC
+#include "glew.h"
+
+#include "VertexLayout.h"
+
+#include <glm/packing.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+    /**
+     * Packs unit vector into the signed normalized 10-10-10-2 format
+     */
+    uint32_t PackUnitVector(const glm::vec3& v, float w)
+    {
+        float length = glm::length(v);
+        glm::vec3 n = length > 0.0f ? v / length : glm::vec3(0.0f);
+        return glm::packSnorm3x10_1x2(glm::vec4(n, w));
+    }
+
+    /**
+     * Fills common part of the vertex: position, normal, tangent frame and texture coordinates
+     */
+    template<typename T>
+    void PackCommon(T& packed, const Vertex& vertex)
+    {
+        packed.position = vertex.Position;
+
+        glm::vec3 normal = vertex.Normal;
+        glm::vec3 tangent = vertex.Tangent;
+
+        // meshes without texture coordinates have no tangents, any vector orthogonal to the normal does the job
+        if (glm::dot(tangent, tangent) < 1e-12f)
+        {
+            tangent = glm::abs(normal.x) < 0.9f ? glm::cross(normal, glm::vec3(1, 0, 0)) : glm::cross(normal, glm::vec3(0, 1, 0));
+        }
+
+        // bitangent is reconstructed in the shader as cross(N, T) * sign, only handedness has to be stored
+        float handedness = glm::dot(glm::cross(normal, tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f;
+
+        packed.normal = PackUnitVector(normal, 0.0f);
+        packed.tangent = PackUnitVector(tangent, handedness);
+        packed.texCoords = glm::packHalf2x16(vertex.TexCoords);
+    }
+
+    /**
+     * Quantizes bone weights to 8 bits, keeping their sum exactly 255
+     */
+    void PackWeights(SkinnedVertex& packed, const Vertex& vertex)
+    {
+        float total = 0.0f;
+        for (float weight : vertex.m_Weights)
+        {
+            total += std::max(weight, 0.0f);
+        }
+
+        int sum = 0;
+        int heaviest = 0;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            float weight = total > 0.0f ? std::max(vertex.m_Weights[i], 0.0f) / total : (i == 0 ? 1.0f : 0.0f);
+            packed.weights[i] = static_cast<uint8_t>(std::lround(weight * 255.0f));
+            packed.boneIds[i] = static_cast<uint8_t>(std::clamp(vertex.m_BoneIDs[i], 0, 255));
+
+            sum += packed.weights[i];
+            heaviest = packed.weights[i] > packed.weights[heaviest] ? i : heaviest;
+        }
+
+        // rounding error goes to the most influential bone
+        packed.weights[heaviest] = static_cast<uint8_t>(packed.weights[heaviest] + 255 - sum);
+    }
+}
+
+size_t VertexLayout::GetSize(VertexFormat format)
+{
+    switch (format)
+    {
+        case VertexFormat::Static:
+            return sizeof(StaticVertex);
+        case VertexFormat::Skinned:
+            return sizeof(SkinnedVertex);
+    }
+    return 0;
+}
+
+bool VertexLayout::IsValid(VertexFormat format)
+{
+    return format == VertexFormat::Static || format == VertexFormat::Skinned;
+}
+
+size_t VertexLayout::GetIndexSize(IndexFormat format)
+{
+    return format == IndexFormat::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+unsigned int VertexLayout::GetIndexType(IndexFormat format)
+{
+    return format == IndexFormat::UInt16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+bool VertexLayout::IsValid(IndexFormat format)
+{
+    return format == IndexFormat::UInt16 || format == IndexFormat::UInt32;
+}
+
+IndexFormat VertexLayout::SelectIndexFormat(size_t verticesCount)
+{
+    return verticesCount < 65536 ? IndexFormat::UInt16 : IndexFormat::UInt32;
+}
+
+std::vector<uint8_t> VertexLayout::PackIndices(const unsigned int * indices, size_t count, IndexFormat format)
+{
+    std::vector<uint8_t> data(count * GetIndexSize(format));
+
+    if (format == IndexFormat::UInt16)
+    {
+        auto * packed = reinterpret_cast<uint16_t *>(data.data());
+        for (size_t i = 0; i < count; i++)
+        {
+            packed[i] = static_cast<uint16_t>(indices[i]);
+        }
+    }
+    else
+    {
+        std::memcpy(data.data(), indices, count * sizeof(unsigned int));
+    }
+
+    return data;
+}
+
+std::vector<uint8_t> VertexLayout::Pack(const Vertex * vertices, size_t count, VertexFormat format)
+{
+    std::vector<uint8_t> data(count * GetSize(format));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (format == VertexFormat::Skinned)
+        {
+            SkinnedVertex packed {};
+            PackCommon(packed, vertices[i]);
+            PackWeights(packed, vertices[i]);
+            std::memcpy(data.data() + i * sizeof(packed), &packed, sizeof(packed));
+        }
+        else
+        {
+            StaticVertex packed {};
+            PackCommon(packed, vertices[i]);
+            std::memcpy(data.data() + i * sizeof(packed), &packed, sizeof(packed));
+        }
+    }
+
+    return data;
+}
+
+std::vector<glm::vec3> VertexLayout::ExtractDepthPositions(const uint8_t * data, size_t count, VertexFormat format)
+{
+    const size_t stride = GetSize(format);
+    std::vector<glm::vec3> positions(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        // position and normal are at the same offsets in every format
+        const uint8_t * vertex = data + i * stride;
+        float position[3];
+        uint32_t normal;
+        std::memcpy(position, vertex + offsetof(StaticVertex, position), sizeof(position));
+        std::memcpy(&normal, vertex + offsetof(StaticVertex, normal), sizeof(normal));
+        positions[i] = glm::vec3(position[0], position[1], position[2]) - depthNormalOffset * glm::vec3(glm::unpackSnorm3x10_1x2(normal));
+    }
+
+    return positions;
+}
+
+void VertexLayout::SetUpAttributes(VertexFormat format)
+{
+    // common part of the static and skinned layouts is identical; all attributes read from the vertex buffer binding 0
+    auto attribute = [](unsigned int location)
+    {
+        glEnableVertexAttribArray(location);
+        glVertexAttribBinding(location, 0);
+    };
+
+    // vertex positions
+    attribute(0);
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(StaticVertex, position));
+    // vertex normals, decoded to [-1, 1] by the vertex fetch
+    attribute(1);
+    glVertexAttribFormat(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(StaticVertex, normal));
+    // vertex texture coords
+    attribute(2);
+    glVertexAttribFormat(2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(StaticVertex, texCoords));
+    // vertex tangent and bitangent sign
+    attribute(3);
+    glVertexAttribFormat(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(StaticVertex, tangent));
+
+    if (format == VertexFormat::Skinned)
+    {
+        // ids
+        attribute(5);
+        glVertexAttribIFormat(5, 4, GL_UNSIGNED_BYTE, offsetof(SkinnedVertex, boneIds));
+        // weights
+        attribute(6);
+        glVertexAttribFormat(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(SkinnedVertex, weights));
+    }
+}
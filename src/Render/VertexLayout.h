@@ -0,0 +1,174 @@
+#ifndef GRAPHICS_VERTEXLAYOUT_H
+#define GRAPHICS_VERTEXLAYOUT_H
+
+#include "glm/glm.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+constexpr int MAX_BONE_INFLUENCE = 4;
+
+/**
+ * Full precision vertex, produced by the importer. Never uploaded to the GPU as is, see VertexLayout::Pack
+ */
+struct Vertex
+{
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+
+    glm::vec3 Tangent;
+    glm::vec3 Bitangent;
+
+    int m_BoneIDs[MAX_BONE_INFLUENCE];
+    float m_Weights[MAX_BONE_INFLUENCE];
+};
+
+/**
+ * Vertex layouts, meshes can be stored in
+ */
+enum class VertexFormat : uint32_t
+{
+    /* Position, normal, tangent frame, texture coordinates */
+    Static  = 0,
+    /* Static layout plus bone ids and weights */
+    Skinned = 1,
+};
+
+/**
+ * Index buffer element types
+ */
+enum class IndexFormat : uint32_t
+{
+    UInt16 = 0,
+    UInt32 = 1,
+};
+
+/**
+ * Static mesh vertex, 24 bytes
+ */
+struct StaticVertex
+{
+    glm::vec3 position;
+    /* Normal, signed normalized 10-10-10-2 */
+    uint32_t normal;
+    /* Tangent, signed normalized 10-10-10-2, w is the bitangent sign */
+    uint32_t tangent;
+    /* Texture coordinates, two half floats */
+    uint32_t texCoords;
+};
+
+/**
+ * Skinned mesh vertex, 32 bytes
+ */
+struct SkinnedVertex
+{
+    glm::vec3 position;
+    uint32_t normal;
+    uint32_t tangent;
+    uint32_t texCoords;
+
+    uint8_t boneIds[MAX_BONE_INFLUENCE];
+    /* Bone weights, unsigned normalized, sum up to 255 */
+    uint8_t weights[MAX_BONE_INFLUENCE];
+};
+
+static_assert(sizeof(StaticVertex) == 24, "Unexpected static vertex size");
+static_assert(sizeof(SkinnedVertex) == 32, "Unexpected skinned vertex size");
+
+/**
+ * Conversion of the imported vertices into the compact GPU layouts and the vertex attributes setup.
+ *
+ * Attribute locations are shared by all the layouts:
+ *  0 - position, vec3
+ *  1 - normal, vec3
+ *  2 - texture coordinates, vec2
+ *  3 - tangent, vec4, w is the bitangent sign
+ *  5 - bone ids, uvec4 (skinned only)
+ *  6 - bone weights, vec4 (skinned only)
+ */
+class VertexLayout
+{
+public:
+    /* Restriction to create an instance of this class */
+    VertexLayout() = delete;
+    VertexLayout(VertexLayout&&) = delete;
+    VertexLayout(const VertexLayout&) = delete;
+
+    /**
+     * @param format vertex format
+     * @return size of a single vertex, in bytes
+     */
+    static size_t GetSize(VertexFormat format);
+
+    /**
+     * @param format vertex format
+     * @return false if value does not name any known format (e.g. read from a corrupted file)
+     */
+    static bool IsValid(VertexFormat format);
+
+    /**
+     * @param format index format
+     * @return size of a single index, in bytes
+     */
+    static size_t GetIndexSize(IndexFormat format);
+
+    /**
+     * @param format index format
+     * @return OpenGL type of the index, to be passed into the draw calls
+     */
+    static unsigned int GetIndexType(IndexFormat format);
+
+    /**
+     * @param format index format
+     * @return false if value does not name any known format
+     */
+    static bool IsValid(IndexFormat format);
+
+    /**
+     * @param verticesCount number of mesh vertices
+     * @return smallest index format, able to address all the vertices
+     */
+    static IndexFormat SelectIndexFormat(size_t verticesCount);
+
+    /**
+     * Packs indices into the given format
+     * @param indices indices
+     * @param count number of indices
+     * @param format target format, must be able to address all the indices
+     * @return packed index data
+     */
+    static std::vector<uint8_t> PackIndices(const unsigned int * indices, size_t count, IndexFormat format);
+
+    /**
+     * Packs vertices into the given format
+     * @param vertices full precision vertices
+     * @param count number of vertices
+     * @param format target format
+     * @return packed vertex data
+     */
+    static std::vector<uint8_t> Pack(const Vertex * vertices, size_t count, VertexFormat format);
+
+    /**
+     * Extracts tightly packed positions for the depth only passes. Shadow bias offset along the normal is baked in,
+     * so shadow.vs.glsl produces the same depth from both the full and the position only stream
+     * @param data packed vertex data
+     * @param count number of vertices
+     * @param format vertex format
+     * @return positions, moved along the inverted normal by depthNormalOffset
+     */
+    static std::vector<glm::vec3> ExtractDepthPositions(const uint8_t * data, size_t count, VertexFormat format);
+
+    /**
+     * Enables and sets up vertex attributes of the format for the currently bound VAO. Attributes read from the vertex
+     * buffer binding 0, the buffer itself is attached separately with glBindVertexBuffer
+     * @param format vertex format
+     */
+    static void SetUpAttributes(VertexFormat format);
+
+    /* Normal offset of the shadow casters, must match the one in shadow.vs.glsl */
+    static constexpr float depthNormalOffset = 0.005f;
+};
+
+#endif //GRAPHICS_VERTEXLAYOUT_H